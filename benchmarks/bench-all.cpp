@@ -4,4 +4,7 @@
 #include "bench-qselect.hpp"
 #include "bench-qsort.hpp"
 #include "bench-keyvalue.hpp"
+#include "bench-merge.hpp"
 #include "bench-objsort.hpp"
+#include "bench-stablesort.hpp"
+#include "bench-file.hpp"
@@ -45,6 +45,54 @@ static void simdargsort(benchmark::State &state, Args &&...args)
     }
 }
 
+template <typename T, class... Args>
+static void simdargsort_into(benchmark::State &state, Args &&...args)
+{
+    // get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<size_t> inx(arrsize);
+    // benchmark: no allocation, the buffer is reused
+    for (auto _ : state) {
+        x86simdsort::argsort(arr.data(), inx.data(), arrsize);
+    }
+}
+
+template <typename T, class... Args>
+static void simdargsort_uint32(benchmark::State &state, Args &&...args)
+{
+    // get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<uint32_t> inx(arrsize);
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::argsort(arr.data(), inx.data(), arrsize);
+    }
+}
+
+template <typename T, class... Args>
+static void simdparallelargsort(benchmark::State &state, Args &&...args)
+{
+    // get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<size_t> inx;
+    // benchmark: uses all the hardware threads
+    for (auto _ : state) {
+        inx = x86simdsort::argsort_parallel(arr.data(), arrsize);
+    }
+}
+
 template <typename T, class... Args>
 static void simd_ordern_argsort(benchmark::State &state, Args &&...args)
 {
@@ -68,6 +116,9 @@ static void simd_ordern_argsort(benchmark::State &state, Args &&...args)
 
 #define BENCH_BOTH(type) \
     BENCH_SORT(simdargsort, type) \
+    BENCH_SORT(simdargsort_into, type) \
+    BENCH_SORT(simdargsort_uint32, type) \
+    BENCH_SORT(simdparallelargsort, type) \
     BENCH_SORT(simd_ordern_argsort, type) \
     BENCH_SORT(scalarargsort, type)
 
@@ -77,3 +128,27 @@ BENCH_BOTH(double)
 BENCH_BOTH(int32_t)
 BENCH_BOTH(uint32_t)
 BENCH_BOTH(float)
+BENCH_BOTH(int16_t)
+BENCH_BOTH(uint16_t)
+
+/*
+ * Large 32-bit argsorts: the vector returning argsort and the uint32_t
+ * indices partition the keys 16 at a time on AVX-512, the size_t buffer 8
+ * at a time
+ */
+#define BENCH_ARGSORT_LARGE(func, type) \
+    MY_BENCHMARK_CAPTURE( \
+            func, type, smallrange_1m, 1000000, std::string("smallrange")); \
+    MY_BENCHMARK_CAPTURE( \
+            func, type, smallrange_10m, 10000000, std::string("smallrange")); \
+    MY_BENCHMARK_CAPTURE(func, \
+                         type, \
+                         smallrange_100m, \
+                         100000000, \
+                         std::string("smallrange"));
+
+BENCH_ARGSORT_LARGE(simdargsort, float)
+BENCH_ARGSORT_LARGE(simdargsort_into, float)
+BENCH_ARGSORT_LARGE(simdargsort_uint32, float)
+BENCH_ARGSORT_LARGE(simdargsort, int32_t)
+BENCH_ARGSORT_LARGE(simdargsort_uint32, int32_t)
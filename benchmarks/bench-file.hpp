@@ -0,0 +1,89 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Sort of a file in the page cache: mmap_qsort against reading the file into
+ * memory, sorting it and writing it back. Both are synced to disk.
+ */
+static int open_sort_file(std::string &path)
+{
+    const char *tmpdir = std::getenv("TMPDIR");
+    path = std::string(tmpdir ? tmpdir : "/tmp") + "/xss-bench-file-XXXXXX";
+    int fd = mkstemp(path.data());
+    if (fd < 0) { std::abort(); }
+    return fd;
+}
+
+template <typename T>
+static void restore_sort_file(int fd, const std::vector<T> &arr)
+{
+    if (pwrite(fd, arr.data(), arr.size() * sizeof(T), 0) < 0
+        || fsync(fd) != 0) {
+        std::abort();
+    }
+}
+
+template <typename T, class... Args>
+static void readsortfile(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up file
+    std::vector<T> arr_bkp = get_array<T>(arrtype, arrsize);
+    std::string path;
+    int fd = open_sort_file(path);
+    std::vector<T> arr(arrsize);
+    // benchmark
+    for (auto _ : state) {
+        state.PauseTiming();
+        restore_sort_file(fd, arr_bkp);
+        state.ResumeTiming();
+        if (pread(fd, arr.data(), arrsize * sizeof(T), 0) < 0) {
+            std::abort();
+        }
+        x86simdsort::qsort(arr.data(), arrsize);
+        if (pwrite(fd, arr.data(), arrsize * sizeof(T), 0) < 0
+            || fsync(fd) != 0) {
+            std::abort();
+        }
+    }
+    close(fd);
+    unlink(path.c_str());
+}
+
+template <typename T, class... Args>
+static void mmapsortfile(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up file
+    std::vector<T> arr_bkp = get_array<T>(arrtype, arrsize);
+    std::string path;
+    int fd = open_sort_file(path);
+    // benchmark
+    for (auto _ : state) {
+        state.PauseTiming();
+        restore_sort_file(fd, arr_bkp);
+        state.ResumeTiming();
+        if (!x86simdsort::mmap_qsort<T>(path.c_str())) { std::abort(); }
+    }
+    close(fd);
+    unlink(path.c_str());
+}
+
+#define BENCH_BOTH_FILE_SORT(type) \
+    MY_BENCHMARK_CAPTURE( \
+            mmapsortfile, type, random_10m, 10000000, std::string("random")); \
+    MY_BENCHMARK_CAPTURE( \
+            readsortfile, type, random_10m, 10000000, std::string("random"));
+
+BENCH_BOTH_FILE_SORT(uint64_t)
+BENCH_BOTH_FILE_SORT(int64_t)
+BENCH_BOTH_FILE_SORT(double)
+BENCH_BOTH_FILE_SORT(uint32_t)
+BENCH_BOTH_FILE_SORT(int32_t)
+BENCH_BOTH_FILE_SORT(float)
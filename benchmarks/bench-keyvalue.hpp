@@ -39,13 +39,76 @@ static void simdkvsort(benchmark::State &state, Args &&...args)
     }
 }
 
+template <typename T, class... Args>
+static void simdparallelkvsort(benchmark::State &state, Args &&...args)
+{
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    unsigned nthreads = std::get<2>(args_tuple);
+    // set up array
+    std::vector<T> key = get_array<T>(arrtype, arrsize);
+    std::vector<T> val = get_array<T>("random", arrsize);
+    std::vector<T> key_bkp = key;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::keyvalue_qsort_parallel(
+                key.data(), val.data(), arrsize, false, nthreads);
+        state.PauseTiming();
+        key = key_bkp;
+        state.ResumeTiming();
+    }
+}
+
 #define BENCH_BOTH_KVSORT(type) \
     BENCH_SORT(simdkvsort, type) \
     BENCH_SORT(scalarkvsort, type)
 
+/* Thread scaling of the multi-threaded key-value sort on 10M elements */
+#define BENCH_PARALLEL_KVSORT(type) \
+    MY_BENCHMARK_CAPTURE(simdparallelkvsort, \
+                         type, \
+                         random_10m_1t, \
+                         10000000, \
+                         std::string("random"), \
+                         1u); \
+    MY_BENCHMARK_CAPTURE(simdparallelkvsort, \
+                         type, \
+                         random_10m_2t, \
+                         10000000, \
+                         std::string("random"), \
+                         2u); \
+    MY_BENCHMARK_CAPTURE(simdparallelkvsort, \
+                         type, \
+                         random_10m_4t, \
+                         10000000, \
+                         std::string("random"), \
+                         4u); \
+    MY_BENCHMARK_CAPTURE(simdparallelkvsort, \
+                         type, \
+                         random_10m_8t, \
+                         10000000, \
+                         std::string("random"), \
+                         8u); \
+    MY_BENCHMARK_CAPTURE(simdparallelkvsort, \
+                         type, \
+                         random_10m_16t, \
+                         10000000, \
+                         std::string("random"), \
+                         16u);
+
 BENCH_BOTH_KVSORT(uint64_t)
 BENCH_BOTH_KVSORT(int64_t)
 BENCH_BOTH_KVSORT(double)
 BENCH_BOTH_KVSORT(uint32_t)
 BENCH_BOTH_KVSORT(int32_t)
 BENCH_BOTH_KVSORT(float)
+BENCH_BOTH_KVSORT(uint16_t)
+BENCH_BOTH_KVSORT(int16_t)
+
+BENCH_PARALLEL_KVSORT(uint64_t)
+BENCH_PARALLEL_KVSORT(int64_t)
+BENCH_PARALLEL_KVSORT(double)
+BENCH_PARALLEL_KVSORT(uint32_t)
+BENCH_PARALLEL_KVSORT(int32_t)
+BENCH_PARALLEL_KVSORT(float)
@@ -0,0 +1,217 @@
+/*
+ * Merge of the two sorted halves of an array: get_array with the same seed
+ * would return the same two arrays, whose merge is perfectly predictable
+ */
+template <typename T>
+static void get_merge_inputs(size_t arrsize,
+                             std::string arrtype,
+                             std::vector<T> &a,
+                             std::vector<T> &b)
+{
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    a.assign(arr.begin(), arr.begin() + arrsize / 2);
+    b.assign(arr.begin() + arrsize / 2, arr.end());
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+}
+
+template <typename T, class... Args>
+static void scalarmerge(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up arrays
+    std::vector<T> a, b, out(arrsize);
+    get_merge_inputs(arrsize, arrtype, a, b);
+    // benchmark
+    for (auto _ : state) {
+        std::merge(a.begin(), a.end(), b.begin(), b.end(), out.begin());
+    }
+    state.SetBytesProcessed(state.iterations() * arrsize * sizeof(T));
+}
+
+template <typename T, class... Args>
+static void simdmerge(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up arrays
+    std::vector<T> a, b, out(arrsize);
+    get_merge_inputs(arrsize, arrtype, a, b);
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::merge(
+                a.data(), a.size(), b.data(), b.size(), out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * arrsize * sizeof(T));
+}
+
+template <typename T, class... Args>
+static void scalarkvmerge(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up arrays
+    std::vector<T> akey, bkey, outkey(arrsize), outval(arrsize);
+    get_merge_inputs(arrsize, arrtype, akey, bkey);
+    std::vector<T> aval = get_array<T>("random", akey.size());
+    std::vector<T> bval = get_array<T>("random", bkey.size());
+    // benchmark
+    for (auto _ : state) {
+        xss::scalar::keyvalue_merge(akey.data(),
+                                    aval.data(),
+                                    akey.size(),
+                                    bkey.data(),
+                                    bval.data(),
+                                    bkey.size(),
+                                    outkey.data(),
+                                    outval.data());
+    }
+    state.SetBytesProcessed(state.iterations() * arrsize * 2 * sizeof(T));
+}
+
+template <typename T, class... Args>
+static void simdkvmerge(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up arrays
+    std::vector<T> akey, bkey, outkey(arrsize), outval(arrsize);
+    get_merge_inputs(arrsize, arrtype, akey, bkey);
+    std::vector<T> aval = get_array<T>("random", akey.size());
+    std::vector<T> bval = get_array<T>("random", bkey.size());
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::keyvalue_merge(akey.data(),
+                                    aval.data(),
+                                    akey.size(),
+                                    bkey.data(),
+                                    bval.data(),
+                                    bkey.size(),
+                                    outkey.data(),
+                                    outval.data());
+    }
+    state.SetBytesProcessed(state.iterations() * arrsize * 2 * sizeof(T));
+}
+
+/*
+ * k-way merge of the sorted k parts of an array
+ */
+template <typename T>
+static void get_kway_inputs(size_t arrsize,
+                            std::string arrtype,
+                            size_t k,
+                            std::vector<T> &arr,
+                            std::vector<const T *> &runs,
+                            std::vector<size_t> &sizes)
+{
+    arr = get_array<T>(arrtype, arrsize);
+    for (size_t i = 0; i < k; ++i) {
+        size_t start = arrsize * i / k, end = arrsize * (i + 1) / k;
+        std::sort(arr.begin() + start, arr.begin() + end);
+        runs.push_back(arr.data() + start);
+        sizes.push_back(end - start);
+    }
+}
+
+template <typename T, class... Args>
+static void scalarkwaymerge(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    size_t k = std::get<2>(args_tuple);
+    // set up arrays
+    std::vector<T> arr, out(arrsize);
+    std::vector<const T *> runs;
+    std::vector<size_t> sizes;
+    get_kway_inputs(arrsize, arrtype, k, arr, runs, sizes);
+    // benchmark
+    for (auto _ : state) {
+        xss::scalar::kway_merge(runs.data(), sizes.data(), k, out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * arrsize * sizeof(T));
+}
+
+template <typename T, class... Args>
+static void simdkwaymerge(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    size_t k = std::get<2>(args_tuple);
+    // set up arrays
+    std::vector<T> arr, out(arrsize);
+    std::vector<const T *> runs;
+    std::vector<size_t> sizes;
+    get_kway_inputs(arrsize, arrtype, k, arr, runs, sizes);
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::kway_merge(runs.data(), sizes.data(), k, out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * arrsize * sizeof(T));
+}
+
+/* Merges of k = 16 and 256 runs, the total out of cache */
+#define BENCH_KWAY_MERGE(func, type, k) \
+    MY_BENCHMARK_CAPTURE(func, \
+                         type, \
+                         random_1m_k##k, \
+                         1000000, \
+                         std::string("random"), \
+                         (size_t)k); \
+    MY_BENCHMARK_CAPTURE(func, \
+                         type, \
+                         random_10m_k##k, \
+                         10000000, \
+                         std::string("random"), \
+                         (size_t)k);
+
+#define BENCH_BOTH_KWAY_MERGE(type) \
+    BENCH_KWAY_MERGE(simdkwaymerge, type, 16) \
+    BENCH_KWAY_MERGE(scalarkwaymerge, type, 16) \
+    BENCH_KWAY_MERGE(simdkwaymerge, type, 256) \
+    BENCH_KWAY_MERGE(scalarkwaymerge, type, 256)
+
+#define BENCH_BOTH_MERGE(type) \
+    BENCH_SORT(simdmerge, type) \
+    BENCH_SORT(scalarmerge, type)
+
+#define BENCH_BOTH_KVMERGE(type) \
+    BENCH_SORT(simdkvmerge, type) \
+    BENCH_SORT(scalarkvmerge, type)
+
+BENCH_BOTH_MERGE(uint64_t)
+BENCH_BOTH_MERGE(int64_t)
+BENCH_BOTH_MERGE(uint32_t)
+BENCH_BOTH_MERGE(int32_t)
+BENCH_BOTH_MERGE(uint16_t)
+BENCH_BOTH_MERGE(int16_t)
+BENCH_BOTH_MERGE(float)
+BENCH_BOTH_MERGE(double)
+
+BENCH_BOTH_KVMERGE(uint64_t)
+BENCH_BOTH_KVMERGE(int64_t)
+BENCH_BOTH_KVMERGE(double)
+BENCH_BOTH_KVMERGE(uint32_t)
+BENCH_BOTH_KVMERGE(int32_t)
+BENCH_BOTH_KVMERGE(float)
+
+BENCH_BOTH_KWAY_MERGE(uint64_t)
+BENCH_BOTH_KWAY_MERGE(int64_t)
+BENCH_BOTH_KWAY_MERGE(uint32_t)
+BENCH_BOTH_KWAY_MERGE(int32_t)
+BENCH_BOTH_KWAY_MERGE(uint16_t)
+BENCH_BOTH_KWAY_MERGE(int16_t)
+BENCH_BOTH_KWAY_MERGE(float)
+BENCH_BOTH_KWAY_MERGE(double)
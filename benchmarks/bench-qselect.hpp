@@ -46,6 +46,36 @@ static void scalarqselect(benchmark::State &state, Args &&...args)
     }
 }
 
+template <typename T, class... Args>
+static void simdparallelqselect(benchmark::State &state, Args &&...args)
+{
+    // Perform setup here
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    int64_t ARRSIZE = std::get<0>(args_tuple);
+    int64_t k = std::get<1>(args_tuple);
+    std::vector<T> arr;
+    std::vector<T> arr_bkp;
+
+    /* Initialize elements */
+    arr = get_uniform_rand_array<T>(ARRSIZE);
+    arr_bkp = arr;
+
+    /* call multi-threaded quickselect with all the hardware threads */
+    for (auto _ : state) {
+        x86simdsort::qselect_parallel<T>(arr.data(), k, ARRSIZE);
+
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+#define BENCH_PARALLEL_QSELECT(type) \
+    MY_BENCHMARK_CAPTURE( \
+            simdparallelqselect, type, k5m_10m, 10000000, 5000000); \
+    MY_BENCHMARK_CAPTURE( \
+            simdparallelqselect, type, k50m_100m, 100000000, 50000000);
+
 #define BENCH_BOTH_QSELECT(type) \
     BENCH_PARTIAL(simdqselect, type) \
     BENCH_PARTIAL(scalarqselect, type)
@@ -61,3 +91,10 @@ BENCH_BOTH_QSELECT(double)
 #ifdef __FLT16_MAX__
 BENCH_BOTH_QSELECT(_Float16)
 #endif
+
+BENCH_PARALLEL_QSELECT(uint64_t)
+BENCH_PARALLEL_QSELECT(int64_t)
+BENCH_PARALLEL_QSELECT(uint32_t)
+BENCH_PARALLEL_QSELECT(int32_t)
+BENCH_PARALLEL_QSELECT(float)
+BENCH_PARALLEL_QSELECT(double)
@@ -1,3 +1,5 @@
+#include "xss-radix-sort.hpp"
+
 template <typename T, class... Args>
 static void scalarsort(benchmark::State &state, Args &&...args)
 {
@@ -36,6 +38,253 @@ static void simdsort(benchmark::State &state, Args &&...args)
     }
 }
 
+template <typename T, class... Args>
+static void simdparallelsort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark: uses all the hardware threads
+    for (auto _ : state) {
+        x86simdsort::qsort_parallel(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+/*
+ * 16-bit quicksort alone: x86simdsort::qsort switches to the radix sort above
+ * xss_radix_sort_threshold elements, the single threaded qsort_parallel does
+ * not
+ */
+template <typename T, class... Args>
+static void simdquicksort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::qsort_parallel(arr.data(), arrsize, false, 1);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+template <typename T, class... Args>
+static void radixsort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        xss_radix_sort(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+template <typename T, class... Args>
+static void simdradixqsort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::radix_qsort(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+/*
+ * bfloat16 arrays are the upper halves of float arrays (T = float): the
+ * scalar baseline compares them as floats
+ */
+template <typename T>
+static std::vector<x86simdsort::bfloat16> get_bf16_array(std::string arrtype,
+                                                         size_t arrsize)
+{
+    std::vector<x86simdsort::bfloat16> arr;
+    for (T value : get_array<T>(arrtype, arrsize)) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        arr.push_back({(uint16_t)(bits >> 16)});
+    }
+    return arr;
+}
+
+template <typename T, class... Args>
+static void scalarsortbf16(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<x86simdsort::bfloat16> arr
+            = get_bf16_array<T>(arrtype, arrsize);
+    std::vector<x86simdsort::bfloat16> arr_bkp = arr;
+    auto to_float = [](x86simdsort::bfloat16 x) {
+        uint32_t bits = (uint32_t)x.bits << 16;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    };
+    // benchmark
+    for (auto _ : state) {
+        std::sort(arr.begin(), arr.end(), [&](auto a, auto b) {
+            return to_float(a) < to_float(b);
+        });
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+template <typename T, class... Args>
+static void simdsortbf16(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<x86simdsort::bfloat16> arr
+            = get_bf16_array<T>(arrtype, arrsize);
+    std::vector<x86simdsort::bfloat16> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::qsort(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+/*
+ * uint128 arrays are built from uint64_t arrays (T = uint64_t) with the top 16
+ * bits as hi, in the order of the uint64_t values: hi only has a few distinct
+ * values in a random array, so most compares go down to lo
+ */
+template <typename T>
+static std::vector<x86simdsort::uint128> get_uint128_array(std::string arrtype,
+                                                           size_t arrsize)
+{
+    std::vector<x86simdsort::uint128> arr;
+    for (T value : get_array<T>(arrtype, arrsize)) {
+        arr.push_back({value, value >> 48});
+    }
+    return arr;
+}
+
+template <typename T, class... Args>
+static void scalarsortuint128(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<x86simdsort::uint128> arr
+            = get_uint128_array<T>(arrtype, arrsize);
+    std::vector<x86simdsort::uint128> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        std::sort(arr.begin(), arr.end());
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+template <typename T, class... Args>
+static void simdsortuint128(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<x86simdsort::uint128> arr
+            = get_uint128_array<T>(arrtype, arrsize);
+    std::vector<x86simdsort::uint128> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::qsort(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+/*
+ * NUMA-aware sort with a given number of domains (0: one per NUMA node). On a
+ * single node machine, forcing 2 domains and running the benchmark under
+ * `numactl --interleave=all` approximates the 2-socket memory layout.
+ */
+template <typename T, class... Args>
+static void simdnumasort(benchmark::State &state, Args &&...args)
+{
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    unsigned ndomains = std::get<2>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark: uses all the hardware threads
+    for (auto _ : state) {
+        x86simdsort::qsort_numa_parallel(
+                arr.data(), arrsize, false, 0, ndomains);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+#define BENCH_NUMA_QSORT(type) \
+    MY_BENCHMARK_CAPTURE(simdnumasort, \
+                         type, \
+                         random_100m_nodes, \
+                         100000000, \
+                         std::string("random"), \
+                         0u); \
+    MY_BENCHMARK_CAPTURE(simdnumasort, \
+                         type, \
+                         random_100m_2d, \
+                         100000000, \
+                         std::string("random"), \
+                         2u); \
+    MY_BENCHMARK_CAPTURE(simdnumasort, \
+                         type, \
+                         random_100m_4d, \
+                         100000000, \
+                         std::string("random"), \
+                         4u);
+
 #define BENCH_BOTH_QSORT(type) \
     BENCH_SORT(simdsort, type) \
     BENCH_SORT(scalarsort, type)
@@ -44,6 +293,8 @@ BENCH_BOTH_QSORT(uint64_t)
 BENCH_BOTH_QSORT(int64_t)
 BENCH_BOTH_QSORT(uint32_t)
 BENCH_BOTH_QSORT(int32_t)
+BENCH_BOTH_QSORT(uint8_t)
+BENCH_BOTH_QSORT(int8_t)
 BENCH_BOTH_QSORT(uint16_t)
 BENCH_BOTH_QSORT(int16_t)
 BENCH_BOTH_QSORT(float)
@@ -51,3 +302,36 @@ BENCH_BOTH_QSORT(double)
 #ifdef __FLT16_MAX__
 BENCH_BOTH_QSORT(_Float16)
 #endif
+
+BENCH_SORT(simdquicksort, uint16_t)
+BENCH_SORT(simdquicksort, int16_t)
+BENCH_SORT(radixsort, uint16_t)
+BENCH_SORT(radixsort, int16_t)
+
+BENCH_SORT(simdsortbf16, float)
+BENCH_SORT(scalarsortbf16, float)
+
+BENCH_SORT(simdsortuint128, uint64_t)
+BENCH_SORT(scalarsortuint128, uint64_t)
+
+BENCH_SORT(simdradixqsort, uint64_t)
+BENCH_SORT(simdradixqsort, int64_t)
+BENCH_SORT(simdradixqsort, uint32_t)
+BENCH_SORT(simdradixqsort, int32_t)
+
+BENCH_SORT(simdparallelsort, uint64_t)
+BENCH_SORT(simdparallelsort, int64_t)
+BENCH_SORT(simdparallelsort, uint32_t)
+BENCH_SORT(simdparallelsort, int32_t)
+BENCH_SORT(simdparallelsort, uint16_t)
+BENCH_SORT(simdparallelsort, int16_t)
+BENCH_SORT(simdparallelsort, float)
+BENCH_SORT(simdparallelsort, double)
+#ifdef __FLT16_MAX__
+BENCH_SORT(simdparallelsort, _Float16)
+#endif
+
+BENCH_NUMA_QSORT(uint64_t)
+BENCH_NUMA_QSORT(uint32_t)
+BENCH_NUMA_QSORT(float)
+BENCH_NUMA_QSORT(double)
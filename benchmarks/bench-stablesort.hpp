@@ -0,0 +1,107 @@
+template <typename T, class... Args>
+static void scalarstablesort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        std::stable_sort(arr.begin(), arr.end());
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+template <typename T, class... Args>
+static void simdstablesort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<T> arr_bkp = arr;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::stable_qsort(arr.data(), arrsize);
+        state.PauseTiming();
+        arr = arr_bkp;
+        state.ResumeTiming();
+    }
+}
+
+template <typename T, class... Args>
+static void scalarstableargsort(benchmark::State &state, Args &&...args)
+{
+    // get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<size_t> inx(arrsize);
+    // benchmark
+    for (auto _ : state) {
+        std::iota(inx.begin(), inx.end(), 0);
+        std::stable_sort(
+                inx.begin(), inx.end(), [&arr](size_t left, size_t right) {
+                    return arr[left] < arr[right];
+                });
+    }
+}
+
+template <typename T, class... Args>
+static void simdstableargsort(benchmark::State &state, Args &&...args)
+{
+    // get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> arr = get_array<T>(arrtype, arrsize);
+    std::vector<size_t> inx;
+    // benchmark
+    for (auto _ : state) {
+        inx = x86simdsort::stable_argsort(arr.data(), arrsize);
+    }
+}
+
+template <typename T, class... Args>
+static void simdstablekvsort(benchmark::State &state, Args &&...args)
+{
+    // Get args
+    auto args_tuple = std::make_tuple(std::move(args)...);
+    size_t arrsize = std::get<0>(args_tuple);
+    std::string arrtype = std::get<1>(args_tuple);
+    // set up array
+    std::vector<T> key = get_array<T>(arrtype, arrsize);
+    std::vector<T> val = get_array<T>("random", arrsize);
+    std::vector<T> key_bkp = key;
+    // benchmark
+    for (auto _ : state) {
+        x86simdsort::stable_keyvalue_qsort(key.data(), val.data(), arrsize);
+        state.PauseTiming();
+        key = key_bkp;
+        state.ResumeTiming();
+    }
+}
+
+#define BENCH_BOTH_STABLESORT(type) \
+    BENCH_SORT(simdstablesort, type) \
+    BENCH_SORT(scalarstablesort, type) \
+    BENCH_SORT(simdstableargsort, type) \
+    BENCH_SORT(scalarstableargsort, type) \
+    BENCH_SORT(simdstablekvsort, type)
+
+BENCH_BOTH_STABLESORT(uint64_t)
+BENCH_BOTH_STABLESORT(int64_t)
+BENCH_BOTH_STABLESORT(double)
+BENCH_BOTH_STABLESORT(uint32_t)
+BENCH_BOTH_STABLESORT(int32_t)
+BENCH_BOTH_STABLESORT(float)
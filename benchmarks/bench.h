@@ -46,7 +46,11 @@
     MY_BENCHMARK_CAPTURE( \
             func, type, constant_10k, 10000, std::string("constant")); \
     MY_BENCHMARK_CAPTURE( \
-            func, type, reverse_10k, 10000, std::string("reverse"));
+            func, type, reverse_10k, 10000, std::string("reverse")); \
+    MY_BENCHMARK_CAPTURE( \
+            func, type, mostly_min_10k, 10000, std::string("mostly_min")); \
+    MY_BENCHMARK_CAPTURE( \
+            func, type, mostly_min_1m, 1000000, std::string("mostly_min"));
 
 #define BENCH_PARTIAL(func, type) \
     MY_BENCHMARK_CAPTURE(func, type, k10, 10000, 10); \
@@ -1,45 +1,566 @@
 // AVX2 specific routines:
+#include "avx2-16bit-qsort.hpp"
 #include "avx2-32bit-qsort.hpp"
 #include "avx2-64bit-qsort.hpp"
 #include "avx2-32bit-half.hpp"
+#include "xss-bfloat16.hpp"
 #include "xss-common-argsort.h"
+#include "xss-parallel-argsort.hpp"
+#include "xss-parallel-keyvaluesort.hpp"
+#include "xss-counting-sort.hpp"
+#include "xss-parallel-numa-qsort.hpp"
+#include "xss-parallel-qsort.hpp"
+#include "xss-merge.hpp"
+#include "xss-radix-qsort.hpp"
+#include "xss-stable-sort.hpp"
+#include "xss-radix-sort.hpp"
 #include "x86simdsort-internal.h"
 
 #define DEFINE_ALL_METHODS(type) \
     template <> \
-    void qsort(type *arr, size_t arrsize, bool hasnan) \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
     { \
-        avx2_qsort(arr, arrsize, hasnan); \
+        avx2_qsort(arr, arrsize, hasnan, descending); \
     } \
     template <> \
-    void qselect(type *arr, size_t k, size_t arrsize, bool hasnan) \
+    void qsort_parallel( \
+            type *arr, size_t arrsize, bool hasnan, const executor &exec) \
     { \
-        avx2_qselect(arr, k, arrsize, hasnan); \
+        avx2_qsort_parallel(arr, arrsize, hasnan, xss_make_executor(exec)); \
     } \
     template <> \
-    void partial_qsort(type *arr, size_t k, size_t arrsize, bool hasnan) \
+    void qsort_numa_parallel(type *arr, \
+                             size_t arrsize, \
+                             bool hasnan, \
+                             unsigned nthreads, \
+                             unsigned ndomains) \
     { \
-        avx2_partial_qsort(arr, k, arrsize, hasnan); \
+        avx2_qsort_numa_parallel(arr, arrsize, hasnan, nthreads, ndomains); \
     } \
     template <> \
-    std::vector<size_t> argsort(type *arr, size_t arrsize, bool hasnan) \
+    void qsort_numa_parallel_exec(type *arr, \
+                                  size_t arrsize, \
+                                  bool hasnan, \
+                                  const std::vector<executor> &executors) \
     { \
-        return avx2_argsort(arr, arrsize, hasnan); \
+        std::vector<xss_executor> execs = xss_make_executors(executors); \
+        avx2_qsort_numa_parallel( \
+                arr, arrsize, hasnan, execs.data(), execs.size()); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx2_qselect(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qselect_parallel(type *arr, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          const executor &exec) \
+    { \
+        avx2_qselect_parallel( \
+                arr, k, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx2_partial_qsort(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    std::vector<size_t> argsort( \
+            type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        return avx2_argsort(arr, arrsize, hasnan, descending); \
     } \
     template <> \
     std::vector<size_t> argselect( \
             type *arr, size_t k, size_t arrsize, bool hasnan) \
     { \
         return avx2_argselect(arr, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort_into(type *arr, \
+                      size_t *arg, \
+                      size_t arrsize, \
+                      bool hasnan, \
+                      bool descending, \
+                      bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect_into(type *arr, \
+                        size_t *arg, \
+                        size_t k, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort32_into(type *arr, \
+                        uint32_t *arg, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect32_into(type *arr, \
+                          uint32_t *arg, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> argsort_parallel( \
+            type *arr, size_t arrsize, bool hasnan, const executor &exec) \
+    { \
+        return avx2_argsort_parallel( \
+                arr, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    std::vector<size_t> argselect_parallel(type *arr, \
+                                           size_t k, \
+                                           size_t arrsize, \
+                                           bool hasnan, \
+                                           const executor &exec) \
+    { \
+        return avx2_argselect_parallel( \
+                arr, k, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void stable_qsort(type *arr, size_t arrsize, bool hasnan) \
+    { \
+        avx2_stable_qsort(arr, arrsize, hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> stable_argsort( \
+            type *arr, size_t arrsize, bool hasnan) \
+    { \
+        return avx2_stable_argsort(arr, arrsize, hasnan); \
+    } \
+    template <> \
+    void merge(const type *a, size_t na, const type *b, size_t nb, type *out) \
+    { \
+        avx2_merge(a, na, b, nb, out); \
+    } \
+    template <> \
+    void kway_merge( \
+            const type *const *runs, const size_t *sizes, size_t k, type *out) \
+    { \
+        avx2_kway_merge(runs, sizes, k, out); \
+    }
+
+/* Large 16-bit arrays are radix sorted, like with AVX-512 */
+#define DEFINE_16BIT_METHODS(type) \
+    template <> \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        if (arrsize >= xss_radix_sort_threshold) { \
+            xss_radix_sort(arr, arrsize, descending); \
+            return; \
+        } \
+        avx2_qsort(arr, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qsort_parallel( \
+            type *arr, size_t arrsize, bool hasnan, const executor &exec) \
+    { \
+        avx2_qsort_parallel(arr, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void qsort_numa_parallel(type *arr, \
+                             size_t arrsize, \
+                             bool hasnan, \
+                             unsigned nthreads, \
+                             unsigned ndomains) \
+    { \
+        avx2_qsort_numa_parallel(arr, arrsize, hasnan, nthreads, ndomains); \
+    } \
+    template <> \
+    void qsort_numa_parallel_exec(type *arr, \
+                                  size_t arrsize, \
+                                  bool hasnan, \
+                                  const std::vector<executor> &executors) \
+    { \
+        std::vector<xss_executor> execs = xss_make_executors(executors); \
+        avx2_qsort_numa_parallel( \
+                arr, arrsize, hasnan, execs.data(), execs.size()); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx2_qselect(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qselect_parallel(type *arr, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          const executor &exec) \
+    { \
+        avx2_qselect_parallel( \
+                arr, k, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx2_partial_qsort(arr, k, arrsize, hasnan, descending); \
+    }
+
+/*
+ * bfloat16, and _Float16 without AVX512-FP16, are sorted as the int16_t of
+ * the same order
+ */
+#define DEFINE_FLOAT16_METHODS(type, SORT_FUNC) \
+    template <> \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(hasnan); \
+        uint16_t *bits = reinterpret_cast<uint16_t *>(arr); \
+        SORT_FUNC(bits, arrsize, [=](int16_t *keys) { \
+            qsort(keys, arrsize, false, descending); \
+        }); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(hasnan); \
+        uint16_t *bits = reinterpret_cast<uint16_t *>(arr); \
+        SORT_FUNC(bits, arrsize, [=](int16_t *keys) { \
+            avx2_qselect(keys, k, arrsize, false, descending); \
+        }); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(hasnan); \
+        uint16_t *bits = reinterpret_cast<uint16_t *>(arr); \
+        SORT_FUNC(bits, arrsize, [=](int16_t *keys) { \
+            avx2_partial_qsort(keys, k, arrsize, false, descending); \
+        }); \
+    }
+
+#define DEFINE_RADIX_METHODS(type) \
+    template <> \
+    void radix_qsort(type *arr, size_t arrsize) \
+    { \
+        avx2_radix_qsort(arr, arrsize); \
+    }
+
+/*
+ * 8-bit types are counting sorted, which also gives a valid result for
+ * qselect and partial_qsort
+ */
+#define DEFINE_8BIT_METHODS(type) \
+    template <> \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(hasnan); \
+        xss_counting_sort(arr, arrsize, descending); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(k); \
+        UNUSED(hasnan); \
+        xss_counting_sort(arr, arrsize, descending); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(k); \
+        UNUSED(hasnan); \
+        xss_counting_sort(arr, arrsize, descending); \
     }
 
+/*
+ * 16-bit dtypes only have the argsort and argselect of xss-packed-16bit.hpp,
+ * which pack every key with its index into a 64-bit word
+ */
+#define DEFINE_16BIT_ARG_METHODS(type) \
+    template <> \
+    std::vector<size_t> argsort( \
+            type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        return avx2_argsort_16bit(arr, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    std::vector<size_t> argselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        return avx2_argselect_16bit(arr, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort_into(type *arr, \
+                      size_t *arg, \
+                      size_t arrsize, \
+                      bool hasnan, \
+                      bool descending, \
+                      bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argsort_16bit(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect_into(type *arr, \
+                        size_t *arg, \
+                        size_t k, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argselect_16bit(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort32_into(type *arr, \
+                        uint32_t *arg, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argsort_16bit(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect32_into(type *arr, \
+                          uint32_t *arg, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argselect_16bit(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> argsort_parallel( \
+            type *arr, size_t arrsize, bool hasnan, const executor &exec) \
+    { \
+        return avx2_argsort_16bit_parallel( \
+                arr, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    std::vector<size_t> argselect_parallel(type *arr, \
+                                           size_t k, \
+                                           size_t arrsize, \
+                                           bool hasnan, \
+                                           const executor &exec) \
+    { \
+        return avx2_argselect_16bit_parallel( \
+                arr, k, arrsize, hasnan, xss_make_executor(exec)); \
+    }
+
+/* bfloat16 keys are argsorted as the int16_t of the same order */
+#define DEFINE_BF16_ARG_METHODS() \
+    template <> \
+    void argsort_into(bfloat16 *arr, \
+                      size_t *arg, \
+                      size_t arrsize, \
+                      bool hasnan, \
+                      bool descending, \
+                      bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argsort_bf16(reinterpret_cast<uint16_t *>(arr), \
+                          arg, \
+                          arrsize, \
+                          hasnan, \
+                          descending); \
+    } \
+    template <> \
+    void argselect_into(bfloat16 *arr, \
+                        size_t *arg, \
+                        size_t k, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argselect_bf16( \
+                reinterpret_cast<uint16_t *>(arr), arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> argsort( \
+            bfloat16 *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        std::vector<size_t> arg(arrsize); \
+        argsort_into(arr, arg.data(), arrsize, hasnan, descending, true); \
+        return arg; \
+    } \
+    template <> \
+    std::vector<size_t> argselect( \
+            bfloat16 *arr, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        std::vector<size_t> arg(arrsize); \
+        argselect_into(arr, arg.data(), k, arrsize, hasnan, true); \
+        return arg; \
+    } \
+    template <> \
+    void argsort32_into(bfloat16 *arr, \
+                        uint32_t *arg, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argsort_bf16(reinterpret_cast<uint16_t *>(arr), \
+                          arg, \
+                          arrsize, \
+                          hasnan, \
+                          descending); \
+    } \
+    template <> \
+    void argselect32_into(bfloat16 *arr, \
+                          uint32_t *arg, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx2_argselect_bf16( \
+                reinterpret_cast<uint16_t *>(arr), arg, k, arrsize, hasnan); \
+    }
+
+/*
+ * The key-value quicksort runs on 4 lanes, the width of the AVX2 key-value
+ * networks: 32-bit keys and values use half vectors
+ */
+#define DEFINE_KEYVALUE_METHODS_PAIR(type1, type2) \
+    template <> \
+    void keyvalue_qsort(type1 *key, \
+                        type2 *val, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        avx2_qsort_kv(key, val, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void keyvalue_qsort_parallel(type1 *key, \
+                                 type2 *val, \
+                                 size_t arrsize, \
+                                 bool hasnan, \
+                                 const executor &exec) \
+    { \
+        avx2_qsort_kv_parallel( \
+                key, val, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void stable_keyvalue_qsort( \
+            type1 *key, type2 *val, size_t arrsize, bool hasnan) \
+    { \
+        avx2_stable_qsort_kv(key, val, arrsize, hasnan); \
+    } \
+    template <> \
+    void keyvalue_merge(const type1 *akey, \
+                        const type2 *aval, \
+                        size_t na, \
+                        const type1 *bkey, \
+                        const type2 *bval, \
+                        size_t nb, \
+                        type1 *outkey, \
+                        type2 *outval) \
+    { \
+        avx2_merge_kv(akey, aval, na, bkey, bval, nb, outkey, outval); \
+    }
+
+#define DEFINE_KEYVALUE_METHODS(type) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, uint64_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, int64_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, double) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, uint32_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, int32_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, float)
+
+/*
+ * 16-bit keys only have the quicksort, which packs every key with its value
+ * (or its index) into a 32-bit or 64-bit word
+ */
+#define DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type1, type2) \
+    template <> \
+    void keyvalue_qsort(type1 *key, \
+                        type2 *val, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        avx2_qsort_kv(key, val, arrsize, hasnan, descending); \
+    }
+
+#define DEFINE_16BIT_KEYVALUE_QSORT(type) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, uint64_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, int64_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, double) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, uint32_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, int32_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, float) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, uint16_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, int16_t)
+
 namespace xss {
 namespace avx2 {
+    DEFINE_8BIT_METHODS(uint8_t)
+    DEFINE_8BIT_METHODS(int8_t)
+    DEFINE_16BIT_METHODS(uint16_t)
+    DEFINE_16BIT_METHODS(int16_t)
+    DEFINE_FLOAT16_METHODS(bfloat16, xss_sort_bf16)
+#ifdef __FLT16_MAX__
+    DEFINE_FLOAT16_METHODS(_Float16, xss_sort_fp16)
+#endif
     DEFINE_ALL_METHODS(uint32_t)
     DEFINE_ALL_METHODS(int32_t)
     DEFINE_ALL_METHODS(float)
     DEFINE_ALL_METHODS(uint64_t)
     DEFINE_ALL_METHODS(int64_t)
     DEFINE_ALL_METHODS(double)
+    DEFINE_RADIX_METHODS(uint32_t)
+    DEFINE_RADIX_METHODS(int32_t)
+    DEFINE_RADIX_METHODS(uint64_t)
+    DEFINE_RADIX_METHODS(int64_t)
+    DEFINE_KEYVALUE_METHODS(uint64_t)
+    DEFINE_KEYVALUE_METHODS(int64_t)
+    DEFINE_KEYVALUE_METHODS(double)
+    DEFINE_KEYVALUE_METHODS(uint32_t)
+    DEFINE_KEYVALUE_METHODS(int32_t)
+    DEFINE_KEYVALUE_METHODS(float)
+    DEFINE_16BIT_KEYVALUE_QSORT(uint16_t)
+    DEFINE_16BIT_KEYVALUE_QSORT(int16_t)
+#ifdef __FLT16_MAX__
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(uint16_t, _Float16)
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(int16_t, _Float16)
+    DEFINE_16BIT_KEYVALUE_QSORT(_Float16)
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(_Float16, _Float16)
+#endif
+    DEFINE_16BIT_ARG_METHODS(uint16_t)
+    DEFINE_16BIT_ARG_METHODS(int16_t)
+#ifdef __FLT16_MAX__
+    DEFINE_16BIT_ARG_METHODS(_Float16)
+#endif
+    DEFINE_BF16_ARG_METHODS()
 } // namespace avx2
 } // namespace xss
@@ -0,0 +1,525 @@
+/*
+ * External sort of binary files larger than the memory budget:
+ * (1) The input is read in chunks of half the budget, the next chunk being
+ * read in the background while the current one is sorted with qsort and
+ * appended to a spill file as a sorted run.
+ * (2) While there are more runs than can be merged at once, groups of them
+ * are merged into runs of a second spill file.
+ * (3) The remaining runs are merged into the output.
+ *
+ * A merge reads every run by blocks and prefetches the next block of each in
+ * the background. Everything still unread in a run is at least the last
+ * element of its current block, so each round hands all the elements up to
+ * the smallest of those to kway_merge, and writes the result in the
+ * background while the next round is merged.
+ *
+ * Files which fit in memory can instead be sorted in place through a shared
+ * mapping, which saves the copies of read() and write(): the page cache is
+ * sorted directly and written back with msync.
+ */
+
+#include "x86simdsort.h"
+#include "custom-compare.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xss {
+namespace external {
+
+    /* Blocks read from the runs during a merge are at least this large, which
+     * bounds the number of runs merged at once */
+    constexpr size_t min_block_bytes = 1 << 19;
+
+    /* Closes the file descriptor on destruction, keeping errno */
+    struct file {
+        int fd;
+        explicit file(int fd = -1) : fd(fd) {}
+        file(const file &) = delete;
+        file &operator=(const file &) = delete;
+        ~file()
+        {
+            if (fd >= 0) {
+                int err = errno;
+                close(fd);
+                errno = err;
+            }
+        }
+    };
+
+    static bool read_fully(int fd, void *buf, size_t bytes, off_t offset)
+    {
+        char *ptr = (char *)buf;
+        while (bytes > 0) {
+            ssize_t n = pread(fd, ptr, bytes, offset);
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) {
+                if (n == 0) { errno = EIO; }
+                return false;
+            }
+            ptr += n;
+            bytes -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    static bool write_fully(int fd, const void *buf, size_t bytes, off_t offset)
+    {
+        const char *ptr = (const char *)buf;
+        while (bytes > 0) {
+            ssize_t n = pwrite(fd, ptr, bytes, offset);
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n < 0) { return false; }
+            ptr += n;
+            bytes -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    /* Anonymous temporary file in tmpdir, deleted once closed */
+    static int open_spill_file(const char *tmpdir)
+    {
+        std::string path = std::string(tmpdir) + "/xss-external-XXXXXX";
+        int fd = mkstemp(path.data());
+        if (fd >= 0) { unlink(path.c_str()); }
+        return fd;
+    }
+
+    /* Sorted run of a spill file, in elements */
+    struct run {
+        size_t start;
+        size_t size;
+    };
+
+    /*
+     * Reads a run by blocks into a window of two blocks: once less than a
+     * block is left in the window, the block read in the background is
+     * appended and the next one requested
+     */
+    template <typename T>
+    class run_reader {
+    public:
+        run_reader(int fd, run r, size_t block)
+            : fd(fd)
+            , offset((off_t)(r.start * sizeof(T)))
+            , left(r.size)
+            , block(block)
+            , window(new T[2 * block])
+            , next(new T[block])
+        {
+            prefetch();
+        }
+        bool refill()
+        {
+            if (tail - head >= block || !pending.valid()) { return true; }
+            if (!pending.get()) { return false; }
+            if (head != 0) {
+                T *w = window.get();
+                std::copy(w + head, w + tail, w);
+                tail -= head;
+                head = 0;
+            }
+            std::copy(next.get(), next.get() + next_len, window.get() + tail);
+            tail += next_len;
+            prefetch();
+            return true;
+        }
+        /* Whether part of the run is not in the window yet */
+        bool more() const
+        {
+            return pending.valid();
+        }
+        const T *data() const
+        {
+            return window.get() + head;
+        }
+        size_t size() const
+        {
+            return tail - head;
+        }
+        void consume(size_t n)
+        {
+            head += n;
+        }
+
+    private:
+        void prefetch()
+        {
+            if (left == 0) { return; }
+            next_len = std::min(block, left);
+            pending = std::async(std::launch::async,
+                                 read_fully,
+                                 fd,
+                                 next.get(),
+                                 next_len * sizeof(T),
+                                 offset);
+            offset += next_len * sizeof(T);
+            left -= next_len;
+        }
+        int fd;
+        off_t offset;
+        size_t left;
+        size_t block;
+        std::unique_ptr<T[]> window;
+        std::unique_ptr<T[]> next;
+        size_t head = 0, tail = 0, next_len = 0;
+        /* Last member: waits for the read before the buffers go away */
+        std::future<bool> pending;
+    };
+
+    /*
+     * Merges the k runs of the file in into the file out at element position
+     * start, reading blocks of block elements
+     */
+    template <typename T>
+    static bool merge_runs(int in,
+                           const run *runs,
+                           size_t k,
+                           int out,
+                           size_t start,
+                           size_t block)
+    {
+        auto less = compare<T, std::less<T>>();
+        std::vector<std::unique_ptr<run_reader<T>>> readers;
+        size_t total = 0;
+        for (size_t i = 0; i < k; ++i) {
+            readers.emplace_back(new run_reader<T>(in, runs[i], block));
+            total += runs[i].size;
+        }
+        /* A round outputs at most the k windows of two blocks */
+        std::unique_ptr<T[]> outbuf[2]
+                = {std::unique_ptr<T[]>(new T[2 * k * block]),
+                   std::unique_ptr<T[]>(new T[2 * k * block])};
+        std::vector<const T *> ptrs(k);
+        std::vector<size_t> sizes(k);
+        std::future<bool> written;
+        for (int cur = 0; total > 0; cur ^= 1) {
+            bool bounded = false;
+            T bound {};
+            for (auto &r : readers) {
+                if (!r->refill()) { return false; }
+                if (r->more()) {
+                    const T &last = r->data()[r->size() - 1];
+                    if (!bounded || less(last, bound)) { bound = last; }
+                    bounded = true;
+                }
+            }
+            size_t n = 0;
+            for (size_t i = 0; i < k; ++i) {
+                const T *data = readers[i]->data();
+                ptrs[i] = data;
+                sizes[i] = readers[i]->size();
+                if (bounded) {
+                    sizes[i] = std::upper_bound(
+                                       data, data + sizes[i], bound, less)
+                            - data;
+                }
+                n += sizes[i];
+            }
+            x86simdsort::kway_merge(
+                    ptrs.data(), sizes.data(), k, outbuf[cur].get());
+            for (size_t i = 0; i < k; ++i) {
+                readers[i]->consume(sizes[i]);
+            }
+            if (written.valid() && !written.get()) { return false; }
+            written = std::async(std::launch::async,
+                                 write_fully,
+                                 out,
+                                 outbuf[cur].get(),
+                                 n * sizeof(T),
+                                 (off_t)(start * sizeof(T)));
+            start += n;
+            total -= n;
+        }
+        return !written.valid() || written.get();
+    }
+
+    /*
+     * Sorts the n elements of the file in by chunks of chunk elements, which
+     * are written as runs to the file spill
+     */
+    template <typename T>
+    static bool generate_runs(int in,
+                              size_t n,
+                              int spill,
+                              size_t chunk,
+                              bool hasnan,
+                              std::vector<run> &runs)
+    {
+        std::unique_ptr<T[]> buf[2] = {std::unique_ptr<T[]>(new T[chunk]),
+                                       std::unique_ptr<T[]>(new T[chunk])};
+        size_t start = 0, len = std::min(chunk, n);
+        std::future<bool> pending = std::async(std::launch::async,
+                                               read_fully,
+                                               in,
+                                               buf[0].get(),
+                                               len * sizeof(T),
+                                               (off_t)0);
+        for (int cur = 0; len > 0; cur ^= 1) {
+            if (!pending.get()) { return false; }
+            size_t next = start + len;
+            size_t next_len = std::min(chunk, n - next);
+            if (next_len > 0) {
+                pending = std::async(std::launch::async,
+                                     read_fully,
+                                     in,
+                                     buf[cur ^ 1].get(),
+                                     next_len * sizeof(T),
+                                     (off_t)(next * sizeof(T)));
+            }
+            x86simdsort::qsort(buf[cur].get(), len, hasnan);
+            if (!write_fully(spill,
+                             buf[cur].get(),
+                             len * sizeof(T),
+                             (off_t)(start * sizeof(T)))) {
+                return false;
+            }
+            runs.push_back({start, len});
+            start = next;
+            len = next_len;
+        }
+        return true;
+    }
+
+    static int open_output(const char *output)
+    {
+        return open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    template <typename T>
+    static bool sort_file(const char *input,
+                          const char *output,
+                          size_t memory_bytes,
+                          const char *tmpdir,
+                          bool hasnan)
+    {
+        if (tmpdir == NULL) { tmpdir = std::getenv("TMPDIR"); }
+        if (tmpdir == NULL) { tmpdir = "/tmp"; }
+        file in(open(input, O_RDONLY));
+        struct stat st;
+        if (in.fd < 0 || fstat(in.fd, &st) != 0) { return false; }
+        if (st.st_size % sizeof(T) != 0) {
+            errno = EINVAL;
+            return false;
+        }
+        size_t n = st.st_size / sizeof(T);
+        size_t chunk = std::max(memory_bytes / (2 * sizeof(T)), (size_t)1);
+
+        /* The output is only opened once the input is read, so both can be
+         * the same file */
+        if (n <= 2 * chunk) {
+            std::unique_ptr<T[]> arr(new T[n]);
+            if (!read_fully(in.fd, arr.get(), n * sizeof(T), 0)) {
+                return false;
+            }
+            x86simdsort::qsort(arr.get(), n, hasnan);
+            file out(open_output(output));
+            return out.fd >= 0
+                    && write_fully(out.fd, arr.get(), n * sizeof(T), 0);
+        }
+
+        std::unique_ptr<file> spill(new file(open_spill_file(tmpdir)));
+        std::vector<run> runs;
+        if (spill->fd < 0
+            || !generate_runs<T>(in.fd, n, spill->fd, chunk, hasnan, runs)) {
+            return false;
+        }
+        /* Every run needs 3 blocks of input and 4 of output */
+        size_t fanin
+                = std::max(memory_bytes / (7 * min_block_bytes), (size_t)2);
+        auto block = [memory_bytes](size_t k) {
+            return std::max(memory_bytes / (7 * k * sizeof(T)), (size_t)1);
+        };
+        while (runs.size() > fanin) {
+            std::unique_ptr<file> merged(new file(open_spill_file(tmpdir)));
+            if (merged->fd < 0) { return false; }
+            std::vector<run> merged_runs;
+            for (size_t i = 0; i < runs.size(); i += fanin) {
+                size_t k = std::min(fanin, runs.size() - i);
+                size_t start = runs[i].start;
+                const run &last = runs[i + k - 1];
+                size_t size = last.start + last.size - start;
+                if (!merge_runs<T>(spill->fd,
+                                   runs.data() + i,
+                                   k,
+                                   merged->fd,
+                                   start,
+                                   block(k))) {
+                    return false;
+                }
+                merged_runs.push_back({start, size});
+            }
+            spill = std::move(merged);
+            runs = std::move(merged_runs);
+        }
+        file out(open_output(output));
+        return out.fd >= 0
+                && merge_runs<T>(spill->fd,
+                                 runs.data(),
+                                 runs.size(),
+                                 out.fd,
+                                 0,
+                                 block(runs.size()));
+    }
+
+    /*
+     * Shared writable mapping of a whole file of T, unmapped on destruction.
+     * The pages are read in by MAP_POPULATE, so that the sort does not fault
+     * them in one at a time, and huge pages are requested where the file
+     * system supports them. MADV_SEQUENTIAL is not used: the partitioning
+     * passes revisit pages and would only be hurt by early reclaim.
+     */
+    template <typename T>
+    struct mapping {
+        T *ptr = NULL;
+        size_t size = 0;
+        mapping() = default;
+        mapping(const mapping &) = delete;
+        mapping &operator=(const mapping &) = delete;
+        ~mapping()
+        {
+            if (ptr != NULL) {
+                int err = errno;
+                munmap(ptr, size * sizeof(T));
+                errno = err;
+            }
+        }
+        bool map(const char *path)
+        {
+            file f(open(path, O_RDWR));
+            struct stat st;
+            if (f.fd < 0 || fstat(f.fd, &st) != 0) { return false; }
+            if (st.st_size % sizeof(T) != 0) {
+                errno = EINVAL;
+                return false;
+            }
+            if (st.st_size == 0) { return true; }
+            void *addr = mmap(NULL,
+                              st.st_size,
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE,
+                              f.fd,
+                              0);
+            if (addr == MAP_FAILED) { return false; }
+#ifdef MADV_HUGEPAGE
+            /* Only a hint, most file systems do not support it */
+            int err = errno;
+            madvise(addr, st.st_size, MADV_HUGEPAGE);
+            errno = err;
+#endif
+            ptr = (T *)addr;
+            size = st.st_size / sizeof(T);
+            return true;
+        }
+        bool sync()
+        {
+            return ptr == NULL || msync(ptr, size * sizeof(T), MS_SYNC) == 0;
+        }
+    };
+
+    template <typename T>
+    static bool sort_mapped_file(const char *path, bool hasnan)
+    {
+        mapping<T> m;
+        if (!m.map(path)) { return false; }
+        x86simdsort::qsort(m.ptr, m.size, hasnan);
+        return m.sync();
+    }
+
+    template <typename T1, typename T2>
+    static bool
+    sort_mapped_files(const char *keypath, const char *valpath, bool hasnan)
+    {
+        mapping<T1> keys;
+        mapping<T2> values;
+        if (!keys.map(keypath) || !values.map(valpath)) { return false; }
+        if (keys.size != values.size) {
+            errno = EINVAL;
+            return false;
+        }
+        x86simdsort::keyvalue_qsort(keys.ptr, values.ptr, keys.size, hasnan);
+        return keys.sync() && values.sync();
+    }
+
+} // namespace external
+} // namespace xss
+
+namespace x86simdsort {
+
+#define DEFINE_EXTERNAL_SORT(TYPE) \
+    template <> \
+    bool external_sort<TYPE>(const char *input, \
+                             const char *output, \
+                             size_t memory_bytes, \
+                             const char *tmpdir, \
+                             bool hasnan) \
+    { \
+        return xss::external::sort_file<TYPE>( \
+                input, output, memory_bytes, tmpdir, hasnan); \
+    }
+
+#define DEFINE_MMAP_SORT(TYPE) \
+    template <> \
+    bool mmap_qsort<TYPE>(const char *path, bool hasnan) \
+    { \
+        return xss::external::sort_mapped_file<TYPE>(path, hasnan); \
+    }
+
+#define DEFINE_MMAP_KEYVALUE_SORT(TYPE1, TYPE2) \
+    template <> \
+    bool mmap_keyvalue_qsort<TYPE1, TYPE2>( \
+            const char *keypath, const char *valpath, bool hasnan) \
+    { \
+        return xss::external::sort_mapped_files<TYPE1, TYPE2>( \
+                keypath, valpath, hasnan); \
+    }
+
+#define DEFINE_MMAP_KEYVALUE_SORT_FORTYPE(type) \
+    DEFINE_MMAP_KEYVALUE_SORT(type, uint64_t) \
+    DEFINE_MMAP_KEYVALUE_SORT(type, int64_t) \
+    DEFINE_MMAP_KEYVALUE_SORT(type, double) \
+    DEFINE_MMAP_KEYVALUE_SORT(type, uint32_t) \
+    DEFINE_MMAP_KEYVALUE_SORT(type, int32_t) \
+    DEFINE_MMAP_KEYVALUE_SORT(type, float)
+
+DEFINE_EXTERNAL_SORT(uint16_t)
+DEFINE_EXTERNAL_SORT(int16_t)
+DEFINE_EXTERNAL_SORT(uint32_t)
+DEFINE_EXTERNAL_SORT(int32_t)
+DEFINE_EXTERNAL_SORT(float)
+DEFINE_EXTERNAL_SORT(uint64_t)
+DEFINE_EXTERNAL_SORT(int64_t)
+DEFINE_EXTERNAL_SORT(double)
+#ifdef __FLT16_MAX__
+DEFINE_EXTERNAL_SORT(_Float16)
+#endif
+
+DEFINE_MMAP_SORT(uint16_t)
+DEFINE_MMAP_SORT(int16_t)
+DEFINE_MMAP_SORT(uint32_t)
+DEFINE_MMAP_SORT(int32_t)
+DEFINE_MMAP_SORT(float)
+DEFINE_MMAP_SORT(uint64_t)
+DEFINE_MMAP_SORT(int64_t)
+DEFINE_MMAP_SORT(double)
+#ifdef __FLT16_MAX__
+DEFINE_MMAP_SORT(_Float16)
+#endif
+
+DEFINE_MMAP_KEYVALUE_SORT_FORTYPE(uint64_t)
+DEFINE_MMAP_KEYVALUE_SORT_FORTYPE(int64_t)
+DEFINE_MMAP_KEYVALUE_SORT_FORTYPE(double)
+DEFINE_MMAP_KEYVALUE_SORT_FORTYPE(uint32_t)
+DEFINE_MMAP_KEYVALUE_SORT_FORTYPE(int32_t)
+DEFINE_MMAP_KEYVALUE_SORT_FORTYPE(float)
+
+} // namespace x86simdsort
@@ -1,38 +1,237 @@
 // ICL specific routines:
 #include "avx512-16bit-qsort.hpp"
+#include "xss-counting-sort.hpp"
+#include "xss-merge.hpp"
+#include "xss-parallel-numa-qsort.hpp"
+#include "xss-parallel-qsort.hpp"
+#include "xss-radix-sort.hpp"
 #include "x86simdsort-internal.h"
 
+/*
+ * 8-bit types are counting sorted, which also gives a valid result for
+ * qselect and partial_qsort
+ */
+#define DEFINE_8BIT_METHODS(type) \
+    template <> \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(hasnan); \
+        xss_counting_sort(arr, arrsize, descending); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(k); \
+        UNUSED(hasnan); \
+        xss_counting_sort(arr, arrsize, descending); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        UNUSED(k); \
+        UNUSED(hasnan); \
+        xss_counting_sort(arr, arrsize, descending); \
+    }
+
 namespace xss {
 namespace avx512 {
+    DEFINE_8BIT_METHODS(uint8_t)
+    DEFINE_8BIT_METHODS(int8_t)
+    template <>
+    void qsort(uint16_t *arr, size_t size, bool hasnan, bool descending)
+    {
+        if (size >= xss_radix_sort_threshold) {
+            xss_radix_sort(arr, size, descending);
+            return;
+        }
+        avx512_qsort(arr, size, hasnan, descending);
+    }
+    template <>
+    void qsort_parallel(
+            uint16_t *arr, size_t size, bool hasnan, const executor &exec)
+    {
+        avx512_qsort_parallel(arr, size, hasnan, xss_make_executor(exec));
+    }
+    template <>
+    void qsort_numa_parallel(uint16_t *arr,
+                             size_t size,
+                             bool hasnan,
+                             unsigned nthreads,
+                             unsigned ndomains)
+    {
+        avx512_qsort_numa_parallel(arr, size, hasnan, nthreads, ndomains);
+    }
+    template <>
+    void qsort_numa_parallel_exec(uint16_t *arr,
+                                  size_t size,
+                                  bool hasnan,
+                                  const std::vector<executor> &executors)
+    {
+        std::vector<xss_executor> execs = xss_make_executors(executors);
+        avx512_qsort_numa_parallel(
+                arr, size, hasnan, execs.data(), execs.size());
+    }
+    template <>
+    void qselect(uint16_t *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
+    {
+        avx512_qselect(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void qselect_parallel(uint16_t *arr,
+                          size_t k,
+                          size_t arrsize,
+                          bool hasnan,
+                          const executor &exec)
+    {
+        avx512_qselect_parallel(
+                arr, k, arrsize, hasnan, xss_make_executor(exec));
+    }
+    template <>
+    void partial_qsort(uint16_t *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
+    {
+        avx512_partial_qsort(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void merge(const uint16_t *a,
+               size_t na,
+               const uint16_t *b,
+               size_t nb,
+               uint16_t *out)
+    {
+        avx512_merge(a, na, b, nb, out);
+    }
+    template <>
+    void kway_merge(const uint16_t *const *runs,
+                    const size_t *sizes,
+                    size_t k,
+                    uint16_t *out)
+    {
+        avx512_kway_merge(runs, sizes, k, out);
+    }
+    template <>
+    void qsort(int16_t *arr, size_t size, bool hasnan, bool descending)
+    {
+        if (size >= xss_radix_sort_threshold) {
+            xss_radix_sort(arr, size, descending);
+            return;
+        }
+        avx512_qsort(arr, size, hasnan, descending);
+    }
+    template <>
+    void qsort_parallel(
+            int16_t *arr, size_t size, bool hasnan, const executor &exec)
+    {
+        avx512_qsort_parallel(arr, size, hasnan, xss_make_executor(exec));
+    }
+    template <>
+    void qsort_numa_parallel(int16_t *arr,
+                             size_t size,
+                             bool hasnan,
+                             unsigned nthreads,
+                             unsigned ndomains)
+    {
+        avx512_qsort_numa_parallel(arr, size, hasnan, nthreads, ndomains);
+    }
+    template <>
+    void qsort_numa_parallel_exec(int16_t *arr,
+                                  size_t size,
+                                  bool hasnan,
+                                  const std::vector<executor> &executors)
+    {
+        std::vector<xss_executor> execs = xss_make_executors(executors);
+        avx512_qsort_numa_parallel(
+                arr, size, hasnan, execs.data(), execs.size());
+    }
+    template <>
+    void qselect(int16_t *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
+    {
+        avx512_qselect(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void qselect_parallel(int16_t *arr,
+                          size_t k,
+                          size_t arrsize,
+                          bool hasnan,
+                          const executor &exec)
+    {
+        avx512_qselect_parallel(
+                arr, k, arrsize, hasnan, xss_make_executor(exec));
+    }
     template <>
-    void qsort(uint16_t *arr, size_t size, bool hasnan)
+    void partial_qsort(int16_t *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
     {
-        avx512_qsort(arr, size, hasnan);
+        avx512_partial_qsort(arr, k, arrsize, hasnan, descending);
     }
     template <>
-    void qselect(uint16_t *arr, size_t k, size_t arrsize, bool hasnan)
+    void merge(const int16_t *a,
+               size_t na,
+               const int16_t *b,
+               size_t nb,
+               int16_t *out)
     {
-        avx512_qselect(arr, k, arrsize, hasnan);
+        avx512_merge(a, na, b, nb, out);
     }
     template <>
-    void partial_qsort(uint16_t *arr, size_t k, size_t arrsize, bool hasnan)
+    void kway_merge(const int16_t *const *runs,
+                    const size_t *sizes,
+                    size_t k,
+                    int16_t *out)
     {
-        avx512_partial_qsort(arr, k, arrsize, hasnan);
+        avx512_kway_merge(runs, sizes, k, out);
     }
+    /* bfloat16 is sorted as the int16_t of the same order */
     template <>
-    void qsort(int16_t *arr, size_t size, bool hasnan)
+    void qsort(bfloat16 *arr, size_t size, bool hasnan, bool descending)
     {
-        avx512_qsort(arr, size, hasnan);
+        UNUSED(hasnan);
+        uint16_t *bits = reinterpret_cast<uint16_t *>(arr);
+        xss_sort_bf16(bits, size, [=](int16_t *keys) {
+            qsort(keys, size, false, descending);
+        });
     }
     template <>
-    void qselect(int16_t *arr, size_t k, size_t arrsize, bool hasnan)
+    void qselect(bfloat16 *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
     {
-        avx512_qselect(arr, k, arrsize, hasnan);
+        avx512_qselect_bf16(reinterpret_cast<uint16_t *>(arr),
+                            k,
+                            arrsize,
+                            hasnan,
+                            descending);
     }
     template <>
-    void partial_qsort(int16_t *arr, size_t k, size_t arrsize, bool hasnan)
+    void partial_qsort(bfloat16 *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
     {
-        avx512_partial_qsort(arr, k, arrsize, hasnan);
+        avx512_partial_qsort_bf16(reinterpret_cast<uint16_t *>(arr),
+                                  k,
+                                  arrsize,
+                                  hasnan,
+                                  descending);
     }
 } // namespace avx512
 } // namespace xss
@@ -5,80 +5,467 @@
 #include <vector>
 
 namespace xss {
+using executor = x86simdsort::executor;
+using bfloat16 = x86simdsort::bfloat16;
+using uint128 = x86simdsort::uint128;
 namespace avx512 {
     // quicksort
     template <typename T>
-    XSS_HIDE_SYMBOL void qsort(T *arr, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void qsort(T *arr,
+                               size_t arrsize,
+                               bool hasnan = false,
+                               bool descending = false);
+    // multi-threaded quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void qsort_parallel(T *arr,
+                                        size_t arrsize,
+                                        bool hasnan,
+                                        const executor &exec);
+    // NUMA-aware multi-threaded quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void qsort_numa_parallel(T *arr,
+                                             size_t arrsize,
+                                             bool hasnan,
+                                             unsigned nthreads,
+                                             unsigned ndomains);
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    qsort_numa_parallel_exec(T *arr,
+                             size_t arrsize,
+                             bool hasnan,
+                             const std::vector<executor> &executors);
+    // hybrid MSD radix sort / quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void radix_qsort(T *arr, size_t arrsize);
     // key-value quicksort
     template <typename T1, typename T2>
-    XSS_EXPORT_SYMBOL void
-    keyvalue_qsort(T1 *key, T2 *val, size_t arrsize, bool hasnan = false);
+    XSS_EXPORT_SYMBOL void keyvalue_qsort(T1 *key,
+                                          T2 *val,
+                                          size_t arrsize,
+                                          bool hasnan = false,
+                                          bool descending = false);
+    // multi-threaded key-value quicksort
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void keyvalue_qsort_parallel(T1 *key,
+                                                   T2 *val,
+                                                   size_t arrsize,
+                                                   bool hasnan,
+                                                   const executor &exec);
     // quickselect
     template <typename T>
-    XSS_HIDE_SYMBOL void
-    qselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void qselect(T *arr,
+                                 size_t k,
+                                 size_t arrsize,
+                                 bool hasnan = false,
+                                 bool descending = false);
+    // multi-threaded quickselect
+    template <typename T>
+    XSS_HIDE_SYMBOL void qselect_parallel(T *arr,
+                                          size_t k,
+                                          size_t arrsize,
+                                          bool hasnan,
+                                          const executor &exec);
     // partial sort
     template <typename T>
-    XSS_HIDE_SYMBOL void
-    partial_qsort(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void partial_qsort(T *arr,
+                                       size_t k,
+                                       size_t arrsize,
+                                       bool hasnan = false,
+                                       bool descending = false);
     // argsort
     template <typename T>
-    XSS_HIDE_SYMBOL std::vector<size_t>
-    argsort(T *arr, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL std::vector<size_t> argsort(T *arr,
+                                                size_t arrsize,
+                                                bool hasnan = false,
+                                                bool descending = false);
+    // multi-threaded argsort
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t> argsort_parallel(T *arr,
+                                                         size_t arrsize,
+                                                         bool hasnan,
+                                                         const executor &exec);
     // argselect
     template <typename T>
     XSS_HIDE_SYMBOL std::vector<size_t>
     argselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    // argsort into a buffer of the caller
+    template <typename T>
+    XSS_HIDE_SYMBOL void argsort_into(T *arr,
+                                      size_t *arg,
+                                      size_t arrsize,
+                                      bool hasnan = false,
+                                      bool descending = false,
+                                      bool init_arg = true);
+    // argselect into a buffer of the caller
+    template <typename T>
+    XSS_HIDE_SYMBOL void argselect_into(T *arr,
+                                        size_t *arg,
+                                        size_t k,
+                                        size_t arrsize,
+                                        bool hasnan = false,
+                                        bool init_arg = true);
+    // argsort into a buffer of uint32_t indices
+    template <typename T>
+    XSS_HIDE_SYMBOL void argsort32_into(T *arr,
+                                        uint32_t *arg,
+                                        size_t arrsize,
+                                        bool hasnan = false,
+                                        bool descending = false,
+                                        bool init_arg = true);
+    // argselect into a buffer of uint32_t indices
+    template <typename T>
+    XSS_HIDE_SYMBOL void argselect32_into(T *arr,
+                                          uint32_t *arg,
+                                          size_t k,
+                                          size_t arrsize,
+                                          bool hasnan = false,
+                                          bool init_arg = true);
+    // stable sort
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    stable_qsort(T *arr, size_t arrsize, bool hasnan = false);
+    // stable argsort
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t>
+    stable_argsort(T *arr, size_t arrsize, bool hasnan = false);
+    // stable key-value sort
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void stable_keyvalue_qsort(T1 *key,
+                                                 T2 *val,
+                                                 size_t arrsize,
+                                                 bool hasnan = false);
+    // merge
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    merge(const T *a, size_t na, const T *b, size_t nb, T *out);
+    // k-way merge
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    kway_merge(const T *const *runs, const size_t *sizes, size_t k, T *out);
+    // key-value merge
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void keyvalue_merge(const T1 *akey,
+                                          const T2 *aval,
+                                          size_t na,
+                                          const T1 *bkey,
+                                          const T2 *bval,
+                                          size_t nb,
+                                          T1 *outkey,
+                                          T2 *outval);
+    // multi-threaded argselect
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t>
+    argselect_parallel(T *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       const executor &exec);
 } // namespace avx512
 namespace avx2 {
     // quicksort
     template <typename T>
-    XSS_HIDE_SYMBOL void qsort(T *arr, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void qsort(T *arr,
+                               size_t arrsize,
+                               bool hasnan = false,
+                               bool descending = false);
+    // multi-threaded quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void qsort_parallel(T *arr,
+                                        size_t arrsize,
+                                        bool hasnan,
+                                        const executor &exec);
+    // NUMA-aware multi-threaded quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void qsort_numa_parallel(T *arr,
+                                             size_t arrsize,
+                                             bool hasnan,
+                                             unsigned nthreads,
+                                             unsigned ndomains);
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    qsort_numa_parallel_exec(T *arr,
+                             size_t arrsize,
+                             bool hasnan,
+                             const std::vector<executor> &executors);
+    // hybrid MSD radix sort / quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void radix_qsort(T *arr, size_t arrsize);
     // key-value quicksort
     template <typename T1, typename T2>
-    XSS_EXPORT_SYMBOL void
-    keyvalue_qsort(T1 *key, T2 *val, size_t arrsize, bool hasnan = false);
+    XSS_EXPORT_SYMBOL void keyvalue_qsort(T1 *key,
+                                          T2 *val,
+                                          size_t arrsize,
+                                          bool hasnan = false,
+                                          bool descending = false);
+    // multi-threaded key-value quicksort
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void keyvalue_qsort_parallel(T1 *key,
+                                                   T2 *val,
+                                                   size_t arrsize,
+                                                   bool hasnan,
+                                                   const executor &exec);
     // quickselect
     template <typename T>
-    XSS_HIDE_SYMBOL void
-    qselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void qselect(T *arr,
+                                 size_t k,
+                                 size_t arrsize,
+                                 bool hasnan = false,
+                                 bool descending = false);
+    // multi-threaded quickselect
+    template <typename T>
+    XSS_HIDE_SYMBOL void qselect_parallel(T *arr,
+                                          size_t k,
+                                          size_t arrsize,
+                                          bool hasnan,
+                                          const executor &exec);
     // partial sort
     template <typename T>
-    XSS_HIDE_SYMBOL void
-    partial_qsort(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void partial_qsort(T *arr,
+                                       size_t k,
+                                       size_t arrsize,
+                                       bool hasnan = false,
+                                       bool descending = false);
     // argsort
     template <typename T>
-    XSS_HIDE_SYMBOL std::vector<size_t>
-    argsort(T *arr, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL std::vector<size_t> argsort(T *arr,
+                                                size_t arrsize,
+                                                bool hasnan = false,
+                                                bool descending = false);
+    // multi-threaded argsort
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t> argsort_parallel(T *arr,
+                                                         size_t arrsize,
+                                                         bool hasnan,
+                                                         const executor &exec);
     // argselect
     template <typename T>
     XSS_HIDE_SYMBOL std::vector<size_t>
     argselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    // argsort into a buffer of the caller
+    template <typename T>
+    XSS_HIDE_SYMBOL void argsort_into(T *arr,
+                                      size_t *arg,
+                                      size_t arrsize,
+                                      bool hasnan = false,
+                                      bool descending = false,
+                                      bool init_arg = true);
+    // argselect into a buffer of the caller
+    template <typename T>
+    XSS_HIDE_SYMBOL void argselect_into(T *arr,
+                                        size_t *arg,
+                                        size_t k,
+                                        size_t arrsize,
+                                        bool hasnan = false,
+                                        bool init_arg = true);
+    // argsort into a buffer of uint32_t indices
+    template <typename T>
+    XSS_HIDE_SYMBOL void argsort32_into(T *arr,
+                                        uint32_t *arg,
+                                        size_t arrsize,
+                                        bool hasnan = false,
+                                        bool descending = false,
+                                        bool init_arg = true);
+    // argselect into a buffer of uint32_t indices
+    template <typename T>
+    XSS_HIDE_SYMBOL void argselect32_into(T *arr,
+                                          uint32_t *arg,
+                                          size_t k,
+                                          size_t arrsize,
+                                          bool hasnan = false,
+                                          bool init_arg = true);
+    // stable sort
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    stable_qsort(T *arr, size_t arrsize, bool hasnan = false);
+    // stable argsort
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t>
+    stable_argsort(T *arr, size_t arrsize, bool hasnan = false);
+    // stable key-value sort
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void stable_keyvalue_qsort(T1 *key,
+                                                 T2 *val,
+                                                 size_t arrsize,
+                                                 bool hasnan = false);
+    // merge
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    merge(const T *a, size_t na, const T *b, size_t nb, T *out);
+    // k-way merge
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    kway_merge(const T *const *runs, const size_t *sizes, size_t k, T *out);
+    // key-value merge
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void keyvalue_merge(const T1 *akey,
+                                          const T2 *aval,
+                                          size_t na,
+                                          const T1 *bkey,
+                                          const T2 *bval,
+                                          size_t nb,
+                                          T1 *outkey,
+                                          T2 *outval);
+    // multi-threaded argselect
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t>
+    argselect_parallel(T *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       const executor &exec);
 } // namespace avx2
 namespace scalar {
     // quicksort
     template <typename T>
-    XSS_HIDE_SYMBOL void qsort(T *arr, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void qsort(T *arr,
+                               size_t arrsize,
+                               bool hasnan = false,
+                               bool descending = false);
+    // multi-threaded quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void qsort_parallel(T *arr,
+                                        size_t arrsize,
+                                        bool hasnan,
+                                        const executor &exec);
+    // NUMA-aware multi-threaded quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void qsort_numa_parallel(T *arr,
+                                             size_t arrsize,
+                                             bool hasnan,
+                                             unsigned nthreads,
+                                             unsigned ndomains);
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    qsort_numa_parallel_exec(T *arr,
+                             size_t arrsize,
+                             bool hasnan,
+                             const std::vector<executor> &executors);
+    // hybrid MSD radix sort / quicksort
+    template <typename T>
+    XSS_HIDE_SYMBOL void radix_qsort(T *arr, size_t arrsize);
     // key-value quicksort
     template <typename T1, typename T2>
-    XSS_EXPORT_SYMBOL void
-    keyvalue_qsort(T1 *key, T2 *val, size_t arrsize, bool hasnan = false);
+    XSS_EXPORT_SYMBOL void keyvalue_qsort(T1 *key,
+                                          T2 *val,
+                                          size_t arrsize,
+                                          bool hasnan = false,
+                                          bool descending = false);
+    // multi-threaded key-value quicksort
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void keyvalue_qsort_parallel(T1 *key,
+                                                   T2 *val,
+                                                   size_t arrsize,
+                                                   bool hasnan,
+                                                   const executor &exec);
     // quickselect
     template <typename T>
-    XSS_HIDE_SYMBOL void
-    qselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void qselect(T *arr,
+                                 size_t k,
+                                 size_t arrsize,
+                                 bool hasnan = false,
+                                 bool descending = false);
+    // multi-threaded quickselect
+    template <typename T>
+    XSS_HIDE_SYMBOL void qselect_parallel(T *arr,
+                                          size_t k,
+                                          size_t arrsize,
+                                          bool hasnan,
+                                          const executor &exec);
     // partial sort
     template <typename T>
-    XSS_HIDE_SYMBOL void
-    partial_qsort(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL void partial_qsort(T *arr,
+                                       size_t k,
+                                       size_t arrsize,
+                                       bool hasnan = false,
+                                       bool descending = false);
     // argsort
     template <typename T>
-    XSS_HIDE_SYMBOL std::vector<size_t>
-    argsort(T *arr, size_t arrsize, bool hasnan = false);
+    XSS_HIDE_SYMBOL std::vector<size_t> argsort(T *arr,
+                                                size_t arrsize,
+                                                bool hasnan = false,
+                                                bool descending = false);
+    // multi-threaded argsort
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t> argsort_parallel(T *arr,
+                                                         size_t arrsize,
+                                                         bool hasnan,
+                                                         const executor &exec);
     // argselect
     template <typename T>
     XSS_HIDE_SYMBOL std::vector<size_t>
     argselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+    // argsort into a buffer of the caller
+    template <typename T>
+    XSS_HIDE_SYMBOL void argsort_into(T *arr,
+                                      size_t *arg,
+                                      size_t arrsize,
+                                      bool hasnan = false,
+                                      bool descending = false,
+                                      bool init_arg = true);
+    // argselect into a buffer of the caller
+    template <typename T>
+    XSS_HIDE_SYMBOL void argselect_into(T *arr,
+                                        size_t *arg,
+                                        size_t k,
+                                        size_t arrsize,
+                                        bool hasnan = false,
+                                        bool init_arg = true);
+    // argsort into a buffer of uint32_t indices
+    template <typename T>
+    XSS_HIDE_SYMBOL void argsort32_into(T *arr,
+                                        uint32_t *arg,
+                                        size_t arrsize,
+                                        bool hasnan = false,
+                                        bool descending = false,
+                                        bool init_arg = true);
+    // argselect into a buffer of uint32_t indices
+    template <typename T>
+    XSS_HIDE_SYMBOL void argselect32_into(T *arr,
+                                          uint32_t *arg,
+                                          size_t k,
+                                          size_t arrsize,
+                                          bool hasnan = false,
+                                          bool init_arg = true);
+    // stable sort
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    stable_qsort(T *arr, size_t arrsize, bool hasnan = false);
+    // stable argsort
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t>
+    stable_argsort(T *arr, size_t arrsize, bool hasnan = false);
+    // stable key-value sort
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void stable_keyvalue_qsort(T1 *key,
+                                                 T2 *val,
+                                                 size_t arrsize,
+                                                 bool hasnan = false);
+    // merge
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    merge(const T *a, size_t na, const T *b, size_t nb, T *out);
+    // k-way merge
+    template <typename T>
+    XSS_HIDE_SYMBOL void
+    kway_merge(const T *const *runs, const size_t *sizes, size_t k, T *out);
+    // key-value merge
+    template <typename T1, typename T2>
+    XSS_EXPORT_SYMBOL void keyvalue_merge(const T1 *akey,
+                                          const T2 *aval,
+                                          size_t na,
+                                          const T1 *bkey,
+                                          const T2 *bval,
+                                          size_t nb,
+                                          T1 *outkey,
+                                          T2 *outval);
+    // multi-threaded argselect
+    template <typename T>
+    XSS_HIDE_SYMBOL std::vector<size_t>
+    argselect_parallel(T *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       const executor &exec);
 } // namespace scalar
 } // namespace xss
 #endif
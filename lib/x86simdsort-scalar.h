@@ -1,7 +1,29 @@
 #include "custom-compare.h"
+#include "x86simdsort.h"
+#include "x86simdsort-internal.h"
 #include <algorithm>
 #include <numeric>
 
+/*
+ * bfloat16 compares as an int16_t of the same order: negative values have
+ * their magnitude bits flipped and every NaN is INT16_MAX
+ */
+template <template <typename> class Comparator>
+struct compare<x86simdsort::bfloat16, Comparator<x86simdsort::bfloat16>> {
+    static int16_t key(const x86simdsort::bfloat16 a)
+    {
+        if ((a.bits & 0x7fff) > 0x7f80) {
+            return std::numeric_limits<int16_t>::max();
+        }
+        return (int16_t)((a.bits & 0x8000) ? (a.bits ^ 0x7fff) : a.bits);
+    }
+    bool operator()(const x86simdsort::bfloat16 a,
+                    const x86simdsort::bfloat16 b)
+    {
+        return Comparator<int16_t>()(key(a), key(b));
+    }
+};
+
 namespace xss {
 namespace utils {
     /* O(1) permute array in place: stolen from
@@ -24,10 +46,20 @@ namespace utils {
 } // namespace utils
 
 namespace scalar {
+    using executor = x86simdsort::executor;
     template <typename T>
-    void qsort(T *arr, size_t arrsize, bool hasnan)
+    void
+    qsort(T *arr, size_t arrsize, bool hasnan, bool descending)
     {
-        if (hasnan) {
+        if (descending) {
+            if (hasnan) {
+                std::sort(arr, arr + arrsize, compare<T, std::greater<T>>());
+            }
+            else {
+                std::sort(arr, arr + arrsize, std::greater<T>());
+            }
+        }
+        else if (hasnan) {
             std::sort(arr, arr + arrsize, compare<T, std::less<T>>());
         }
         else {
@@ -35,9 +67,58 @@ namespace scalar {
         }
     }
     template <typename T>
-    void qselect(T *arr, size_t k, size_t arrsize, bool hasnan)
+    void
+    qsort_parallel(T *arr, size_t arrsize, bool hasnan, const executor &exec)
     {
-        if (hasnan) {
+        /* The scalar fallback is single threaded */
+        UNUSED(exec);
+        qsort(arr, arrsize, hasnan);
+    }
+    template <typename T>
+    void qsort_numa_parallel(T *arr,
+                             size_t arrsize,
+                             bool hasnan,
+                             unsigned nthreads,
+                             unsigned ndomains)
+    {
+        UNUSED(nthreads);
+        UNUSED(ndomains);
+        qsort(arr, arrsize, hasnan);
+    }
+    template <typename T>
+    void qsort_numa_parallel_exec(T *arr,
+                                  size_t arrsize,
+                                  bool hasnan,
+                                  const std::vector<executor> &executors)
+    {
+        UNUSED(executors);
+        qsort(arr, arrsize, hasnan);
+    }
+    template <typename T>
+    void radix_qsort(T *arr, size_t arrsize)
+    {
+        std::sort(arr, arr + arrsize);
+    }
+    template <typename T>
+    void qselect(T *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
+    {
+        if (descending) {
+            if (hasnan) {
+                std::nth_element(arr,
+                                 arr + k,
+                                 arr + arrsize,
+                                 compare<T, std::greater<T>>());
+            }
+            else {
+                std::nth_element(
+                        arr, arr + k, arr + arrsize, std::greater<T>());
+            }
+        }
+        else if (hasnan) {
             std::nth_element(
                     arr, arr + k, arr + arrsize, compare<T, std::less<T>>());
         }
@@ -46,9 +127,32 @@ namespace scalar {
         }
     }
     template <typename T>
-    void partial_qsort(T *arr, size_t k, size_t arrsize, bool hasnan)
+    void qselect_parallel(
+            T *arr, size_t k, size_t arrsize, bool hasnan, const executor &exec)
     {
-        if (hasnan) {
+        UNUSED(exec);
+        qselect(arr, k, arrsize, hasnan);
+    }
+    template <typename T>
+    void partial_qsort(T *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
+    {
+        if (descending) {
+            if (hasnan) {
+                std::partial_sort(arr,
+                                  arr + k,
+                                  arr + arrsize,
+                                  compare<T, std::greater<T>>());
+            }
+            else {
+                std::partial_sort(
+                        arr, arr + k, arr + arrsize, std::greater<T>());
+            }
+        }
+        else if (hasnan) {
             std::partial_sort(
                     arr, arr + k, arr + arrsize, compare<T, std::less<T>>());
         }
@@ -57,12 +161,23 @@ namespace scalar {
         }
     }
     template <typename T>
-    std::vector<size_t> argsort(T *arr, size_t arrsize, bool hasnan)
+    std::vector<size_t> argsort(T *arr,
+                                size_t arrsize,
+                                bool hasnan,
+                                bool descending)
     {
         UNUSED(hasnan);
         std::vector<size_t> arg(arrsize);
         std::iota(arg.begin(), arg.end(), 0);
-        std::sort(arg.begin(), arg.end(), compare_arg<T, std::less<T>>(arr));
+        if (descending) {
+            std::sort(arg.begin(),
+                      arg.end(),
+                      compare_arg<T, std::greater<T>>(arr));
+        }
+        else {
+            std::sort(
+                    arg.begin(), arg.end(), compare_arg<T, std::less<T>>(arr));
+        }
         return arg;
     }
     template <typename T>
@@ -77,13 +192,244 @@ namespace scalar {
                          compare_arg<T, std::less<T>>(arr));
         return arg;
     }
+    template <typename T>
+    void argsort_into(T *arr,
+                      size_t *arg,
+                      size_t arrsize,
+                      bool hasnan,
+                      bool descending,
+                      bool init_arg)
+    {
+        UNUSED(hasnan);
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); }
+        if (descending) {
+            std::sort(arg, arg + arrsize, compare_arg<T, std::greater<T>>(arr));
+        }
+        else {
+            std::sort(arg, arg + arrsize, compare_arg<T, std::less<T>>(arr));
+        }
+    }
+    template <typename T>
+    void argselect_into(T *arr,
+                        size_t *arg,
+                        size_t k,
+                        size_t arrsize,
+                        bool hasnan,
+                        bool init_arg)
+    {
+        UNUSED(hasnan);
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); }
+        std::nth_element(arg,
+                         arg + k,
+                         arg + arrsize,
+                         compare_arg<T, std::less<T>>(arr));
+    }
+    template <typename T>
+    void argsort32_into(T *arr,
+                        uint32_t *arg,
+                        size_t arrsize,
+                        bool hasnan,
+                        bool descending,
+                        bool init_arg)
+    {
+        UNUSED(hasnan);
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); }
+        if (descending) {
+            std::sort(arg, arg + arrsize, compare_arg<T, std::greater<T>>(arr));
+        }
+        else {
+            std::sort(arg, arg + arrsize, compare_arg<T, std::less<T>>(arr));
+        }
+    }
+    template <typename T>
+    void argselect32_into(T *arr,
+                          uint32_t *arg,
+                          size_t k,
+                          size_t arrsize,
+                          bool hasnan,
+                          bool init_arg)
+    {
+        UNUSED(hasnan);
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); }
+        std::nth_element(arg,
+                         arg + k,
+                         arg + arrsize,
+                         compare_arg<T, std::less<T>>(arr));
+    }
+    template <typename T>
+    std::vector<size_t>
+    argsort_parallel(T *arr, size_t arrsize, bool hasnan, const executor &exec)
+    {
+        UNUSED(exec);
+        return argsort(arr, arrsize, hasnan);
+    }
+    template <typename T>
+    std::vector<size_t> argselect_parallel(
+            T *arr, size_t k, size_t arrsize, bool hasnan, const executor &exec)
+    {
+        UNUSED(exec);
+        return argselect(arr, k, arrsize, hasnan);
+    }
+    template <typename T1, typename T2>
+    void keyvalue_qsort(T1 *key,
+                        T2 *val,
+                        size_t arrsize,
+                        bool hasnan,
+                        bool descending)
+    {
+        std::vector<size_t> arg = argsort(key, arrsize, hasnan, descending);
+        utils::apply_permutation_in_place(key, arg);
+        utils::apply_permutation_in_place(val, arg);
+    }
+    template <typename T1, typename T2>
+    void keyvalue_qsort_parallel(
+            T1 *key, T2 *val, size_t arrsize, bool hasnan, const executor &exec)
+    {
+        UNUSED(exec);
+        keyvalue_qsort(key, val, arrsize, hasnan);
+    }
+    template <typename T>
+    void stable_qsort(T *arr, size_t arrsize, bool hasnan)
+    {
+        if (hasnan) {
+            std::stable_sort(arr, arr + arrsize, compare<T, std::less<T>>());
+        }
+        else {
+            std::stable_sort(arr, arr + arrsize);
+        }
+    }
+    template <typename T>
+    std::vector<size_t> stable_argsort(T *arr, size_t arrsize, bool hasnan)
+    {
+        UNUSED(hasnan);
+        std::vector<size_t> arg(arrsize);
+        std::iota(arg.begin(), arg.end(), 0);
+        std::stable_sort(
+                arg.begin(), arg.end(), compare_arg<T, std::less<T>>(arr));
+        return arg;
+    }
     template <typename T1, typename T2>
-    void keyvalue_qsort(T1 *key, T2 *val, size_t arrsize, bool hasnan)
+    void stable_keyvalue_qsort(T1 *key, T2 *val, size_t arrsize, bool hasnan)
     {
-        std::vector<size_t> arg = argsort(key, arrsize, hasnan);
+        std::vector<size_t> arg = stable_argsort(key, arrsize, hasnan);
         utils::apply_permutation_in_place(key, arg);
         utils::apply_permutation_in_place(val, arg);
     }
+    template <typename T>
+    void merge(const T *a, size_t na, const T *b, size_t nb, T *out)
+    {
+        std::merge(a, a + na, b, b + nb, out, compare<T, std::less<T>>());
+    }
+    template <typename T>
+    void kway_merge(const T *const *runs, const size_t *sizes, size_t k, T *out)
+    {
+        /* Heap of the unconsumed parts of the runs, smallest head on top */
+        auto less = compare<T, std::less<T>>();
+        std::vector<std::pair<const T *, const T *>> heads;
+        for (size_t i = 0; i < k; ++i) {
+            if (sizes[i] != 0) {
+                heads.push_back({runs[i], runs[i] + sizes[i]});
+            }
+        }
+        auto greater = [&less](const auto &x, const auto &y) {
+            return less(*y.first, *x.first);
+        };
+        std::make_heap(heads.begin(), heads.end(), greater);
+        while (!heads.empty()) {
+            std::pop_heap(heads.begin(), heads.end(), greater);
+            *out++ = *heads.back().first++;
+            if (heads.back().first == heads.back().second) { heads.pop_back(); }
+            else {
+                std::push_heap(heads.begin(), heads.end(), greater);
+            }
+        }
+    }
+    template <typename T1, typename T2>
+    void keyvalue_merge(const T1 *akey,
+                        const T2 *aval,
+                        size_t na,
+                        const T1 *bkey,
+                        const T2 *bval,
+                        size_t nb,
+                        T1 *outkey,
+                        T2 *outval)
+    {
+        auto less = compare<T1, std::less<T1>>();
+        size_t i = 0, j = 0;
+        while (i < na && j < nb) {
+            if (less(bkey[j], akey[i])) {
+                *outkey++ = bkey[j];
+                *outval++ = bval[j++];
+            }
+            else {
+                *outkey++ = akey[i];
+                *outval++ = aval[i++];
+            }
+        }
+        std::copy(akey + i, akey + na, outkey);
+        std::copy(aval + i, aval + na, outval);
+        std::copy(bkey + j, bkey + nb, outkey + (na - i));
+        std::copy(bval + j, bval + nb, outval + (na - i));
+    }
 
+    /* bfloat16 has no operator<, NaNs are always handled by compare */
+    template <>
+    inline void
+    qsort(bfloat16 *arr, size_t arrsize, bool hasnan, bool descending)
+    {
+        UNUSED(hasnan);
+        if (descending) {
+            std::sort(arr,
+                      arr + arrsize,
+                      compare<bfloat16, std::greater<bfloat16>>());
+        }
+        else {
+            std::sort(arr,
+                      arr + arrsize,
+                      compare<bfloat16, std::less<bfloat16>>());
+        }
+    }
+    template <>
+    inline void qselect(bfloat16 *arr,
+                        size_t k,
+                        size_t arrsize,
+                        bool hasnan,
+                        bool descending)
+    {
+        UNUSED(hasnan);
+        if (descending) {
+            std::nth_element(arr,
+                             arr + k,
+                             arr + arrsize,
+                             compare<bfloat16, std::greater<bfloat16>>());
+        }
+        else {
+            std::nth_element(arr,
+                             arr + k,
+                             arr + arrsize,
+                             compare<bfloat16, std::less<bfloat16>>());
+        }
+    }
+    template <>
+    inline void partial_qsort(bfloat16 *arr,
+                              size_t k,
+                              size_t arrsize,
+                              bool hasnan,
+                              bool descending)
+    {
+        UNUSED(hasnan);
+        if (descending) {
+            std::partial_sort(arr,
+                              arr + k,
+                              arr + arrsize,
+                              compare<bfloat16, std::greater<bfloat16>>());
+        }
+        else {
+            std::partial_sort(arr,
+                              arr + k,
+                              arr + arrsize,
+                              compare<bfloat16, std::less<bfloat16>>());
+        }
+    }
 } // namespace scalar
 } // namespace xss
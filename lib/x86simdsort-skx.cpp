@@ -3,66 +3,508 @@
 #include "avx512-64bit-keyvaluesort.hpp"
 #include "avx512-64bit-argsort.hpp"
 #include "avx512-64bit-qsort.hpp"
+#include "avx512-128bit-qsort.hpp"
+#include "xss-bfloat16.hpp"
+#include "xss-parallel-argsort.hpp"
+#include "xss-parallel-keyvaluesort.hpp"
+#include "xss-parallel-numa-qsort.hpp"
+#include "xss-parallel-qsort.hpp"
+#include "xss-merge.hpp"
+#include "xss-radix-qsort.hpp"
+#include "xss-stable-sort.hpp"
 #include "x86simdsort-internal.h"
 
 #define DEFINE_ALL_METHODS(type) \
     template <> \
-    void qsort(type *arr, size_t arrsize, bool hasnan) \
+    void qsort(type *arr, size_t arrsize, bool hasnan, bool descending) \
     { \
-        avx512_qsort(arr, arrsize, hasnan); \
+        avx512_qsort(arr, arrsize, hasnan, descending); \
     } \
     template <> \
-    void qselect(type *arr, size_t k, size_t arrsize, bool hasnan) \
+    void qsort_parallel( \
+            type *arr, size_t arrsize, bool hasnan, const executor &exec) \
     { \
-        avx512_qselect(arr, k, arrsize, hasnan); \
+        avx512_qsort_parallel(arr, arrsize, hasnan, xss_make_executor(exec)); \
     } \
     template <> \
-    void partial_qsort(type *arr, size_t k, size_t arrsize, bool hasnan) \
+    void qsort_numa_parallel(type *arr, \
+                             size_t arrsize, \
+                             bool hasnan, \
+                             unsigned nthreads, \
+                             unsigned ndomains) \
     { \
-        avx512_partial_qsort(arr, k, arrsize, hasnan); \
+        avx512_qsort_numa_parallel(arr, arrsize, hasnan, nthreads, ndomains); \
     } \
     template <> \
-    std::vector<size_t> argsort(type *arr, size_t arrsize, bool hasnan) \
+    void qsort_numa_parallel_exec(type *arr, \
+                                  size_t arrsize, \
+                                  bool hasnan, \
+                                  const std::vector<executor> &executors) \
     { \
-        return avx512_argsort(arr, arrsize, hasnan); \
+        std::vector<xss_executor> execs = xss_make_executors(executors); \
+        avx512_qsort_numa_parallel( \
+                arr, arrsize, hasnan, execs.data(), execs.size()); \
+    } \
+    template <> \
+    void qselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx512_qselect(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void qselect_parallel(type *arr, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          const executor &exec) \
+    { \
+        avx512_qselect_parallel( \
+                arr, k, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void partial_qsort( \
+            type *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx512_partial_qsort(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    std::vector<size_t> argsort( \
+            type *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        return avx512_argsort(arr, arrsize, hasnan, descending); \
     } \
     template <> \
     std::vector<size_t> argselect( \
             type *arr, size_t k, size_t arrsize, bool hasnan) \
     { \
         return avx512_argselect(arr, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort_into(type *arr, \
+                      size_t *arg, \
+                      size_t arrsize, \
+                      bool hasnan, \
+                      bool descending, \
+                      bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect_into(type *arr, \
+                        size_t *arg, \
+                        size_t k, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort32_into(type *arr, \
+                        uint32_t *arg, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect32_into(type *arr, \
+                          uint32_t *arg, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect(arr, arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> argsort_parallel( \
+            type *arr, size_t arrsize, bool hasnan, const executor &exec) \
+    { \
+        return avx512_argsort_parallel( \
+                arr, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    std::vector<size_t> argselect_parallel(type *arr, \
+                                           size_t k, \
+                                           size_t arrsize, \
+                                           bool hasnan, \
+                                           const executor &exec) \
+    { \
+        return avx512_argselect_parallel( \
+                arr, k, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void stable_qsort(type *arr, size_t arrsize, bool hasnan) \
+    { \
+        avx512_stable_qsort(arr, arrsize, hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> stable_argsort( \
+            type *arr, size_t arrsize, bool hasnan) \
+    { \
+        return avx512_stable_argsort(arr, arrsize, hasnan); \
+    } \
+    template <> \
+    void merge(const type *a, size_t na, const type *b, size_t nb, type *out) \
+    { \
+        avx512_merge(a, na, b, nb, out); \
+    } \
+    template <> \
+    void kway_merge( \
+            const type *const *runs, const size_t *sizes, size_t k, type *out) \
+    { \
+        avx512_kway_merge(runs, sizes, k, out); \
+    }
+
+#define DEFINE_KEYVALUE_METHODS_PAIR(type1, type2) \
+    template <> \
+    void keyvalue_qsort(type1 *key, \
+                        type2 *val, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        avx512_qsort_kv(key, val, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void keyvalue_qsort_parallel(type1 *key, \
+                                 type2 *val, \
+                                 size_t arrsize, \
+                                 bool hasnan, \
+                                 const executor &exec) \
+    { \
+        avx512_qsort_kv_parallel( \
+                key, val, arrsize, hasnan, xss_make_executor(exec)); \
+    } \
+    template <> \
+    void stable_keyvalue_qsort( \
+            type1 *key, type2 *val, size_t arrsize, bool hasnan) \
+    { \
+        avx512_stable_qsort_kv(key, val, arrsize, hasnan); \
+    } \
+    template <> \
+    void keyvalue_merge(const type1 *akey, \
+                        const type2 *aval, \
+                        size_t na, \
+                        const type1 *bkey, \
+                        const type2 *bval, \
+                        size_t nb, \
+                        type1 *outkey, \
+                        type2 *outval) \
+    { \
+        avx512_merge_kv(akey, aval, na, bkey, bval, nb, outkey, outval); \
     }
 
 #define DEFINE_KEYVALUE_METHODS(type) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, uint64_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, int64_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, double) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, uint32_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, int32_t) \
+    DEFINE_KEYVALUE_METHODS_PAIR(type, float)
+
+/*
+ * 16-bit keys only have the quicksort, which packs every key with its value
+ * (or its index) into a 32-bit or 64-bit word
+ */
+#define DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type1, type2) \
+    template <> \
+    void keyvalue_qsort(type1 *key, \
+                        type2 *val, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending) \
+    { \
+        avx512_qsort_kv(key, val, arrsize, hasnan, descending); \
+    }
+
+#define DEFINE_16BIT_KEYVALUE_QSORT(type) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, uint64_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, int64_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, double) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, uint32_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, int32_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, float) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, uint16_t) \
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(type, int16_t)
+
+/*
+ * 16-bit dtypes only have the argsort and argselect of xss-packed-16bit.hpp,
+ * which pack every key with its index into a 64-bit word
+ */
+#define DEFINE_16BIT_ARG_METHODS(type) \
     template <> \
-    void keyvalue_qsort(type *key, uint64_t *val, size_t arrsize, bool hasnan) \
+    std::vector<size_t> argsort( \
+            type *arr, size_t arrsize, bool hasnan, bool descending) \
     { \
-        avx512_qsort_kv(key, val, arrsize, hasnan); \
+        return avx512_argsort_16bit(arr, arrsize, hasnan, descending); \
     } \
     template <> \
-    void keyvalue_qsort(type *key, int64_t *val, size_t arrsize, bool hasnan) \
+    std::vector<size_t> argselect( \
+            type *arr, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        return avx512_argselect_16bit(arr, k, arrsize, hasnan); \
+    } \
+    template <> \
+    void argsort_into(type *arr, \
+                      size_t *arg, \
+                      size_t arrsize, \
+                      bool hasnan, \
+                      bool descending, \
+                      bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort_16bit(arr, arg, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void argselect_into(type *arr, \
+                        size_t *arg, \
+                        size_t k, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool init_arg) \
     { \
-        avx512_qsort_kv(key, val, arrsize, hasnan); \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect_16bit(arr, arg, k, arrsize, hasnan); \
     } \
     template <> \
-    void keyvalue_qsort(type *key, double *val, size_t arrsize, bool hasnan) \
+    void argsort32_into(type *arr, \
+                        uint32_t *arg, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending, \
+                        bool init_arg) \
     { \
-        avx512_qsort_kv(key, val, arrsize, hasnan); \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort_16bit(arr, arg, arrsize, hasnan, descending); \
     } \
     template <> \
-    void keyvalue_qsort(type *key, uint32_t *val, size_t arrsize, bool hasnan) \
+    void argselect32_into(type *arr, \
+                          uint32_t *arg, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          bool init_arg) \
     { \
-        avx512_qsort_kv(key, val, arrsize, hasnan); \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect_16bit(arr, arg, k, arrsize, hasnan); \
     } \
     template <> \
-    void keyvalue_qsort(type *key, int32_t *val, size_t arrsize, bool hasnan) \
+    std::vector<size_t> argsort_parallel( \
+            type *arr, size_t arrsize, bool hasnan, const executor &exec) \
     { \
-        avx512_qsort_kv(key, val, arrsize, hasnan); \
+        return avx512_argsort_16bit_parallel( \
+                arr, arrsize, hasnan, xss_make_executor(exec)); \
     } \
     template <> \
-    void keyvalue_qsort(type *key, float *val, size_t arrsize, bool hasnan) \
+    std::vector<size_t> argselect_parallel(type *arr, \
+                                           size_t k, \
+                                           size_t arrsize, \
+                                           bool hasnan, \
+                                           const executor &exec) \
+    { \
+        return avx512_argselect_16bit_parallel( \
+                arr, k, arrsize, hasnan, xss_make_executor(exec)); \
+    }
+
+/* bfloat16 keys are argsorted as the int16_t of the same order */
+#define DEFINE_BF16_ARG_METHODS() \
+    template <> \
+    void argsort_into(bfloat16 *arr, \
+                      size_t *arg, \
+                      size_t arrsize, \
+                      bool hasnan, \
+                      bool descending, \
+                      bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort_bf16(reinterpret_cast<uint16_t *>(arr), \
+                            arg, \
+                            arrsize, \
+                            hasnan, \
+                            descending); \
+    } \
+    template <> \
+    void argselect_into(bfloat16 *arr, \
+                        size_t *arg, \
+                        size_t k, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect_bf16( \
+                reinterpret_cast<uint16_t *>(arr), arg, k, arrsize, hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> argsort( \
+            bfloat16 *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        std::vector<size_t> arg(arrsize); \
+        argsort_into(arr, arg.data(), arrsize, hasnan, descending, true); \
+        return arg; \
+    } \
+    template <> \
+    std::vector<size_t> argselect( \
+            bfloat16 *arr, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        std::vector<size_t> arg(arrsize); \
+        argselect_into(arr, arg.data(), k, arrsize, hasnan, true); \
+        return arg; \
+    } \
+    template <> \
+    void argsort32_into(bfloat16 *arr, \
+                        uint32_t *arg, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort_bf16(reinterpret_cast<uint16_t *>(arr), \
+                            arg, \
+                            arrsize, \
+                            hasnan, \
+                            descending); \
+    } \
+    template <> \
+    void argselect32_into(bfloat16 *arr, \
+                          uint32_t *arg, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect_bf16( \
+                reinterpret_cast<uint16_t *>(arr), arg, k, arrsize, hasnan); \
+    }
+
+/* uint128 keys are sorted in pairs of registers, see avx512-128bit-qsort.hpp */
+#define DEFINE_UINT128_METHODS() \
+    template <> \
+    void qsort(uint128 *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        avx512_qsort(reinterpret_cast<xss_uint128 *>(arr), \
+                     arrsize, \
+                     hasnan, \
+                     descending); \
+    } \
+    template <> \
+    void qselect(uint128 *arr, \
+                 size_t k, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending) \
+    { \
+        avx512_qselect(reinterpret_cast<xss_uint128 *>(arr), \
+                       k, \
+                       arrsize, \
+                       hasnan, \
+                       descending); \
+    } \
+    template <> \
+    void partial_qsort(uint128 *arr, \
+                       size_t k, \
+                       size_t arrsize, \
+                       bool hasnan, \
+                       bool descending) \
+    { \
+        avx512_partial_qsort(reinterpret_cast<xss_uint128 *>(arr), \
+                             k, \
+                             arrsize, \
+                             hasnan, \
+                             descending); \
+    } \
+    template <> \
+    void argsort_into(uint128 *arr, \
+                      size_t *arg, \
+                      size_t arrsize, \
+                      bool hasnan, \
+                      bool descending, \
+                      bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort(reinterpret_cast<xss_uint128 *>(arr), \
+                       arg, \
+                       arrsize, \
+                       hasnan, \
+                       descending); \
+    } \
+    template <> \
+    void argselect_into(uint128 *arr, \
+                        size_t *arg, \
+                        size_t k, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect(reinterpret_cast<xss_uint128 *>(arr), \
+                         arg, \
+                         k, \
+                         arrsize, \
+                         hasnan); \
+    } \
+    template <> \
+    std::vector<size_t> argsort( \
+            uint128 *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        std::vector<size_t> arg(arrsize); \
+        argsort_into(arr, arg.data(), arrsize, hasnan, descending, true); \
+        return arg; \
+    } \
+    template <> \
+    std::vector<size_t> argselect( \
+            uint128 *arr, size_t k, size_t arrsize, bool hasnan) \
+    { \
+        std::vector<size_t> arg(arrsize); \
+        argselect_into(arr, arg.data(), k, arrsize, hasnan, true); \
+        return arg; \
+    } \
+    template <> \
+    void argsort32_into(uint128 *arr, \
+                        uint32_t *arg, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending, \
+                        bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argsort(reinterpret_cast<xss_uint128 *>(arr), \
+                       arg, \
+                       arrsize, \
+                       hasnan, \
+                       descending); \
+    } \
+    template <> \
+    void argselect32_into(uint128 *arr, \
+                          uint32_t *arg, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          bool init_arg) \
+    { \
+        if (init_arg) { std::iota(arg, arg + arrsize, 0); } \
+        avx512_argselect(reinterpret_cast<xss_uint128 *>(arr), \
+                         arg, \
+                         k, \
+                         arrsize, \
+                         hasnan); \
+    }
+
+#define DEFINE_RADIX_METHODS(type) \
+    template <> \
+    void radix_qsort(type *arr, size_t arrsize) \
     { \
-        avx512_qsort_kv(key, val, arrsize, hasnan); \
+        avx512_radix_qsort(arr, arrsize); \
     }
 
 namespace xss {
@@ -73,11 +515,30 @@ namespace avx512 {
     DEFINE_ALL_METHODS(uint64_t)
     DEFINE_ALL_METHODS(int64_t)
     DEFINE_ALL_METHODS(double)
+    DEFINE_RADIX_METHODS(uint32_t)
+    DEFINE_RADIX_METHODS(int32_t)
+    DEFINE_RADIX_METHODS(uint64_t)
+    DEFINE_RADIX_METHODS(int64_t)
     DEFINE_KEYVALUE_METHODS(uint64_t)
     DEFINE_KEYVALUE_METHODS(int64_t)
     DEFINE_KEYVALUE_METHODS(double)
     DEFINE_KEYVALUE_METHODS(uint32_t)
     DEFINE_KEYVALUE_METHODS(int32_t)
     DEFINE_KEYVALUE_METHODS(float)
+    DEFINE_16BIT_KEYVALUE_QSORT(uint16_t)
+    DEFINE_16BIT_KEYVALUE_QSORT(int16_t)
+#ifdef __FLT16_MAX__
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(uint16_t, _Float16)
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(int16_t, _Float16)
+    DEFINE_16BIT_KEYVALUE_QSORT(_Float16)
+    DEFINE_16BIT_KEYVALUE_QSORT_PAIR(_Float16, _Float16)
+#endif
+    DEFINE_16BIT_ARG_METHODS(uint16_t)
+    DEFINE_16BIT_ARG_METHODS(int16_t)
+#ifdef __FLT16_MAX__
+    DEFINE_16BIT_ARG_METHODS(_Float16)
+#endif
+    DEFINE_BF16_ARG_METHODS()
+    DEFINE_UINT128_METHODS()
 } // namespace avx512
 } // namespace xss
@@ -5,19 +5,72 @@
 namespace xss {
 namespace avx512 {
     template <>
-    void qsort(_Float16 *arr, size_t size, bool hasnan)
+    void qsort(_Float16 *arr, size_t size, bool hasnan, bool descending)
     {
-        avx512_qsort(arr, size, hasnan);
+        avx512_qsort(arr, size, hasnan, descending);
     }
     template <>
-    void qselect(_Float16 *arr, size_t k, size_t arrsize, bool hasnan)
+    void qsort_parallel(_Float16 *arr,
+                        size_t size,
+                        bool hasnan,
+                        const executor &exec)
     {
-        avx512_qselect(arr, k, arrsize, hasnan);
+        avx512_qsort_parallel(arr, size, hasnan, xss_make_executor(exec));
     }
+    /*
+     * The NUMA sort of _Float16 is the parallel quicksort: every thread works
+     * on the whole array, wherever its memory is
+     */
     template <>
-    void partial_qsort(_Float16 *arr, size_t k, size_t arrsize, bool hasnan)
+    void qsort_numa_parallel(_Float16 *arr,
+                             size_t size,
+                             bool hasnan,
+                             unsigned nthreads,
+                             unsigned ndomains)
     {
-        avx512_partial_qsort(arr, k, arrsize, hasnan);
+        UNUSED(ndomains);
+        avx512_qsort_parallel(arr, size, hasnan, nthreads);
+    }
+    template <>
+    void qsort_numa_parallel_exec(_Float16 *arr,
+                                  size_t size,
+                                  bool hasnan,
+                                  const std::vector<executor> &executors)
+    {
+        if (executors.empty()) {
+            avx512_qsort(arr, size, hasnan);
+            return;
+        }
+        avx512_qsort_parallel(
+                arr, size, hasnan, xss_make_executor(executors[0]));
+    }
+    template <>
+    void qselect(_Float16 *arr,
+                 size_t k,
+                 size_t arrsize,
+                 bool hasnan,
+                 bool descending)
+    {
+        avx512_qselect(arr, k, arrsize, hasnan, descending);
+    }
+    template <>
+    void qselect_parallel(_Float16 *arr,
+                          size_t k,
+                          size_t arrsize,
+                          bool hasnan,
+                          const executor &exec)
+    {
+        avx512_qselect_parallel(
+                arr, k, arrsize, hasnan, xss_make_executor(exec));
+    }
+    template <>
+    void partial_qsort(_Float16 *arr,
+                       size_t k,
+                       size_t arrsize,
+                       bool hasnan,
+                       bool descending)
+    {
+        avx512_partial_qsort(arr, k, arrsize, hasnan, descending);
     }
 } // namespace avx512
 } // namespace xss
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <type_traits>
 
 static int check_cpu_feature_support(std::string_view cpufeature)
 {
@@ -53,42 +54,174 @@ dispatch_requested(std::string_view cpurequested,
 
 namespace x86simdsort {
 
+/* The work-stealing pool of the library with nthreads threads */
+static executor builtin_executor(unsigned nthreads)
+{
+    return {NULL, NULL, NULL, nthreads};
+}
+
 #define CAT_(a, b) a##b
 #define CAT(a, b) CAT_(a, b)
 
+/*
+ * Size heuristic of qsort for 32-bit and 64-bit integers: when the
+ * environment variable XSS_ENABLE_RADIX_QSORT is set, arrays of at least
+ * radix_qsort_threshold elements are sorted with radix_qsort, which is faster
+ * on large arrays of uniformly distributed keys but not on skewed or
+ * presorted ones. radix_qsort only sorts in ascending order.
+ */
+static const bool radix_qsort_enabled
+        = std::getenv("XSS_ENABLE_RADIX_QSORT") != NULL;
+constexpr size_t radix_qsort_threshold = 1000000;
+
+static bool use_radix_qsort(size_t arrsize)
+{
+    return radix_qsort_enabled && (arrsize >= radix_qsort_threshold);
+}
+
 #define DECLARE_INTERNAL_qsort(TYPE) \
-    static void (*internal_qsort##TYPE)(TYPE *, size_t, bool) = NULL; \
+    static void (*internal_qsort##TYPE)(TYPE *, size_t, bool, bool) = NULL; \
+    template <> \
+    void qsort(TYPE *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        if constexpr (std::is_integral_v<TYPE> && sizeof(TYPE) >= 4) { \
+            if (!descending && use_radix_qsort(arrsize)) { \
+                radix_qsort(arr, arrsize); \
+                return; \
+            } \
+        } \
+        (*internal_qsort##TYPE)(arr, arrsize, hasnan, descending); \
+    } \
     template <> \
     void qsort(TYPE *arr, size_t arrsize, bool hasnan) \
     { \
-        (*internal_qsort##TYPE)(arr, arrsize, hasnan); \
+        qsort(arr, arrsize, hasnan, false); \
+    }
+
+#define DECLARE_INTERNAL_radix_qsort(TYPE) \
+    static void (*internal_radix_qsort##TYPE)(TYPE *, size_t) = NULL; \
+    template <> \
+    void radix_qsort(TYPE *arr, size_t arrsize) \
+    { \
+        (*internal_radix_qsort##TYPE)(arr, arrsize); \
+    }
+
+#define DECLARE_INTERNAL_qsort_parallel(TYPE) \
+    static void (*internal_qsort_parallel##TYPE)( \
+            TYPE *, size_t, bool, const executor &) \
+            = NULL; \
+    template <> \
+    void qsort_parallel( \
+            TYPE *arr, size_t arrsize, bool hasnan, const executor &exec) \
+    { \
+        (*internal_qsort_parallel##TYPE)(arr, arrsize, hasnan, exec); \
+    } \
+    template <> \
+    void qsort_parallel( \
+            TYPE *arr, size_t arrsize, bool hasnan, unsigned nthreads) \
+    { \
+        qsort_parallel(arr, arrsize, hasnan, builtin_executor(nthreads)); \
+    }
+
+#define DECLARE_INTERNAL_qsort_numa_parallel(TYPE) \
+    static void (*internal_qsort_numa_parallel##TYPE)( \
+            TYPE *, size_t, bool, unsigned, unsigned) \
+            = NULL; \
+    template <> \
+    void qsort_numa_parallel(TYPE *arr, \
+                             size_t arrsize, \
+                             bool hasnan, \
+                             unsigned nthreads, \
+                             unsigned ndomains) \
+    { \
+        (*internal_qsort_numa_parallel##TYPE)( \
+                arr, arrsize, hasnan, nthreads, ndomains); \
+    }
+
+#define DECLARE_INTERNAL_qsort_numa_parallel_exec(TYPE) \
+    static void (*internal_qsort_numa_parallel_exec##TYPE)( \
+            TYPE *, size_t, bool, const std::vector<executor> &) \
+            = NULL; \
+    template <> \
+    void qsort_numa_parallel(TYPE *arr, \
+                             size_t arrsize, \
+                             bool hasnan, \
+                             const std::vector<executor> &executors) \
+    { \
+        (*internal_qsort_numa_parallel_exec##TYPE)( \
+                arr, arrsize, hasnan, executors); \
     }
 
 #define DECLARE_INTERNAL_qselect(TYPE) \
-    static void (*internal_qselect##TYPE)(TYPE *, size_t, size_t, bool) \
+    static void (*internal_qselect##TYPE)( \
+            TYPE *, size_t, size_t, bool, bool) \
             = NULL; \
     template <> \
+    void qselect( \
+            TYPE *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        (*internal_qselect##TYPE)(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
     void qselect(TYPE *arr, size_t k, size_t arrsize, bool hasnan) \
     { \
-        (*internal_qselect##TYPE)(arr, k, arrsize, hasnan); \
+        qselect(arr, k, arrsize, hasnan, false); \
+    }
+
+#define DECLARE_INTERNAL_qselect_parallel(TYPE) \
+    static void (*internal_qselect_parallel##TYPE)( \
+            TYPE *, size_t, size_t, bool, const executor &) \
+            = NULL; \
+    template <> \
+    void qselect_parallel(TYPE *arr, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          const executor &exec) \
+    { \
+        (*internal_qselect_parallel##TYPE)(arr, k, arrsize, hasnan, exec); \
+    } \
+    template <> \
+    void qselect_parallel(TYPE *arr, \
+                          size_t k, \
+                          size_t arrsize, \
+                          bool hasnan, \
+                          unsigned nthreads) \
+    { \
+        qselect_parallel( \
+                arr, k, arrsize, hasnan, builtin_executor(nthreads)); \
     }
 
 #define DECLARE_INTERNAL_partial_qsort(TYPE) \
-    static void (*internal_partial_qsort##TYPE)(TYPE *, size_t, size_t, bool) \
+    static void (*internal_partial_qsort##TYPE)( \
+            TYPE *, size_t, size_t, bool, bool) \
             = NULL; \
     template <> \
+    void partial_qsort( \
+            TYPE *arr, size_t k, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        (*internal_partial_qsort##TYPE)(arr, k, arrsize, hasnan, descending); \
+    } \
+    template <> \
     void partial_qsort(TYPE *arr, size_t k, size_t arrsize, bool hasnan) \
     { \
-        (*internal_partial_qsort##TYPE)(arr, k, arrsize, hasnan); \
+        partial_qsort(arr, k, arrsize, hasnan, false); \
     }
 
 #define DECLARE_INTERNAL_argsort(TYPE) \
-    static std::vector<size_t> (*internal_argsort##TYPE)(TYPE *, size_t, bool) \
+    static std::vector<size_t> (*internal_argsort##TYPE)( \
+            TYPE *, size_t, bool, bool) \
             = NULL; \
     template <> \
+    std::vector<size_t> argsort( \
+            TYPE *arr, size_t arrsize, bool hasnan, bool descending) \
+    { \
+        return (*internal_argsort##TYPE)(arr, arrsize, hasnan, descending); \
+    } \
+    template <> \
     std::vector<size_t> argsort(TYPE *arr, size_t arrsize, bool hasnan) \
     { \
-        return (*internal_argsort##TYPE)(arr, arrsize, hasnan); \
+        return argsort(arr, arrsize, hasnan, false); \
     }
 
 #define DECLARE_INTERNAL_argselect(TYPE) \
@@ -102,6 +235,152 @@ namespace x86simdsort {
         return (*internal_argselect##TYPE)(arr, k, arrsize, hasnan); \
     }
 
+#define DECLARE_INTERNAL_argsort_into(TYPE) \
+    static void (*internal_argsort_into##TYPE)( \
+            TYPE *, size_t *, size_t, bool, bool, bool) \
+            = NULL; \
+    template <> \
+    void argsort(TYPE *arr, \
+                 size_t *arg, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending, \
+                 bool init_arg) \
+    { \
+        (*internal_argsort_into##TYPE)( \
+                arr, arg, arrsize, hasnan, descending, init_arg); \
+    }
+
+#define DECLARE_INTERNAL_argselect_into(TYPE) \
+    static void (*internal_argselect_into##TYPE)( \
+            TYPE *, size_t *, size_t, size_t, bool, bool) \
+            = NULL; \
+    template <> \
+    void argselect(TYPE *arr, \
+                   size_t *arg, \
+                   size_t k, \
+                   size_t arrsize, \
+                   bool hasnan, \
+                   bool init_arg) \
+    { \
+        (*internal_argselect_into##TYPE)( \
+                arr, arg, k, arrsize, hasnan, init_arg); \
+    }
+
+#define DECLARE_INTERNAL_argsort32_into(TYPE) \
+    static void (*internal_argsort32_into##TYPE)( \
+            TYPE *, uint32_t *, size_t, bool, bool, bool) \
+            = NULL; \
+    template <> \
+    void argsort(TYPE *arr, \
+                 uint32_t *arg, \
+                 size_t arrsize, \
+                 bool hasnan, \
+                 bool descending, \
+                 bool init_arg) \
+    { \
+        (*internal_argsort32_into##TYPE)( \
+                arr, arg, arrsize, hasnan, descending, init_arg); \
+    }
+
+#define DECLARE_INTERNAL_argselect32_into(TYPE) \
+    static void (*internal_argselect32_into##TYPE)( \
+            TYPE *, uint32_t *, size_t, size_t, bool, bool) \
+            = NULL; \
+    template <> \
+    void argselect(TYPE *arr, \
+                   uint32_t *arg, \
+                   size_t k, \
+                   size_t arrsize, \
+                   bool hasnan, \
+                   bool init_arg) \
+    { \
+        (*internal_argselect32_into##TYPE)( \
+                arr, arg, k, arrsize, hasnan, init_arg); \
+    }
+
+#define DECLARE_INTERNAL_argsort_parallel(TYPE) \
+    static std::vector<size_t> (*internal_argsort_parallel##TYPE)( \
+            TYPE *, size_t, bool, const executor &) \
+            = NULL; \
+    template <> \
+    std::vector<size_t> argsort_parallel( \
+            TYPE *arr, size_t arrsize, bool hasnan, const executor &exec) \
+    { \
+        return (*internal_argsort_parallel##TYPE)(arr, arrsize, hasnan, exec); \
+    } \
+    template <> \
+    std::vector<size_t> argsort_parallel( \
+            TYPE *arr, size_t arrsize, bool hasnan, unsigned nthreads) \
+    { \
+        return argsort_parallel( \
+                arr, arrsize, hasnan, builtin_executor(nthreads)); \
+    }
+
+#define DECLARE_INTERNAL_argselect_parallel(TYPE) \
+    static std::vector<size_t> (*internal_argselect_parallel##TYPE)( \
+            TYPE *, size_t, size_t, bool, const executor &) \
+            = NULL; \
+    template <> \
+    std::vector<size_t> argselect_parallel(TYPE *arr, \
+                                           size_t k, \
+                                           size_t arrsize, \
+                                           bool hasnan, \
+                                           const executor &exec) \
+    { \
+        return (*internal_argselect_parallel##TYPE)( \
+                arr, k, arrsize, hasnan, exec); \
+    } \
+    template <> \
+    std::vector<size_t> argselect_parallel(TYPE *arr, \
+                                           size_t k, \
+                                           size_t arrsize, \
+                                           bool hasnan, \
+                                           unsigned nthreads) \
+    { \
+        return argselect_parallel( \
+                arr, k, arrsize, hasnan, builtin_executor(nthreads)); \
+    }
+
+#define DECLARE_INTERNAL_stable_qsort(TYPE) \
+    static void (*internal_stable_qsort##TYPE)(TYPE *, size_t, bool) = NULL; \
+    template <> \
+    void stable_qsort(TYPE *arr, size_t arrsize, bool hasnan) \
+    { \
+        (*internal_stable_qsort##TYPE)(arr, arrsize, hasnan); \
+    }
+
+#define DECLARE_INTERNAL_stable_argsort(TYPE) \
+    static std::vector<size_t> (*internal_stable_argsort##TYPE)( \
+            TYPE *, size_t, bool) \
+            = NULL; \
+    template <> \
+    std::vector<size_t> stable_argsort(TYPE *arr, size_t arrsize, bool hasnan) \
+    { \
+        return (*internal_stable_argsort##TYPE)(arr, arrsize, hasnan); \
+    }
+
+#define DECLARE_INTERNAL_merge(TYPE) \
+    static void (*internal_merge##TYPE)( \
+            const TYPE *, size_t, const TYPE *, size_t, TYPE *) \
+            = NULL; \
+    template <> \
+    void merge(const TYPE *a, size_t na, const TYPE *b, size_t nb, TYPE *out) \
+    { \
+        (*internal_merge##TYPE)(a, na, b, nb, out); \
+    }
+
+#define DECLARE_INTERNAL_kway_merge(TYPE) \
+    static void (*internal_kway_merge##TYPE)( \
+            const TYPE *const *, const size_t *, size_t, TYPE *) \
+            = NULL; \
+    template <> \
+    void kway_merge( \
+            const TYPE *const *runs, const size_t *sizes, size_t k, TYPE *out) \
+    { \
+        (*internal_kway_merge##TYPE)(runs, sizes, k, out); \
+    }
+
 /* runtime dispatch mechanism */
 #define DISPATCH(func, TYPE, ISA) \
     DECLARE_INTERNAL_##func(TYPE) static __attribute__((constructor)) void \
@@ -126,13 +405,22 @@ namespace x86simdsort {
 
 #define DISPATCH_KEYVALUE_SORT(TYPE1, TYPE2, ISA) \
     static void(CAT(CAT(*internal_kv_qsort_, TYPE1), TYPE2))( \
-            TYPE1 *, TYPE2 *, size_t, bool) \
+            TYPE1 *, TYPE2 *, size_t, bool, bool) \
             = NULL; \
     template <> \
-    void keyvalue_qsort(TYPE1 *key, TYPE2 *val, size_t arrsize, bool hasnan) \
+    void keyvalue_qsort(TYPE1 *key, \
+                        TYPE2 *val, \
+                        size_t arrsize, \
+                        bool hasnan, \
+                        bool descending) \
     { \
         (CAT(CAT(*internal_kv_qsort_, TYPE1), TYPE2))( \
-                key, val, arrsize, hasnan); \
+                key, val, arrsize, hasnan, descending); \
+    } \
+    template <> \
+    void keyvalue_qsort(TYPE1 *key, TYPE2 *val, size_t arrsize, bool hasnan) \
+    { \
+        keyvalue_qsort(key, val, arrsize, hasnan, false); \
     } \
     static __attribute__((constructor)) void CAT( \
             CAT(resolve_keyvalue_qsort_, TYPE1), TYPE2)(void) \
@@ -157,6 +445,133 @@ namespace x86simdsort {
         } \
     }
 
+#define DISPATCH_KEYVALUE_SORT_PARALLEL(TYPE1, TYPE2, ISA) \
+    static void(CAT(CAT(*internal_kv_qsort_parallel_, TYPE1), TYPE2))( \
+            TYPE1 *, TYPE2 *, size_t, bool, const executor &) \
+            = NULL; \
+    template <> \
+    void keyvalue_qsort_parallel(TYPE1 *key, \
+                                 TYPE2 *val, \
+                                 size_t arrsize, \
+                                 bool hasnan, \
+                                 const executor &exec) \
+    { \
+        (CAT(CAT(*internal_kv_qsort_parallel_, TYPE1), TYPE2))( \
+                key, val, arrsize, hasnan, exec); \
+    } \
+    template <> \
+    void keyvalue_qsort_parallel(TYPE1 *key, \
+                                 TYPE2 *val, \
+                                 size_t arrsize, \
+                                 bool hasnan, \
+                                 unsigned nthreads) \
+    { \
+        keyvalue_qsort_parallel( \
+                key, val, arrsize, hasnan, builtin_executor(nthreads)); \
+    } \
+    static __attribute__((constructor)) void CAT( \
+            CAT(resolve_keyvalue_qsort_parallel_, TYPE1), TYPE2)(void) \
+    { \
+        CAT(CAT(internal_kv_qsort_parallel_, TYPE1), TYPE2) \
+                = &xss::scalar::keyvalue_qsort_parallel<TYPE1, TYPE2>; \
+        __builtin_cpu_init(); \
+        std::string_view preferred_cpu = find_preferred_cpu(ISA); \
+        if constexpr (dispatch_requested("avx512", ISA)) { \
+            if (preferred_cpu.find("avx512") != std::string_view::npos) { \
+                CAT(CAT(internal_kv_qsort_parallel_, TYPE1), TYPE2) \
+                        = &xss::avx512::keyvalue_qsort_parallel<TYPE1, TYPE2>; \
+                return; \
+            } \
+        } \
+        if constexpr (dispatch_requested("avx2", ISA)) { \
+            if (preferred_cpu.find("avx2") != std::string_view::npos) { \
+                CAT(CAT(internal_kv_qsort_parallel_, TYPE1), TYPE2) \
+                        = &xss::avx2::keyvalue_qsort_parallel<TYPE1, TYPE2>; \
+                return; \
+            } \
+        } \
+    }
+
+#define DISPATCH_STABLE_KEYVALUE_SORT(TYPE1, TYPE2, ISA) \
+    static void(CAT(CAT(*internal_stable_kv_qsort_, TYPE1), TYPE2))( \
+            TYPE1 *, TYPE2 *, size_t, bool) \
+            = NULL; \
+    template <> \
+    void stable_keyvalue_qsort( \
+            TYPE1 *key, TYPE2 *val, size_t arrsize, bool hasnan) \
+    { \
+        (CAT(CAT(*internal_stable_kv_qsort_, TYPE1), TYPE2))( \
+                key, val, arrsize, hasnan); \
+    } \
+    static __attribute__((constructor)) void CAT( \
+            CAT(resolve_stable_keyvalue_qsort_, TYPE1), TYPE2)(void) \
+    { \
+        CAT(CAT(internal_stable_kv_qsort_, TYPE1), TYPE2) \
+                = &xss::scalar::stable_keyvalue_qsort<TYPE1, TYPE2>; \
+        __builtin_cpu_init(); \
+        std::string_view preferred_cpu = find_preferred_cpu(ISA); \
+        if constexpr (dispatch_requested("avx512", ISA)) { \
+            if (preferred_cpu.find("avx512") != std::string_view::npos) { \
+                CAT(CAT(internal_stable_kv_qsort_, TYPE1), TYPE2) \
+                        = &xss::avx512::stable_keyvalue_qsort<TYPE1, TYPE2>; \
+                return; \
+            } \
+        } \
+        if constexpr (dispatch_requested("avx2", ISA)) { \
+            if (preferred_cpu.find("avx2") != std::string_view::npos) { \
+                CAT(CAT(internal_stable_kv_qsort_, TYPE1), TYPE2) \
+                        = &xss::avx2::stable_keyvalue_qsort<TYPE1, TYPE2>; \
+                return; \
+            } \
+        } \
+    }
+
+#define DISPATCH_KEYVALUE_MERGE(TYPE1, TYPE2, ISA) \
+    static void(CAT(CAT(*internal_kv_merge_, TYPE1), TYPE2))(const TYPE1 *, \
+                                                              const TYPE2 *, \
+                                                              size_t, \
+                                                              const TYPE1 *, \
+                                                              const TYPE2 *, \
+                                                              size_t, \
+                                                              TYPE1 *, \
+                                                              TYPE2 *) \
+            = NULL; \
+    template <> \
+    void keyvalue_merge(const TYPE1 *akey, \
+                        const TYPE2 *aval, \
+                        size_t na, \
+                        const TYPE1 *bkey, \
+                        const TYPE2 *bval, \
+                        size_t nb, \
+                        TYPE1 *outkey, \
+                        TYPE2 *outval) \
+    { \
+        (CAT(CAT(*internal_kv_merge_, TYPE1), TYPE2))( \
+                akey, aval, na, bkey, bval, nb, outkey, outval); \
+    } \
+    static __attribute__((constructor)) void CAT( \
+            CAT(resolve_keyvalue_merge_, TYPE1), TYPE2)(void) \
+    { \
+        CAT(CAT(internal_kv_merge_, TYPE1), TYPE2) \
+                = &xss::scalar::keyvalue_merge<TYPE1, TYPE2>; \
+        __builtin_cpu_init(); \
+        std::string_view preferred_cpu = find_preferred_cpu(ISA); \
+        if constexpr (dispatch_requested("avx512", ISA)) { \
+            if (preferred_cpu.find("avx512") != std::string_view::npos) { \
+                CAT(CAT(internal_kv_merge_, TYPE1), TYPE2) \
+                        = &xss::avx512::keyvalue_merge<TYPE1, TYPE2>; \
+                return; \
+            } \
+        } \
+        if constexpr (dispatch_requested("avx2", ISA)) { \
+            if (preferred_cpu.find("avx2") != std::string_view::npos) { \
+                CAT(CAT(internal_kv_merge_, TYPE1), TYPE2) \
+                        = &xss::avx2::keyvalue_merge<TYPE1, TYPE2>; \
+                return; \
+            } \
+        } \
+    }
+
 #define ISA_LIST(...) \
     std::initializer_list<std::string_view> \
     { \
@@ -164,11 +579,25 @@ namespace x86simdsort {
     }
 
 #ifdef __FLT16_MAX__
-DISPATCH(qsort, _Float16, ISA_LIST("avx512_spr"))
-DISPATCH(qselect, _Float16, ISA_LIST("avx512_spr"))
-DISPATCH(partial_qsort, _Float16, ISA_LIST("avx512_spr"))
-DISPATCH(argsort, _Float16, ISA_LIST("none"))
-DISPATCH(argselect, _Float16, ISA_LIST("none"))
+DISPATCH(qsort, _Float16, ISA_LIST("avx512_spr", "avx2"))
+DISPATCH(qsort_parallel, _Float16, ISA_LIST("avx512_spr"))
+DISPATCH(qsort_numa_parallel, _Float16, ISA_LIST("avx512_spr"))
+DISPATCH(qsort_numa_parallel_exec, _Float16, ISA_LIST("avx512_spr"))
+DISPATCH(qselect, _Float16, ISA_LIST("avx512_spr", "avx2"))
+DISPATCH(qselect_parallel, _Float16, ISA_LIST("avx512_spr"))
+DISPATCH(partial_qsort, _Float16, ISA_LIST("avx512_spr", "avx2"))
+DISPATCH(argsort, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argselect, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argsort_into, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argselect_into, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argsort32_into, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argselect32_into, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argsort_parallel, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argselect_parallel, _Float16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(stable_qsort, _Float16, ISA_LIST("none"))
+DISPATCH(stable_argsort, _Float16, ISA_LIST("none"))
+DISPATCH(merge, _Float16, ISA_LIST("none"))
+DISPATCH(kway_merge, _Float16, ISA_LIST("none"))
 #endif
 
 #define DISPATCH_ALL(func, ISA_16BIT, ISA_32BIT, ISA_64BIT) \
@@ -181,34 +610,152 @@ DISPATCH(argselect, _Float16, ISA_LIST("none"))
     DISPATCH(func, uint64_t, ISA_64BIT) \
     DISPATCH(func, double, ISA_64BIT)
 
+DISPATCH(radix_qsort, uint32_t, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(radix_qsort, int32_t, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(radix_qsort, uint64_t, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(radix_qsort, int64_t, ISA_LIST("avx512_skx", "avx2"))
 DISPATCH_ALL(qsort,
-             (ISA_LIST("avx512_icl")),
+             (ISA_LIST("avx512_icl", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(qsort_parallel,
+             (ISA_LIST("avx512_icl", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(qsort_numa_parallel,
+             (ISA_LIST("avx512_icl", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(qsort_numa_parallel_exec,
+             (ISA_LIST("avx512_icl", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")))
 DISPATCH_ALL(qselect,
-             (ISA_LIST("avx512_icl")),
+             (ISA_LIST("avx512_icl", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(qselect_parallel,
+             (ISA_LIST("avx512_icl", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")))
 DISPATCH_ALL(partial_qsort,
-             (ISA_LIST("avx512_icl")),
+             (ISA_LIST("avx512_icl", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")))
 DISPATCH_ALL(argsort,
-             (ISA_LIST("none")),
+             (ISA_LIST("avx512_skx", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")))
 DISPATCH_ALL(argselect,
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(argsort_into,
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(argselect_into,
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(argsort32_into,
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(argselect32_into,
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(argsort_parallel,
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(argselect_parallel,
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(stable_qsort,
+             (ISA_LIST("none")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(stable_argsort,
              (ISA_LIST("none")),
              (ISA_LIST("avx512_skx", "avx2")),
              (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(merge,
+             (ISA_LIST("avx512_icl")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_ALL(kway_merge,
+             (ISA_LIST("avx512_icl")),
+             (ISA_LIST("avx512_skx", "avx2")),
+             (ISA_LIST("avx512_skx", "avx2")))
+
+#define DISPATCH_8BIT(func, ISA_8BIT) \
+    DISPATCH(func, uint8_t, ISA_8BIT) \
+    DISPATCH(func, int8_t, ISA_8BIT)
+
+DISPATCH_8BIT(qsort, (ISA_LIST("avx512_icl", "avx2")))
+DISPATCH_8BIT(qselect, (ISA_LIST("avx512_icl", "avx2")))
+DISPATCH_8BIT(partial_qsort, (ISA_LIST("avx512_icl", "avx2")))
+
+DISPATCH(qsort, bfloat16, ISA_LIST("avx512_icl", "avx2"))
+DISPATCH(qselect, bfloat16, ISA_LIST("avx512_icl", "avx2"))
+DISPATCH(partial_qsort, bfloat16, ISA_LIST("avx512_icl", "avx2"))
+DISPATCH(argsort, bfloat16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argselect, bfloat16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argsort_into, bfloat16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argselect_into, bfloat16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argsort32_into, bfloat16, ISA_LIST("avx512_skx", "avx2"))
+DISPATCH(argselect32_into, bfloat16, ISA_LIST("avx512_skx", "avx2"))
+
+DISPATCH(qsort, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(qselect, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(partial_qsort, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(argsort, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(argselect, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(argsort_into, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(argselect_into, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(argsort32_into, uint128, ISA_LIST("avx512_skx"))
+DISPATCH(argselect32_into, uint128, ISA_LIST("avx512_skx"))
 
 #define DISPATCH_KEYVALUE_SORT_FORTYPE(type) \
-    DISPATCH_KEYVALUE_SORT(type, uint64_t, (ISA_LIST("avx512_skx"))) \
-    DISPATCH_KEYVALUE_SORT(type, int64_t, (ISA_LIST("avx512_skx"))) \
-    DISPATCH_KEYVALUE_SORT(type, double, (ISA_LIST("avx512_skx"))) \
-    DISPATCH_KEYVALUE_SORT(type, uint32_t, (ISA_LIST("avx512_skx"))) \
-    DISPATCH_KEYVALUE_SORT(type, int32_t, (ISA_LIST("avx512_skx"))) \
-    DISPATCH_KEYVALUE_SORT(type, float, (ISA_LIST("avx512_skx")))
+    DISPATCH_KEYVALUE_SORT(type, uint64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, int64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, double, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, uint32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, int32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, float, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT_PARALLEL( \
+            type, uint64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT_PARALLEL( \
+            type, int64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT_PARALLEL( \
+            type, double, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT_PARALLEL( \
+            type, uint32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT_PARALLEL( \
+            type, int32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT_PARALLEL( \
+            type, float, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_STABLE_KEYVALUE_SORT( \
+            type, uint64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_STABLE_KEYVALUE_SORT( \
+            type, int64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_STABLE_KEYVALUE_SORT( \
+            type, double, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_STABLE_KEYVALUE_SORT( \
+            type, uint32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_STABLE_KEYVALUE_SORT( \
+            type, int32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_STABLE_KEYVALUE_SORT( \
+            type, float, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_MERGE(type, uint64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_MERGE(type, int64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_MERGE(type, double, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_MERGE(type, uint32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_MERGE(type, int32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_MERGE(type, float, (ISA_LIST("avx512_skx", "avx2")))
 
 DISPATCH_KEYVALUE_SORT_FORTYPE(uint64_t)
 DISPATCH_KEYVALUE_SORT_FORTYPE(int64_t)
@@ -217,4 +764,24 @@ DISPATCH_KEYVALUE_SORT_FORTYPE(uint32_t)
 DISPATCH_KEYVALUE_SORT_FORTYPE(int32_t)
 DISPATCH_KEYVALUE_SORT_FORTYPE(float)
 
+/* 16-bit keys only have the key-value quicksort */
+#define DISPATCH_16BIT_KEYVALUE_SORT_FORTYPE(type) \
+    DISPATCH_KEYVALUE_SORT(type, uint64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, int64_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, double, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, uint32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, int32_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, float, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, uint16_t, (ISA_LIST("avx512_skx", "avx2"))) \
+    DISPATCH_KEYVALUE_SORT(type, int16_t, (ISA_LIST("avx512_skx", "avx2")))
+
+DISPATCH_16BIT_KEYVALUE_SORT_FORTYPE(uint16_t)
+DISPATCH_16BIT_KEYVALUE_SORT_FORTYPE(int16_t)
+#ifdef __FLT16_MAX__
+DISPATCH_KEYVALUE_SORT(uint16_t, _Float16, (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_KEYVALUE_SORT(int16_t, _Float16, (ISA_LIST("avx512_skx", "avx2")))
+DISPATCH_16BIT_KEYVALUE_SORT_FORTYPE(_Float16)
+DISPATCH_KEYVALUE_SORT(_Float16, _Float16, (ISA_LIST("avx512_skx", "avx2")))
+#endif
+
 } // namespace x86simdsort
@@ -12,34 +12,298 @@
 
 namespace x86simdsort {
 
+/*
+ * Runs the tasks of the multi-threaded routines on a thread pool owned by the
+ * caller instead of threads spawned by the library: submit(ctx, func, arg)
+ * must eventually call func(arg) on any thread, wait(ctx) must block until
+ * every task submitted so far (including the ones submitted by other tasks)
+ * has finished. num_threads is the parallelism to plan for. Leaving submit
+ * as NULL selects the built-in work-stealing pool with num_threads threads.
+ */
+struct executor {
+    void (*submit)(void *ctx, void (*func)(void *), void *arg);
+    void (*wait)(void *ctx);
+    void *ctx;
+    unsigned num_threads;
+};
+
+/*
+ * bfloat16, stored as its bits: the upper 16 bits of an IEEE float. Sorted by
+ * qsort, qselect, partial_qsort, argsort and argselect in the order of the
+ * float values, with -0 before +0 and NaNs after +inf whatever hasnan is
+ */
+struct XSS_EXPORT_SYMBOL bfloat16 {
+    uint16_t bits;
+};
+
+/*
+ * 128-bit unsigned key, such as a UUID or a (hash, timestamp) composite,
+ * ordered by hi and then by lo. Laid out like unsigned __int128, lo first.
+ * Sorted by qsort, qselect, partial_qsort, argsort and argselect
+ */
+struct XSS_EXPORT_SYMBOL uint128 {
+    uint64_t lo;
+    uint64_t hi;
+};
+
+inline bool operator==(const uint128 &a, const uint128 &b)
+{
+    return a.lo == b.lo && a.hi == b.hi;
+}
+inline bool operator!=(const uint128 &a, const uint128 &b)
+{
+    return !(a == b);
+}
+inline bool operator<(const uint128 &a, const uint128 &b)
+{
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+inline bool operator>(const uint128 &a, const uint128 &b)
+{
+    return b < a;
+}
+
 // quicksort
 template <typename T>
 XSS_EXPORT_SYMBOL void qsort(T *arr, size_t arrsize, bool hasnan = false);
 
+// quicksort in either order: descending = true sorts from the largest element
+// down. NaNs are ordered after +inf, i.e. at the end of an ascending sort and
+// at the start of a descending one; the same holds for the descending
+// overloads of qselect, partial_qsort, argsort and keyvalue_qsort
+template <typename T>
+XSS_EXPORT_SYMBOL void
+qsort(T *arr, size_t arrsize, bool hasnan, bool descending);
+
+// multi-threaded quicksort: nthreads = 0 uses all the hardware threads, see
+// executor above to run on threads owned by the caller instead
+template <typename T>
+XSS_EXPORT_SYMBOL void qsort_parallel(T *arr,
+                                      size_t arrsize,
+                                      bool hasnan = false,
+                                      unsigned nthreads = 0);
+template <typename T>
+XSS_EXPORT_SYMBOL void
+qsort_parallel(T *arr, size_t arrsize, bool hasnan, const executor &exec);
+
+// NUMA-aware multi-threaded quicksort: every NUMA node sorts a part of the
+// array in node-local memory with its own threads, and the parts are then
+// merged. ndomains = 0 uses one domain per node (libnuma builds only, a single
+// node otherwise); larger values split the work further.
+template <typename T>
+XSS_EXPORT_SYMBOL void qsort_numa_parallel(T *arr,
+                                           size_t arrsize,
+                                           bool hasnan = false,
+                                           unsigned nthreads = 0,
+                                           unsigned ndomains = 0);
+// NUMA-aware multi-threaded quicksort on executors of the caller, one per
+// domain: executors[d] sorts and merges the d-th range of the array and
+// should run its tasks on the CPUs of a single NUMA node
+template <typename T>
+XSS_EXPORT_SYMBOL void
+qsort_numa_parallel(T *arr,
+                    size_t arrsize,
+                    bool hasnan,
+                    const std::vector<executor> &executors);
+
+// hybrid MSD radix sort / quicksort for 32-bit and 64-bit integers: one or
+// two radix passes split the array into cache sized buckets which are then
+// quicksorted. Needs a temporary buffer the size of the array.
+template <typename T>
+XSS_EXPORT_SYMBOL void radix_qsort(T *arr, size_t arrsize);
+
 // quickselect
 template <typename T>
 XSS_EXPORT_SYMBOL void
 qselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+template <typename T>
+XSS_EXPORT_SYMBOL void
+qselect(T *arr, size_t k, size_t arrsize, bool hasnan, bool descending);
+
+// multi-threaded quickselect: nthreads = 0 uses all the hardware threads
+template <typename T>
+XSS_EXPORT_SYMBOL void qselect_parallel(T *arr,
+                                        size_t k,
+                                        size_t arrsize,
+                                        bool hasnan = false,
+                                        unsigned nthreads = 0);
+template <typename T>
+XSS_EXPORT_SYMBOL void qselect_parallel(
+        T *arr, size_t k, size_t arrsize, bool hasnan, const executor &exec);
 
 // partial sort
 template <typename T>
 XSS_EXPORT_SYMBOL void
 partial_qsort(T *arr, size_t k, size_t arrsize, bool hasnan = false);
+template <typename T>
+XSS_EXPORT_SYMBOL void
+partial_qsort(T *arr, size_t k, size_t arrsize, bool hasnan, bool descending);
 
 // argsort
 template <typename T>
 XSS_EXPORT_SYMBOL std::vector<size_t>
 argsort(T *arr, size_t arrsize, bool hasnan = false);
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t>
+argsort(T *arr, size_t arrsize, bool hasnan, bool descending);
+
+// argsort into arg, a buffer of arrsize indices owned by the caller, without
+// allocating: arg is first set to 0, ..., arrsize - 1, unless init_arg is
+// false in which case the indices already in arg are sorted (for instance a
+// subset of the indices of a larger arr)
+template <typename T>
+XSS_EXPORT_SYMBOL void argsort(T *arr,
+                               size_t *arg,
+                               size_t arrsize,
+                               bool hasnan = false,
+                               bool descending = false,
+                               bool init_arg = true);
+
+// argsort into a buffer of uint32_t indices, for arrsize <= UINT32_MAX: the
+// index buffer is half the size and 32-bit keys partition full registers.
+// This is the one exception to not allocating: 16-bit keys are packed with
+// their indices into 64-bit words, a temporary array of 8 bytes per element
+// that the size_t overloads build in arg itself
+template <typename T>
+XSS_EXPORT_SYMBOL void argsort(T *arr,
+                               uint32_t *arg,
+                               size_t arrsize,
+                               bool hasnan = false,
+                               bool descending = false,
+                               bool init_arg = true);
+
+// multi-threaded argsort: nthreads = 0 uses all the hardware threads
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> argsort_parallel(T *arr,
+                                                       size_t arrsize,
+                                                       bool hasnan = false,
+                                                       unsigned nthreads = 0);
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t>
+argsort_parallel(T *arr, size_t arrsize, bool hasnan, const executor &exec);
 
 // argselect
 template <typename T>
 XSS_EXPORT_SYMBOL std::vector<size_t>
 argselect(T *arr, size_t k, size_t arrsize, bool hasnan = false);
 
+// argselect into arg, a buffer of arrsize indices owned by the caller, see
+// argsort above for init_arg
+template <typename T>
+XSS_EXPORT_SYMBOL void argselect(T *arr,
+                                 size_t *arg,
+                                 size_t k,
+                                 size_t arrsize,
+                                 bool hasnan = false,
+                                 bool init_arg = true);
+
+// argselect into a buffer of uint32_t indices, for arrsize <= UINT32_MAX.
+// Like argsort, this allocates a temporary array for 16-bit keys
+template <typename T>
+XSS_EXPORT_SYMBOL void argselect(T *arr,
+                                 uint32_t *arg,
+                                 size_t k,
+                                 size_t arrsize,
+                                 bool hasnan = false,
+                                 bool init_arg = true);
+
+// multi-threaded argselect: nthreads = 0 uses all the hardware threads
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> argselect_parallel(T *arr,
+                                                         size_t k,
+                                                         size_t arrsize,
+                                                         bool hasnan = false,
+                                                         unsigned nthreads = 0);
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t> argselect_parallel(
+        T *arr, size_t k, size_t arrsize, bool hasnan, const executor &exec);
+
 // keyvalue sort
 template <typename T1, typename T2>
 XSS_EXPORT_SYMBOL void
 keyvalue_qsort(T1 *key, T2 *val, size_t arrsize, bool hasnan = false);
+template <typename T1, typename T2>
+XSS_EXPORT_SYMBOL void keyvalue_qsort(
+        T1 *key, T2 *val, size_t arrsize, bool hasnan, bool descending);
+
+// multi-threaded keyvalue sort: nthreads = 0 uses all the hardware threads
+template <typename T1, typename T2>
+XSS_EXPORT_SYMBOL void keyvalue_qsort_parallel(T1 *key,
+                                               T2 *val,
+                                               size_t arrsize,
+                                               bool hasnan = false,
+                                               unsigned nthreads = 0);
+template <typename T1, typename T2>
+XSS_EXPORT_SYMBOL void keyvalue_qsort_parallel(
+        T1 *key, T2 *val, size_t arrsize, bool hasnan, const executor &exec);
+
+// stable sort: equal elements keep their relative order. A merge sort with
+// O(n log n) cost on any input, needs a temporary buffer the size of the array
+template <typename T>
+XSS_EXPORT_SYMBOL void
+stable_qsort(T *arr, size_t arrsize, bool hasnan = false);
+
+// stable argsort: the indices of equal elements are in increasing order
+template <typename T>
+XSS_EXPORT_SYMBOL std::vector<size_t>
+stable_argsort(T *arr, size_t arrsize, bool hasnan = false);
+
+// stable keyvalue sort: values with equal keys keep their relative order
+template <typename T1, typename T2>
+XSS_EXPORT_SYMBOL void
+stable_keyvalue_qsort(T1 *key, T2 *val, size_t arrsize, bool hasnan = false);
+
+// merge of the sorted arrays a and b into out[0, na + nb), which must not
+// overlap with a or b. NaNs, if any, must be at the end of a and b (as left by
+// qsort) and end up at the end of out.
+template <typename T>
+XSS_EXPORT_SYMBOL void
+merge(const T *a, size_t na, const T *b, size_t nb, T *out);
+
+// k-way merge of the sorted arrays runs[0], ..., runs[k - 1] of sizes[0], ...,
+// sizes[k - 1] elements into out, whose size is the sum of sizes. Merges cache
+// sized blocks through a tree of merges, see merge above for the NaNs
+template <typename T>
+XSS_EXPORT_SYMBOL void
+kway_merge(const T *const *runs, const size_t *sizes, size_t k, T *out);
+
+// keyvalue merge: merges the pairs of arrays sorted by key, see merge above
+template <typename T1, typename T2>
+XSS_EXPORT_SYMBOL void keyvalue_merge(const T1 *akey,
+                                      const T2 *aval,
+                                      size_t na,
+                                      const T1 *bkey,
+                                      const T2 *bval,
+                                      size_t nb,
+                                      T1 *outkey,
+                                      T2 *outval);
+
+// external sort of the file input, an array of T in native byte order, into
+// the file output (which may be input) using about memory_bytes of memory.
+// Sorted runs of memory_bytes / 2 are spilled to temporary files in tmpdir
+// (NULL: $TMPDIR or /tmp) and merged with kway_merge, reading and writing in
+// the background. Returns false, with errno set, if a file cannot be read or
+// written, or if the size of input is not a multiple of sizeof(T).
+template <typename T>
+XSS_EXPORT_SYMBOL bool external_sort(const char *input,
+                                     const char *output,
+                                     size_t memory_bytes,
+                                     const char *tmpdir = NULL,
+                                     bool hasnan = false);
+
+// in-place sort of the file path, an array of T in native byte order which
+// fits in memory, through a shared mapping of the file: saves the copies of
+// reading the file into memory and writing it back. The file is synced to
+// disk on return. Returns false, with errno set, on errors.
+template <typename T>
+XSS_EXPORT_SYMBOL bool mmap_qsort(const char *path, bool hasnan = false);
+
+// keyvalue sort of the files keypath and valpath of equal length, see
+// mmap_qsort above
+template <typename T1, typename T2>
+XSS_EXPORT_SYMBOL bool mmap_keyvalue_qsort(const char *keypath,
+                                           const char *valpath,
+                                           bool hasnan = false);
 
 // sort an object
 template <typename T, typename Func>
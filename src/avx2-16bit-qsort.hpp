@@ -0,0 +1,359 @@
+#ifndef AVX2_QSORT_16BIT
+#define AVX2_QSORT_16BIT
+
+#include "xss-common-qsort.h"
+#include "avx2-emu-funcs.hpp"
+
+/*
+ * 16 16-bit lanes in a ymm register. The masks are full 16-bit lanes like the
+ * 32-bit ones, the bitonic network of a single register is the generic one of
+ * xss-network-qsort.hpp and the partition emulates compressstore with a
+ * shuffle of each 128-bit half, see avx2_emu_partition16.
+ */
+
+struct avx2_16bit_swizzle_ops;
+
+template <>
+struct avx2_vector<int16_t> {
+    using type_t = int16_t;
+    using reg_t = __m256i;
+    using ymmi_t = __m256i;
+    using opmask_t = __m256i;
+    static const uint8_t numlanes = 16;
+#ifdef XSS_MINIMAL_NETWORK_SORT
+    static constexpr int network_sort_threshold = numlanes;
+#else
+    static constexpr int network_sort_threshold = 256;
+#endif
+    static constexpr int partition_unroll_factor = 4;
+    static constexpr simd_type vec_type = simd_type::AVX2;
+
+    using swizzle_ops = avx2_16bit_swizzle_ops;
+
+    static type_t type_max()
+    {
+        return X86_SIMD_SORT_MAX_INT16;
+    }
+    static type_t type_min()
+    {
+        return X86_SIMD_SORT_MIN_INT16;
+    }
+    static reg_t zmm_max()
+    {
+        return _mm256_set1_epi16(type_max());
+    }
+    static opmask_t knot_opmask(opmask_t x)
+    {
+        return _mm256_xor_si256(x, _mm256_set1_epi16(-1));
+    }
+    static opmask_t get_partial_loadmask(uint64_t num_to_read)
+    {
+        const __m256i lanes = _mm256_setr_epi16(
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        return _mm256_cmpgt_epi16(_mm256_set1_epi16(num_to_read), lanes);
+    }
+    static opmask_t ge(reg_t x, reg_t y)
+    {
+        return eq(max(x, y), x);
+    }
+    static opmask_t eq(reg_t x, reg_t y)
+    {
+        return _mm256_cmpeq_epi16(x, y);
+    }
+    static reg_t loadu(void const *mem)
+    {
+        return _mm256_loadu_si256((reg_t const *)mem);
+    }
+    static reg_t max(reg_t x, reg_t y)
+    {
+        return _mm256_max_epi16(x, y);
+    }
+    static void mask_compressstoreu(void *mem, opmask_t mask, reg_t x)
+    {
+        return avx2_emu_mask_compressstoreu16<type_t>(mem, mask, x);
+    }
+    static reg_t maskz_loadu(opmask_t mask, void const *mem)
+    {
+        return avx2_emu_mask_loadu16<type_t>(
+                _mm256_setzero_si256(), mask, mem);
+    }
+    static reg_t mask_loadu(reg_t x, opmask_t mask, void const *mem)
+    {
+        return avx2_emu_mask_loadu16<type_t>(x, mask, mem);
+    }
+    static reg_t mask_mov(reg_t x, opmask_t mask, reg_t y)
+    {
+        return _mm256_blendv_epi8(x, y, mask);
+    }
+    static void mask_storeu(void *mem, opmask_t mask, reg_t x)
+    {
+        return avx2_emu_mask_storeu16<type_t>(mem, mask, x);
+    }
+    static reg_t min(reg_t x, reg_t y)
+    {
+        return _mm256_min_epi16(x, y);
+    }
+    static reg_t reverse(reg_t ymm)
+    {
+        const __m256i rev_index = _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8,
+                                                   9, 6, 7, 4, 5, 2, 3, 0, 1,
+                                                   14, 15, 12, 13, 10, 11, 8,
+                                                   9, 6, 7, 4, 5, 2, 3, 0, 1);
+        return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(ymm, rev_index),
+                                        0b01001110);
+    }
+    static type_t reducemax(reg_t v)
+    {
+        return avx2_emu_reduce_max16<type_t>(v);
+    }
+    static type_t reducemin(reg_t v)
+    {
+        return avx2_emu_reduce_min16<type_t>(v);
+    }
+    static reg_t set1(type_t v)
+    {
+        return _mm256_set1_epi16(v);
+    }
+    static void storeu(void *mem, reg_t x)
+    {
+        _mm256_storeu_si256((__m256i *)mem, x);
+    }
+    static reg_t sort_vec(reg_t x)
+    {
+        sort_vectors<avx2_vector<type_t>, 1>(&x);
+        return x;
+    }
+    static reg_t cast_from(__m256i v)
+    {
+        return v;
+    }
+    static __m256i cast_to(reg_t v)
+    {
+        return v;
+    }
+    static bool all_false(opmask_t k)
+    {
+        return _mm256_testz_si256(k, k);
+    }
+    static int double_compressstore(type_t *left_addr,
+                                    type_t *right_addr,
+                                    opmask_t k,
+                                    reg_t reg)
+    {
+        return avx2_double_compressstore16<type_t>(
+                left_addr, right_addr, k, reg);
+    }
+};
+template <>
+struct avx2_vector<uint16_t> {
+    using type_t = uint16_t;
+    using reg_t = __m256i;
+    using ymmi_t = __m256i;
+    using opmask_t = __m256i;
+    static const uint8_t numlanes = 16;
+#ifdef XSS_MINIMAL_NETWORK_SORT
+    static constexpr int network_sort_threshold = numlanes;
+#else
+    static constexpr int network_sort_threshold = 256;
+#endif
+    static constexpr int partition_unroll_factor = 4;
+    static constexpr simd_type vec_type = simd_type::AVX2;
+
+    using swizzle_ops = avx2_16bit_swizzle_ops;
+
+    static type_t type_max()
+    {
+        return X86_SIMD_SORT_MAX_UINT16;
+    }
+    static type_t type_min()
+    {
+        return 0;
+    }
+    static reg_t zmm_max()
+    {
+        return _mm256_set1_epi16(type_max());
+    }
+    static opmask_t knot_opmask(opmask_t x)
+    {
+        return _mm256_xor_si256(x, _mm256_set1_epi16(-1));
+    }
+    static opmask_t get_partial_loadmask(uint64_t num_to_read)
+    {
+        const __m256i lanes = _mm256_setr_epi16(
+                0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        return _mm256_cmpgt_epi16(_mm256_set1_epi16(num_to_read), lanes);
+    }
+    static opmask_t ge(reg_t x, reg_t y)
+    {
+        return eq(max(x, y), x);
+    }
+    static opmask_t eq(reg_t x, reg_t y)
+    {
+        return _mm256_cmpeq_epi16(x, y);
+    }
+    static reg_t loadu(void const *mem)
+    {
+        return _mm256_loadu_si256((reg_t const *)mem);
+    }
+    static reg_t max(reg_t x, reg_t y)
+    {
+        return _mm256_max_epu16(x, y);
+    }
+    static void mask_compressstoreu(void *mem, opmask_t mask, reg_t x)
+    {
+        return avx2_emu_mask_compressstoreu16<type_t>(mem, mask, x);
+    }
+    static reg_t maskz_loadu(opmask_t mask, void const *mem)
+    {
+        return avx2_emu_mask_loadu16<type_t>(
+                _mm256_setzero_si256(), mask, mem);
+    }
+    static reg_t mask_loadu(reg_t x, opmask_t mask, void const *mem)
+    {
+        return avx2_emu_mask_loadu16<type_t>(x, mask, mem);
+    }
+    static reg_t mask_mov(reg_t x, opmask_t mask, reg_t y)
+    {
+        return _mm256_blendv_epi8(x, y, mask);
+    }
+    static void mask_storeu(void *mem, opmask_t mask, reg_t x)
+    {
+        return avx2_emu_mask_storeu16<type_t>(mem, mask, x);
+    }
+    static reg_t min(reg_t x, reg_t y)
+    {
+        return _mm256_min_epu16(x, y);
+    }
+    static reg_t reverse(reg_t ymm)
+    {
+        const __m256i rev_index = _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8,
+                                                   9, 6, 7, 4, 5, 2, 3, 0, 1,
+                                                   14, 15, 12, 13, 10, 11, 8,
+                                                   9, 6, 7, 4, 5, 2, 3, 0, 1);
+        return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(ymm, rev_index),
+                                        0b01001110);
+    }
+    static type_t reducemax(reg_t v)
+    {
+        return avx2_emu_reduce_max16<type_t>(v);
+    }
+    static type_t reducemin(reg_t v)
+    {
+        return avx2_emu_reduce_min16<type_t>(v);
+    }
+    static reg_t set1(type_t v)
+    {
+        return _mm256_set1_epi16(v);
+    }
+    static void storeu(void *mem, reg_t x)
+    {
+        _mm256_storeu_si256((__m256i *)mem, x);
+    }
+    static reg_t sort_vec(reg_t x)
+    {
+        sort_vectors<avx2_vector<type_t>, 1>(&x);
+        return x;
+    }
+    static reg_t cast_from(__m256i v)
+    {
+        return v;
+    }
+    static __m256i cast_to(reg_t v)
+    {
+        return v;
+    }
+    static bool all_false(opmask_t k)
+    {
+        return _mm256_testz_si256(k, k);
+    }
+    static int double_compressstore(type_t *left_addr,
+                                    type_t *right_addr,
+                                    opmask_t k,
+                                    reg_t reg)
+    {
+        return avx2_double_compressstore16<type_t>(
+                left_addr, right_addr, k, reg);
+    }
+};
+
+struct avx2_16bit_swizzle_ops {
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t swap_n(typename vtype::reg_t reg)
+    {
+        __m256i v = vtype::cast_to(reg);
+
+        if constexpr (scale == 2) {
+            v = _mm256_or_si256(_mm256_slli_epi32(v, 16),
+                                _mm256_srli_epi32(v, 16));
+        }
+        else if constexpr (scale == 4) {
+            v = _mm256_shuffle_epi32(v, 0b10110001);
+        }
+        else if constexpr (scale == 8) {
+            v = _mm256_shuffle_epi32(v, 0b01001110);
+        }
+        else if constexpr (scale == 16) {
+            v = _mm256_permute2x128_si256(v, v, 0b00000001);
+        }
+        else {
+            static_assert(scale == -1, "should not be reached");
+        }
+
+        return vtype::cast_from(v);
+    }
+
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t
+    reverse_n(typename vtype::reg_t reg)
+    {
+        __m256i v = vtype::cast_to(reg);
+
+        if constexpr (scale == 2) { return swap_n<vtype, 2>(reg); }
+        else if constexpr (scale == 4) {
+            constexpr int mask = 0b00011011;
+            v = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, mask), mask);
+        }
+        else if constexpr (scale == 8) {
+            const __m256i rev_index = _mm256_setr_epi8(
+                    14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+                    14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+            v = _mm256_shuffle_epi8(v, rev_index);
+        }
+        else if constexpr (scale == 16) {
+            return vtype::reverse(reg);
+        }
+        else {
+            static_assert(scale == -1, "should not be reached");
+        }
+
+        return vtype::cast_from(v);
+    }
+
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t
+    merge_n(typename vtype::reg_t reg, typename vtype::reg_t other)
+    {
+        __m256i v1 = vtype::cast_to(reg);
+        __m256i v2 = vtype::cast_to(other);
+
+        if constexpr (scale == 2) {
+            v1 = _mm256_blend_epi16(v1, v2, 0b01010101);
+        }
+        else if constexpr (scale == 4) {
+            v1 = _mm256_blend_epi16(v1, v2, 0b00110011);
+        }
+        else if constexpr (scale == 8) {
+            v1 = _mm256_blend_epi16(v1, v2, 0b00001111);
+        }
+        else if constexpr (scale == 16) {
+            v1 = _mm256_blend_epi32(v1, v2, 0b00001111);
+        }
+        else {
+            static_assert(scale == -1, "should not be reached");
+        }
+
+        return vtype::cast_from(v1);
+    }
+};
+
+#endif // AVX2_QSORT_16BIT
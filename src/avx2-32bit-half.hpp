@@ -106,7 +106,8 @@ struct avx2_half_vector<int32_t> {
         return _mm_mask_i32gather_epi32(
                 src, (const int *)base, index, mask, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[3]], arr[ind[2]], arr[ind[1]], arr[ind[0]]);
     }
@@ -246,7 +247,8 @@ struct avx2_half_vector<uint32_t> {
         return _mm_mask_i32gather_epi32(
                 src, (const int *)base, index, mask, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[3]], arr[ind[2]], arr[ind[1]], arr[ind[0]]);
     }
@@ -418,7 +420,8 @@ struct avx2_half_vector<float> {
         return _mm_mask_i32gather_ps(
                 src, (const float *)base, index, _mm_castsi128_ps(mask), scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[3]], arr[ind[2]], arr[ind[1]], arr[ind[0]]);
     }
@@ -118,7 +118,8 @@ struct avx2_vector<int64_t> {
         return _mm256_mask_i32gather_epi64(
                 src, (const long long int *)base, index, mask, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[3]], arr[ind[2]], arr[ind[1]], arr[ind[0]]);
     }
@@ -280,7 +281,8 @@ struct avx2_vector<uint64_t> {
         return _mm256_mask_i32gather_epi64(
                 src, (const long long int *)base, index, mask, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[3]], arr[ind[2]], arr[ind[1]], arr[ind[0]]);
     }
@@ -503,7 +505,8 @@ struct avx2_vector<double> {
                                         scale);
         ;
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[3]], arr[ind[2]], arr[ind[1]], arr[ind[0]]);
     }
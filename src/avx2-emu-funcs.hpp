@@ -144,6 +144,31 @@ constexpr auto avx2_compressstore_lut64_perm
 constexpr auto avx2_compressstore_lut64_left
         = avx2_compressstore_lut64_gen.second;
 
+/* pshufb indices of the 8 16-bit lanes of a 128-bit half */
+constexpr auto avx2_compressstore_lut16_perm = [] {
+    std::array<std::array<uint8_t, 16>, 256> permLut {};
+    for (int64_t i = 0; i <= 0xFF; i++) {
+        std::array<uint8_t, 16> indices {};
+        int right = 7;
+        int left = 0;
+        for (int j = 0; j < 8; j++) {
+            bool ge = (i >> j) & 1;
+            if (ge) {
+                indices[2 * right] = 2 * j;
+                indices[2 * right + 1] = 2 * j + 1;
+                right--;
+            }
+            else {
+                indices[2 * left] = 2 * j;
+                indices[2 * left + 1] = 2 * j + 1;
+                left++;
+            }
+        }
+        permLut[i] = indices;
+    }
+    return permLut;
+}();
+
 X86_SIMD_SORT_INLINE
 __m256i convert_int_to_avx2_mask(int32_t m)
 {
@@ -170,6 +195,14 @@ int32_t convert_avx2_mask_to_int_64bit(__m256i m)
     return _mm256_movemask_pd(_mm256_castsi256_pd(m));
 }
 
+X86_SIMD_SORT_INLINE
+int32_t convert_avx2_mask_to_int_16bit(__m256i m)
+{
+    __m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(m),
+                                     _mm256_extracti128_si256(m, 1));
+    return _mm_movemask_epi8(packed);
+}
+
 X86_SIMD_SORT_INLINE
 __m128i convert_int_to_avx2_mask_half(int32_t m)
 {
@@ -262,6 +295,40 @@ T avx2_emu_reduce_min64(typename avx2_vector<T>::reg_t x)
     return std::min(arr[0], arr[3]);
 }
 
+template <typename T>
+T avx2_emu_reduce_max16(typename avx2_vector<T>::reg_t x)
+{
+    using vtype = avx2_vector<T>;
+    using swizzle = typename vtype::swizzle_ops;
+    using reg_t = typename vtype::reg_t;
+
+    reg_t inter1 = vtype::max(x, swizzle::template swap_n<vtype, 16>(x));
+    reg_t inter2 = vtype::max(
+            inter1, swizzle::template swap_n<vtype, 8>(inter1));
+    reg_t inter3 = vtype::max(
+            inter2, swizzle::template swap_n<vtype, 4>(inter2));
+    reg_t inter4 = vtype::max(
+            inter3, swizzle::template swap_n<vtype, 2>(inter3));
+    return (T)_mm256_extract_epi16(inter4, 0);
+}
+
+template <typename T>
+T avx2_emu_reduce_min16(typename avx2_vector<T>::reg_t x)
+{
+    using vtype = avx2_vector<T>;
+    using swizzle = typename vtype::swizzle_ops;
+    using reg_t = typename vtype::reg_t;
+
+    reg_t inter1 = vtype::min(x, swizzle::template swap_n<vtype, 16>(x));
+    reg_t inter2 = vtype::min(
+            inter1, swizzle::template swap_n<vtype, 8>(inter1));
+    reg_t inter3 = vtype::min(
+            inter2, swizzle::template swap_n<vtype, 4>(inter2));
+    reg_t inter4 = vtype::min(
+            inter3, swizzle::template swap_n<vtype, 2>(inter3));
+    return (T)_mm256_extract_epi16(inter4, 0);
+}
+
 template <typename T>
 void avx2_emu_mask_compressstoreu32(void *base_addr,
                                     typename avx2_vector<T>::opmask_t k,
@@ -419,4 +486,129 @@ typename avx2_vector<T>::reg_t avx2_emu_min(typename avx2_vector<T>::reg_t x,
                                                 _mm256_castsi256_pd(nlt)));
 }
 
+/*
+ * AVX2 has no 16-bit masked loads and stores: pairs of masked lanes are loaded
+ * and stored as 32-bit lanes, and a lane masked without its neighbour on its
+ * own
+ */
+template <typename T>
+typename avx2_vector<T>::reg_t
+avx2_emu_mask_loadu16(typename avx2_vector<T>::reg_t x,
+                      typename avx2_vector<T>::opmask_t k,
+                      void const *mem)
+{
+    using vtype = avx2_vector<T>;
+
+    __m256i pairs = _mm256_cmpeq_epi32(k, _mm256_set1_epi32(-1));
+    __m256i dst = _mm256_maskload_epi32((const int *)mem, pairs);
+    int32_t single
+            = convert_avx2_mask_to_int_16bit(_mm256_andnot_si256(pairs, k));
+    if (single != 0) {
+        T temp[vtype::numlanes];
+        vtype::storeu(temp, dst);
+        for (; single != 0; single &= single - 1) {
+            int lane = _tzcnt_u32(single);
+            temp[lane] = ((const T *)mem)[lane];
+        }
+        dst = vtype::loadu(temp);
+    }
+    return vtype::mask_mov(x, k, dst);
+}
+
+template <typename T>
+void avx2_emu_mask_storeu16(void *mem,
+                            typename avx2_vector<T>::opmask_t k,
+                            typename avx2_vector<T>::reg_t x)
+{
+    using vtype = avx2_vector<T>;
+
+    __m256i pairs = _mm256_cmpeq_epi32(k, _mm256_set1_epi32(-1));
+    _mm256_maskstore_epi32((int *)mem, pairs, x);
+    int32_t single
+            = convert_avx2_mask_to_int_16bit(_mm256_andnot_si256(pairs, k));
+    if (single != 0) {
+        T temp[vtype::numlanes];
+        vtype::storeu(temp, x);
+        for (; single != 0; single &= single - 1) {
+            int lane = _tzcnt_u32(single);
+            ((T *)mem)[lane] = temp[lane];
+        }
+    }
+}
+
+/*
+ * Moves the 16-bit lanes whose mask bit is clear to the front of reg and the
+ * others to the back. Each 128-bit half is shuffled on its own, the upper one
+ * with its mask inverted, into [clear_lo, set_lo | set_hi, clear_hi]: rotating
+ * that right by the number of clear_hi lanes brings them to the front.
+ */
+X86_SIMD_SORT_INLINE
+__m256i avx2_emu_partition16(__m256i reg, int32_t shortMask)
+{
+    const __m128i permLo = _mm_loadu_si128(
+            (const __m128i *)avx2_compressstore_lut16_perm[shortMask & 0xFF]
+                    .data());
+    const __m128i permHi = _mm_loadu_si128(
+            (const __m128i *)avx2_compressstore_lut16_perm[(~shortMask >> 8)
+                                                           & 0xFF]
+                    .data());
+    __m256i perm = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(permLo), permHi, 1);
+    __m256i temp = _mm256_shuffle_epi8(reg, perm);
+
+    /* Rotate by rot / 2 32-bit lanes, then by one 16-bit lane if rot is odd */
+    int32_t rot = 8 - _mm_popcnt_u32(shortMask >> 8);
+    const __m256i seven = _mm256_set1_epi32(7);
+    __m256i idx = _mm256_sub_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                   _mm256_set1_epi32(rot >> 1));
+    __m256i rot0 = _mm256_permutevar8x32_epi32(temp,
+                                               _mm256_and_si256(idx, seven));
+    idx = _mm256_sub_epi32(idx, _mm256_set1_epi32(1));
+    __m256i rot1 = _mm256_permutevar8x32_epi32(temp,
+                                               _mm256_and_si256(idx, seven));
+    /* Shifting by 32 clears rot1 when rot is even */
+    int32_t shift = (rot & 1) * 16;
+    return _mm256_or_si256(
+            _mm256_sll_epi32(rot0, _mm_cvtsi32_si128(shift)),
+            _mm256_srl_epi32(rot1, _mm_cvtsi32_si128(32 - shift)));
+}
+
+template <typename T>
+void avx2_emu_mask_compressstoreu16(void *base_addr,
+                                    typename avx2_vector<T>::opmask_t k,
+                                    typename avx2_vector<T>::reg_t reg)
+{
+    using vtype = avx2_vector<T>;
+
+    T *leftStore = (T *)base_addr;
+
+    int32_t shortMask = convert_avx2_mask_to_int_16bit(k);
+    typename vtype::reg_t temp
+            = avx2_emu_partition16(reg, ~shortMask & 0xFFFF);
+
+    vtype::mask_storeu(leftStore,
+                       vtype::get_partial_loadmask(_mm_popcnt_u32(shortMask)),
+                       temp);
+}
+
+template <typename T>
+int avx2_double_compressstore16(void *left_addr,
+                                void *right_addr,
+                                typename avx2_vector<T>::opmask_t k,
+                                typename avx2_vector<T>::reg_t reg)
+{
+    using vtype = avx2_vector<T>;
+
+    T *leftStore = (T *)left_addr;
+    T *rightStore = (T *)right_addr;
+
+    int32_t shortMask = convert_avx2_mask_to_int_16bit(k);
+    typename vtype::reg_t temp = avx2_emu_partition16(reg, shortMask);
+
+    vtype::storeu(leftStore, temp);
+    vtype::storeu(rightStore, temp);
+
+    return _mm_popcnt_u32(shortMask);
+}
+
 #endif
@@ -0,0 +1,366 @@
+#ifndef AVX512_QSORT_128BIT
+#define AVX512_QSORT_128BIT
+
+#include "xss-common-qsort.h"
+#include "avx512-64bit-common.h"
+#include "xss-common-argsort.h"
+
+/*
+ * 128-bit unsigned keys, such as UUIDs or (hash, timestamp) composites,
+ * ordered by hi and then by lo. The layout is the one of unsigned __int128 on
+ * x86: lo is at the lower address.
+ */
+struct xss_uint128 {
+    uint64_t lo;
+    uint64_t hi;
+};
+
+inline bool operator==(const xss_uint128 &a, const xss_uint128 &b)
+{
+    return a.lo == b.lo && a.hi == b.hi;
+}
+inline bool operator!=(const xss_uint128 &a, const xss_uint128 &b)
+{
+    return !(a == b);
+}
+inline bool operator<(const xss_uint128 &a, const xss_uint128 &b)
+{
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+inline bool operator>(const xss_uint128 &a, const xss_uint128 &b)
+{
+    return b < a;
+}
+inline bool operator<=(const xss_uint128 &a, const xss_uint128 &b)
+{
+    return !(b < a);
+}
+inline bool operator>=(const xss_uint128 &a, const xss_uint128 &b)
+{
+    return !(a < b);
+}
+/* Wrapping arithmetic, for next_value of the pivot selection */
+inline xss_uint128 operator+(const xss_uint128 &a, uint64_t b)
+{
+    uint64_t lo = a.lo + b;
+    return {lo, a.hi + (lo < b)};
+}
+inline xss_uint128 operator-(const xss_uint128 &a, uint64_t b)
+{
+    return {a.lo - b, a.hi - (a.lo < b)};
+}
+
+template <>
+class std::numeric_limits<xss_uint128> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = false;
+    static constexpr bool is_integer = true;
+    static constexpr xss_uint128 min()
+    {
+        return {0, 0};
+    }
+    static constexpr xss_uint128 max()
+    {
+        return {X86_SIMD_SORT_MAX_UINT64, X86_SIMD_SORT_MAX_UINT64};
+    }
+    static constexpr xss_uint128 lowest()
+    {
+        return min();
+    }
+};
+
+/*
+ * 8 keys in a pair of ZMM registers: lane i of lo and hi holds the two words
+ * of key i. Every 64-bit shuffle of the networks is applied to both, the
+ * compares look at hi and then at lo where the hi words are equal, and a
+ * mask has one bit per key like zmm_vector<uint64_t>.
+ */
+struct avx512_128bit_reg {
+    __m512i lo;
+    __m512i hi;
+};
+
+/* The swizzles of avx512_64bit_swizzle_ops, on both words of the keys */
+struct avx512_128bit_swizzle_ops {
+    using word_ops = avx512_64bit_swizzle_ops;
+    using word_vtype = zmm_vector<uint64_t>;
+
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t swap_n(typename vtype::reg_t reg)
+    {
+        return {word_ops::swap_n<word_vtype, scale>(reg.lo),
+                word_ops::swap_n<word_vtype, scale>(reg.hi)};
+    }
+
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t
+    reverse_n(typename vtype::reg_t reg)
+    {
+        return {word_ops::reverse_n<word_vtype, scale>(reg.lo),
+                word_ops::reverse_n<word_vtype, scale>(reg.hi)};
+    }
+
+    template <typename vtype, int scale>
+    X86_SIMD_SORT_INLINE typename vtype::reg_t
+    merge_n(typename vtype::reg_t reg, typename vtype::reg_t other)
+    {
+        return {word_ops::merge_n<word_vtype, scale>(reg.lo, other.lo),
+                word_ops::merge_n<word_vtype, scale>(reg.hi, other.hi)};
+    }
+};
+
+template <>
+struct zmm_vector<xss_uint128> {
+    using type_t = xss_uint128;
+    using reg_t = avx512_128bit_reg;
+    using regi_t = __m512i;
+    using opmask_t = __mmask8;
+    static const uint8_t numlanes = 8;
+#ifdef XSS_MINIMAL_NETWORK_SORT
+    static constexpr int network_sort_threshold = numlanes;
+#else
+    static constexpr int network_sort_threshold = 128;
+#endif
+    static constexpr int partition_unroll_factor = 4;
+    static constexpr simd_type vec_type = simd_type::AVX512;
+
+    using swizzle_ops = avx512_128bit_swizzle_ops;
+
+    static type_t type_max()
+    {
+        return std::numeric_limits<type_t>::max();
+    }
+    static type_t type_min()
+    {
+        return std::numeric_limits<type_t>::min();
+    }
+    static reg_t zmm_max()
+    {
+        return set1(type_max());
+    }
+
+    static regi_t
+    seti(int v1, int v2, int v3, int v4, int v5, int v6, int v7, int v8)
+    {
+        return _mm512_set_epi64(v1, v2, v3, v4, v5, v6, v7, v8);
+    }
+    static reg_t set(type_t v1,
+                     type_t v2,
+                     type_t v3,
+                     type_t v4,
+                     type_t v5,
+                     type_t v6,
+                     type_t v7,
+                     type_t v8)
+    {
+        return {_mm512_set_epi64(
+                        v1.lo, v2.lo, v3.lo, v4.lo, v5.lo, v6.lo, v7.lo, v8.lo),
+                _mm512_set_epi64(v1.hi,
+                                 v2.hi,
+                                 v3.hi,
+                                 v4.hi,
+                                 v5.hi,
+                                 v6.hi,
+                                 v7.hi,
+                                 v8.hi)};
+    }
+    /*
+     * Gathers cannot scale by sizeof(type_t), so the words of the keys are
+     * gathered at twice the indices
+     */
+    template <int scale>
+    static reg_t
+    mask_i64gather(reg_t src, opmask_t mask, __m512i index, void const *base)
+    {
+        static_assert(scale == sizeof(type_t), "unexpected scale");
+        __m512i words = _mm512_slli_epi64(index, 1);
+        return {_mm512_mask_i64gather_epi64(src.lo, mask, words, base, 8),
+                _mm512_mask_i64gather_epi64(
+                        src.hi, mask, words, (uint64_t const *)base + 1, 8)};
+    }
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
+    {
+        return set(arr[ind[7]],
+                   arr[ind[6]],
+                   arr[ind[5]],
+                   arr[ind[4]],
+                   arr[ind[3]],
+                   arr[ind[2]],
+                   arr[ind[1]],
+                   arr[ind[0]]);
+    }
+    static opmask_t knot_opmask(opmask_t x)
+    {
+        return _knot_mask8(x);
+    }
+    /* x.hi > y.hi, or x.hi == y.hi and x.lo >= y.lo */
+    static opmask_t ge(reg_t x, reg_t y)
+    {
+        opmask_t hi_gt = _mm512_cmp_epu64_mask(x.hi, y.hi, _MM_CMPINT_NLE);
+        opmask_t hi_eq = _mm512_cmp_epu64_mask(x.hi, y.hi, _MM_CMPINT_EQ);
+        return hi_gt
+                | _mm512_mask_cmp_epu64_mask(
+                        hi_eq, x.lo, y.lo, _MM_CMPINT_NLT);
+    }
+    static opmask_t get_partial_loadmask(uint64_t num_to_read)
+    {
+        return ((0x1ull << num_to_read) - 0x1ull);
+    }
+    static opmask_t eq(reg_t x, reg_t y)
+    {
+        return _mm512_mask_cmp_epu64_mask(
+                _mm512_cmp_epu64_mask(x.hi, y.hi, _MM_CMPINT_EQ),
+                x.lo,
+                y.lo,
+                _MM_CMPINT_EQ);
+    }
+    /* Splits the keys 0-3 in a and 4-7 in b into their lo and hi words */
+    static reg_t deinterleave(__m512i a, __m512i b)
+    {
+        const regi_t lo_index = seti(14, 12, 10, 8, 6, 4, 2, 0);
+        const regi_t hi_index = seti(15, 13, 11, 9, 7, 5, 3, 1);
+        return {_mm512_permutex2var_epi64(a, lo_index, b),
+                _mm512_permutex2var_epi64(a, hi_index, b)};
+    }
+    /* Mask of the 64-bit words of the keys in mask */
+    static __mmask16 word_mask(opmask_t mask)
+    {
+        return (__mmask16)(_pdep_u32(mask, 0x5555) * 3);
+    }
+    static reg_t loadu(void const *mem)
+    {
+        return deinterleave(_mm512_loadu_si512(mem),
+                            _mm512_loadu_si512((uint64_t const *)mem + 8));
+    }
+    static reg_t max(reg_t x, reg_t y)
+    {
+        return mask_mov(y, ge(x, y), x);
+    }
+    static void mask_compressstoreu(void *mem, opmask_t mask, reg_t x)
+    {
+        reg_t packed = {_mm512_maskz_compress_epi64(mask, x.lo),
+                        _mm512_maskz_compress_epi64(mask, x.hi)};
+        mask_storeu(mem, get_partial_loadmask(_mm_popcnt_u32(mask)), packed);
+    }
+    static reg_t maskz_loadu(opmask_t mask, void const *mem)
+    {
+        __mmask16 words = word_mask(mask);
+        return deinterleave(
+                _mm512_maskz_loadu_epi64((__mmask8)words, mem),
+                _mm512_maskz_loadu_epi64((__mmask8)(words >> 8),
+                                         (uint64_t const *)mem + 8));
+    }
+    static reg_t mask_loadu(reg_t x, opmask_t mask, void const *mem)
+    {
+        return mask_mov(x, mask, maskz_loadu(mask, mem));
+    }
+    static reg_t mask_mov(reg_t x, opmask_t mask, reg_t y)
+    {
+        return {_mm512_mask_mov_epi64(x.lo, mask, y.lo),
+                _mm512_mask_mov_epi64(x.hi, mask, y.hi)};
+    }
+    static void mask_storeu(void *mem, opmask_t mask, reg_t x)
+    {
+        __mmask16 words = word_mask(mask);
+        _mm512_mask_storeu_epi64(mem, (__mmask8)words, interleave_lower(x));
+        _mm512_mask_storeu_epi64((uint64_t *)mem + 8,
+                                 (__mmask8)(words >> 8),
+                                 interleave_upper(x));
+    }
+    static reg_t min(reg_t x, reg_t y)
+    {
+        return mask_mov(x, ge(x, y), y);
+    }
+    static reg_t permutexvar(__m512i idx, reg_t zmm)
+    {
+        return {_mm512_permutexvar_epi64(idx, zmm.lo),
+                _mm512_permutexvar_epi64(idx, zmm.hi)};
+    }
+    static type_t first(reg_t v)
+    {
+        return {(uint64_t)_mm_cvtsi128_si64(_mm512_castsi512_si128(v.lo)),
+                (uint64_t)_mm_cvtsi128_si64(_mm512_castsi512_si128(v.hi))};
+    }
+    static type_t reducemax(reg_t v)
+    {
+        using swizzle = avx512_128bit_swizzle_ops;
+        v = max(v, swizzle::swap_n<zmm_vector<type_t>, 8>(v));
+        v = max(v, swizzle::swap_n<zmm_vector<type_t>, 4>(v));
+        v = max(v, swizzle::swap_n<zmm_vector<type_t>, 2>(v));
+        return first(v);
+    }
+    static type_t reducemin(reg_t v)
+    {
+        using swizzle = avx512_128bit_swizzle_ops;
+        v = min(v, swizzle::swap_n<zmm_vector<type_t>, 8>(v));
+        v = min(v, swizzle::swap_n<zmm_vector<type_t>, 4>(v));
+        v = min(v, swizzle::swap_n<zmm_vector<type_t>, 2>(v));
+        return first(v);
+    }
+    static reg_t set1(type_t v)
+    {
+        return {_mm512_set1_epi64(v.lo), _mm512_set1_epi64(v.hi)};
+    }
+    template <uint8_t mask>
+    static reg_t shuffle(reg_t zmm)
+    {
+        return {zmm_vector<uint64_t>::shuffle<mask>(zmm.lo),
+                zmm_vector<uint64_t>::shuffle<mask>(zmm.hi)};
+    }
+    /* The keys 0-3 and 4-7 of x in memory order */
+    static __m512i interleave_lower(reg_t x)
+    {
+        return _mm512_permutex2var_epi64(
+                x.lo, seti(11, 3, 10, 2, 9, 1, 8, 0), x.hi);
+    }
+    static __m512i interleave_upper(reg_t x)
+    {
+        return _mm512_permutex2var_epi64(
+                x.lo, seti(15, 7, 14, 6, 13, 5, 12, 4), x.hi);
+    }
+    static void storeu(void *mem, reg_t x)
+    {
+        _mm512_storeu_si512(mem, interleave_lower(x));
+        _mm512_storeu_si512((uint64_t *)mem + 8, interleave_upper(x));
+    }
+    static reg_t reverse(reg_t zmm)
+    {
+        const regi_t rev_index = seti(NETWORK_64BIT_2);
+        return permutexvar(rev_index, zmm);
+    }
+    static reg_t sort_vec(reg_t x)
+    {
+        return sort_zmm_64bit<zmm_vector<type_t>>(x);
+    }
+    static bool all_false(opmask_t k)
+    {
+        return k == 0;
+    }
+    /*
+     * A single permutation of both words moves the keys not in k to the front
+     * and the ones in k to the back, and the same register is stored at both
+     * addresses
+     */
+    static int double_compressstore(type_t *left_addr,
+                                    type_t *right_addr,
+                                    opmask_t k,
+                                    reg_t reg)
+    {
+        const regi_t lanes = seti(7, 6, 5, 4, 3, 2, 1, 0);
+        int amount_ge_pivot = _mm_popcnt_u32((int)k);
+        opmask_t back = knot_opmask(
+                get_partial_loadmask(numlanes - amount_ge_pivot));
+        regi_t perm = _mm512_mask_expand_epi64(
+                _mm512_maskz_compress_epi64(knot_opmask(k), lanes),
+                back,
+                _mm512_maskz_compress_epi64(k, lanes));
+        reg_t temp = permutexvar(perm, reg);
+        storeu(left_addr, temp);
+        storeu(right_addr, temp);
+        return amount_ge_pivot;
+    }
+};
+
+#endif // AVX512_QSORT_128BIT
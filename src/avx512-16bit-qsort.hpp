@@ -8,6 +8,7 @@
 #define AVX512_QSORT_16BIT
 
 #include "avx512-16bit-common.h"
+#include "xss-bfloat16.hpp"
 
 struct float16 {
     uint16_t val;
@@ -586,4 +587,41 @@ X86_SIMD_SORT_INLINE void avx512_partial_qsort_fp16(uint16_t *arr,
     avx512_qselect_fp16(arr, k - 1, arrsize, hasnan);
     avx512_qsort_fp16(arr, k - 1);
 }
+
+/* bfloat16, as the int16_t of the same order: see xss-bfloat16.hpp */
+X86_SIMD_SORT_INLINE void avx512_qsort_bf16(uint16_t *arr,
+                                            arrsize_t arrsize,
+                                            bool hasnan = false,
+                                            bool descending = false)
+{
+    UNUSED(hasnan);
+    xss_sort_bf16(arr, arrsize, [=](int16_t *keys) {
+        avx512_qsort(keys, arrsize, false, descending);
+    });
+}
+
+X86_SIMD_SORT_INLINE void avx512_qselect_bf16(uint16_t *arr,
+                                              arrsize_t k,
+                                              arrsize_t arrsize,
+                                              bool hasnan = false,
+                                              bool descending = false)
+{
+    UNUSED(hasnan);
+    xss_sort_bf16(arr, arrsize, [=](int16_t *keys) {
+        avx512_qselect(keys, k, arrsize, false, descending);
+    });
+}
+
+X86_SIMD_SORT_INLINE void avx512_partial_qsort_bf16(uint16_t *arr,
+                                                    arrsize_t k,
+                                                    arrsize_t arrsize,
+                                                    bool hasnan = false,
+                                                    bool descending = false)
+{
+    UNUSED(hasnan);
+    xss_sort_bf16(arr, arrsize, [=](int16_t *keys) {
+        avx512_partial_qsort(keys, k, arrsize, false, descending);
+    });
+}
+
 #endif // AVX512_QSORT_16BIT
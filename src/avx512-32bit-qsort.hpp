@@ -80,6 +80,15 @@ struct zmm_vector<int32_t> {
     {
         return _mm512_i64gather_epi32(index, base, scale);
     }
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
+    {
+        type_t vals[numlanes];
+        for (int i = 0; i < numlanes; i++) {
+            vals[i] = arr[ind[i]];
+        }
+        return loadu(vals);
+    }
     static reg_t merge(halfreg_t y1, halfreg_t y2)
     {
         reg_t z1 = _mm512_castsi256_si512(y1);
@@ -247,6 +256,15 @@ struct zmm_vector<uint32_t> {
     {
         return _mm512_i64gather_epi32(index, base, scale);
     }
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
+    {
+        type_t vals[numlanes];
+        for (int i = 0; i < numlanes; i++) {
+            vals[i] = arr[ind[i]];
+        }
+        return loadu(vals);
+    }
     static reg_t merge(halfreg_t y1, halfreg_t y2)
     {
         reg_t z1 = _mm512_castsi256_si512(y1);
@@ -455,6 +473,15 @@ struct zmm_vector<float> {
     {
         return _mm512_i64gather_ps(index, base, scale);
     }
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
+    {
+        type_t vals[numlanes];
+        for (int i = 0; i < numlanes; i++) {
+            vals[i] = arr[ind[i]];
+        }
+        return loadu(vals);
+    }
     static reg_t merge(halfreg_t y1, halfreg_t y2)
     {
         reg_t z1 = _mm512_castsi512_ps(
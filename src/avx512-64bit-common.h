@@ -108,7 +108,8 @@ struct ymm_vector<float> {
     {
         return _mm256_mmask_i32gather_ps(src, mask, index, base, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[7]],
                    arr[ind[6]],
@@ -288,7 +289,8 @@ struct ymm_vector<uint32_t> {
     {
         return _mm256_mmask_i32gather_epi32(src, mask, index, base, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[7]],
                    arr[ind[6]],
@@ -462,7 +464,8 @@ struct ymm_vector<int32_t> {
     {
         return _mm256_mmask_i32gather_epi32(src, mask, index, base, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[7]],
                    arr[ind[6]],
@@ -645,7 +648,8 @@ struct zmm_vector<int64_t> {
     {
         return _mm512_mask_i32gather_epi64(src, mask, index, base, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[7]],
                    arr[ind[6]],
@@ -804,7 +808,8 @@ struct zmm_vector<uint64_t> {
     {
         return _mm512_mask_i32gather_epi64(src, mask, index, base, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[7]],
                    arr[ind[6]],
@@ -1020,7 +1025,8 @@ struct zmm_vector<double> {
     {
         return _mm512_mask_i32gather_pd(src, mask, index, base, scale);
     }
-    static reg_t i64gather(type_t *arr, arrsize_t *ind)
+    template <typename index_t>
+    static reg_t i64gather(type_t *arr, index_t *ind)
     {
         return set(arr[ind[7]],
                    arr[ind[6]],
@@ -8,6 +8,7 @@
 #define AVX512FP16_QSORT_16BIT
 
 #include "avx512-16bit-common.h"
+#include "xss-parallel-qsort.hpp"
 
 typedef union {
     _Float16 f_;
@@ -175,51 +176,122 @@ X86_SIMD_SORT_INLINE_ONLY bool is_a_nan<_Float16>(_Float16 elem)
 }
 
 template <>
-X86_SIMD_SORT_INLINE_ONLY void
-replace_inf_with_nan(_Float16 *arr, arrsize_t size, arrsize_t nan_count)
+X86_SIMD_SORT_INLINE_ONLY void replace_inf_with_nan(_Float16 *arr,
+                                                    arrsize_t size,
+                                                    arrsize_t nan_count,
+                                                    bool descending)
 {
     Fp16Bits val;
     val.i_ = 0x7c01;
-    for (arrsize_t ii = size - 1; nan_count > 0; --ii) {
-        arr[ii] = val.f_;
-        nan_count -= 1;
+    if (descending) { std::fill(arr, arr + nan_count, val.f_); }
+    else {
+        std::fill(arr + size - nan_count, arr + size, val.f_);
     }
 }
 /* Specialized template function for _Float16 qsort_*/
 template <>
-X86_SIMD_SORT_INLINE_ONLY void
-avx512_qsort(_Float16 *arr, arrsize_t arrsize, bool hasnan)
+X86_SIMD_SORT_INLINE_ONLY void avx512_qsort(_Float16 *arr,
+                                            arrsize_t arrsize,
+                                            bool hasnan,
+                                            bool descending)
 {
+    using vtype = zmm_vector<_Float16>;
     if (arrsize > 1) {
         arrsize_t nan_count = 0;
         if (UNLIKELY(hasnan)) {
-            nan_count = replace_nan_with_inf<zmm_vector<_Float16>, _Float16>(
-                    arr, arrsize);
+            nan_count = replace_nan_with_inf<vtype, _Float16>(arr, arrsize);
         }
-        qsort_<zmm_vector<_Float16>, _Float16>(
-                arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
-        replace_inf_with_nan(arr, arrsize, nan_count);
+        if (descending) {
+            qsort_<xss_descending<vtype>, _Float16>(
+                    arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        }
+        else {
+            qsort_<vtype, _Float16>(
+                    arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        }
+        replace_inf_with_nan(arr, arrsize, nan_count, descending);
     }
 }
 
 template <>
-X86_SIMD_SORT_INLINE_ONLY void
-avx512_qselect(_Float16 *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
+X86_SIMD_SORT_INLINE_ONLY void avx512_qsort_parallel(_Float16 *arr,
+                                                     arrsize_t arrsize,
+                                                     bool hasnan,
+                                                     xss_thread_pool &pool)
 {
+    if ((pool.num_threads() == 1) || (arrsize <= xss_parallel_task_cutoff)) {
+        avx512_qsort(arr, arrsize, hasnan);
+        return;
+    }
+    arrsize_t nan_count = 0;
+    if (UNLIKELY(hasnan)) {
+        nan_count = parallel_replace_nan_with_inf<zmm_vector<_Float16>>(
+                arr, arrsize, pool);
+    }
+    qsort_parallel_all_<zmm_vector<_Float16>, _Float16>(arr, arrsize, pool);
+    replace_inf_with_nan(arr, arrsize, nan_count);
+}
+
+template <>
+X86_SIMD_SORT_INLINE_ONLY void avx512_qselect(_Float16 *arr,
+                                              arrsize_t k,
+                                              arrsize_t arrsize,
+                                              bool hasnan,
+                                              bool descending)
+{
+    using vtype = zmm_vector<_Float16>;
+    arrsize_t indx_first_elem = 0;
+    arrsize_t indx_last_elem = arrsize - 1;
+    if (UNLIKELY(hasnan)) {
+        if (descending) {
+            indx_first_elem = move_nans_to_start_of_array(arr, arrsize);
+        }
+        else {
+            indx_last_elem = move_nans_to_end_of_array(arr, arrsize);
+        }
+    }
+    if (indx_last_elem >= k && k >= indx_first_elem) {
+        arrsize_t max_iters
+                = 2 * (arrsize_t)log2(indx_last_elem - indx_first_elem);
+        if (descending) {
+            qselect_<xss_descending<vtype>, _Float16>(
+                    arr, k, indx_first_elem, indx_last_elem, max_iters);
+        }
+        else {
+            qselect_<vtype, _Float16>(
+                    arr, k, indx_first_elem, indx_last_elem, max_iters);
+        }
+    }
+}
+template <>
+X86_SIMD_SORT_INLINE_ONLY void avx512_qselect_parallel(_Float16 *arr,
+                                                       arrsize_t k,
+                                                       arrsize_t arrsize,
+                                                       bool hasnan,
+                                                       xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1)
+        || (arrsize <= 2 * xss_parallel_block_cutoff)) {
+        avx512_qselect(arr, k, arrsize, hasnan);
+        return;
+    }
     arrsize_t indx_last_elem = arrsize - 1;
     if (UNLIKELY(hasnan)) {
         indx_last_elem = move_nans_to_end_of_array(arr, arrsize);
     }
     if (indx_last_elem >= k) {
-        qselect_<zmm_vector<_Float16>, _Float16>(
-                arr, k, 0, indx_last_elem, 2 * (arrsize_t)log2(indx_last_elem));
+        qselect_parallel_<zmm_vector<_Float16>, _Float16>(
+                arr, k, indx_last_elem, pool);
     }
 }
 template <>
-X86_SIMD_SORT_INLINE_ONLY void
-avx512_partial_qsort(_Float16 *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
+X86_SIMD_SORT_INLINE_ONLY void avx512_partial_qsort(_Float16 *arr,
+                                                    arrsize_t k,
+                                                    arrsize_t arrsize,
+                                                    bool hasnan,
+                                                    bool descending)
 {
-    avx512_qselect(arr, k - 1, arrsize, hasnan);
-    avx512_qsort(arr, k - 1, hasnan);
+    avx512_qselect(arr, k - 1, arrsize, hasnan, descending);
+    avx512_qsort(arr, k - 1, hasnan, descending);
 }
 #endif // AVX512FP16_QSORT_16BIT
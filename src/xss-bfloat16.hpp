@@ -0,0 +1,123 @@
+#ifndef XSS_BFLOAT16
+#define XSS_BFLOAT16
+
+/*
+ * bfloat16 keys, given as their uint16_t bits (the upper 16 bits of an IEEE
+ * float), and _Float16 keys where there is no AVX512-FP16. There are no vector
+ * types for them: the bits are mapped to the int16_t of the same order, which
+ * the 16-bit integer routines sort, and mapped back. Negative values have
+ * their magnitude bits flipped, so -0 is ordered before +0, and every NaN
+ * becomes INT16_MAX: NaNs are ordered after +inf without a separate pass, and
+ * are the NaN 0x7fff once mapped back. Both formats only differ in the bits of
+ * +inf, which the NaNs are above.
+ */
+
+#include "xss-packed-16bit.hpp"
+
+/* Also in place, with keys aliasing bits: 16 keys at a time with AVX2 */
+template <uint16_t infinity_bits>
+X86_SIMD_SORT_INLINE void
+xss_float16_to_int16(const uint16_t *bits, int16_t *keys, arrsize_t arrsize)
+{
+    const __m256i magnitude = _mm256_set1_epi16(0x7fff);
+    const __m256i infinity = _mm256_set1_epi16(infinity_bits);
+    arrsize_t ii = 0;
+    for (; ii + 16 <= arrsize; ii += 16) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(bits + ii));
+        __m256i sign = _mm256_srai_epi16(in, 15);
+        __m256i key = _mm256_xor_si256(in, _mm256_and_si256(sign, magnitude));
+        __m256i isnan = _mm256_cmpgt_epi16(_mm256_and_si256(in, magnitude),
+                                           infinity);
+        key = _mm256_blendv_epi8(key, magnitude, isnan);
+        _mm256_storeu_si256((__m256i *)(keys + ii), key);
+    }
+    for (; ii < arrsize; ++ii) {
+        uint16_t key = bits[ii];
+        /* 0x7fff for negative values, 0 otherwise */
+        key ^= (uint16_t)(-(key >> 15)) & 0x7fff;
+        if ((bits[ii] & 0x7fff) > infinity_bits) {
+            key = X86_SIMD_SORT_MAX_INT16;
+        }
+        keys[ii] = (int16_t)key;
+    }
+}
+
+X86_SIMD_SORT_INLINE void
+xss_int16_to_float16(const int16_t *keys, uint16_t *bits, arrsize_t arrsize)
+{
+    const __m256i magnitude = _mm256_set1_epi16(0x7fff);
+    arrsize_t ii = 0;
+    for (; ii + 16 <= arrsize; ii += 16) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(keys + ii));
+        __m256i sign = _mm256_srai_epi16(in, 15);
+        __m256i out = _mm256_xor_si256(in, _mm256_and_si256(sign, magnitude));
+        _mm256_storeu_si256((__m256i *)(bits + ii), out);
+    }
+    for (; ii < arrsize; ++ii) {
+        uint16_t key = (uint16_t)keys[ii];
+        bits[ii] = key ^ ((uint16_t)(-(key >> 15)) & 0x7fff);
+    }
+}
+
+/*
+ * Sorts arr in place with sort(int16_t *keys), which sorts the keys or only
+ * selects some of them
+ */
+template <uint16_t infinity_bits, typename SortFunc>
+X86_SIMD_SORT_INLINE void
+xss_sort_float16(uint16_t *arr, arrsize_t arrsize, SortFunc sort)
+{
+    int16_t *keys = reinterpret_cast<int16_t *>(arr);
+    xss_float16_to_int16<infinity_bits>(arr, keys, arrsize);
+    sort(keys);
+    xss_int16_to_float16(keys, arr, arrsize);
+}
+
+template <typename SortFunc>
+X86_SIMD_SORT_INLINE void
+xss_sort_bf16(uint16_t *arr, arrsize_t arrsize, SortFunc sort)
+{
+    xss_sort_float16<X86_SIMD_SORT_INFINITYBF16>(arr, arrsize, sort);
+}
+
+template <typename SortFunc>
+X86_SIMD_SORT_INLINE void
+xss_sort_fp16(uint16_t *arr, arrsize_t arrsize, SortFunc sort)
+{
+    xss_sort_float16<X86_SIMD_SORT_INFINITYH>(arr, arrsize, sort);
+}
+
+/*
+ * argsort and argselect of bfloat16 keys into arg: the packed 16-bit argsort
+ * of a mapped copy of the keys
+ */
+#define DEFINE_BF16_PACKED_ARG_METHODS(ISA) \
+    template <typename index_t> \
+    X86_SIMD_SORT_INLINE void ISA##_argsort_bf16(uint16_t *arr, \
+                                                 index_t *arg, \
+                                                 arrsize_t arrsize, \
+                                                 bool hasnan = false, \
+                                                 bool descending = false) \
+    { \
+        std::vector<int16_t> keys(arrsize); \
+        xss_float16_to_int16<X86_SIMD_SORT_INFINITYBF16>( \
+                arr, keys.data(), arrsize); \
+        ISA##_argsort_16bit(keys.data(), arg, arrsize, hasnan, descending); \
+    } \
+    template <typename index_t> \
+    X86_SIMD_SORT_INLINE void ISA##_argselect_bf16(uint16_t *arr, \
+                                                   index_t *arg, \
+                                                   arrsize_t k, \
+                                                   arrsize_t arrsize, \
+                                                   bool hasnan = false) \
+    { \
+        std::vector<int16_t> keys(arrsize); \
+        xss_float16_to_int16<X86_SIMD_SORT_INFINITYBF16>( \
+                arr, keys.data(), arrsize); \
+        ISA##_argselect_16bit(keys.data(), arg, k, arrsize, hasnan); \
+    }
+
+DEFINE_BF16_PACKED_ARG_METHODS(avx512)
+DEFINE_BF16_PACKED_ARG_METHODS(avx2)
+
+#endif // XSS_BFLOAT16
@@ -11,14 +11,14 @@
 #include "xss-network-keyvaluesort.hpp"
 #include <numeric>
 
-template <typename T>
+template <typename T, typename index_t>
 X86_SIMD_SORT_INLINE void std_argselect_withnan(
-        T *arr, arrsize_t *arg, arrsize_t k, arrsize_t left, arrsize_t right)
+        T *arr, index_t *arg, arrsize_t k, arrsize_t left, arrsize_t right)
 {
     std::nth_element(arg + left,
                      arg + k,
                      arg + right,
-                     [arr](arrsize_t a, arrsize_t b) -> bool {
+                     [arr](index_t a, index_t b) -> bool {
                          if ((!std::isnan(arr[a])) && (!std::isnan(arr[b]))) {
                              return arr[a] < arr[b];
                          }
@@ -31,37 +31,57 @@ X86_SIMD_SORT_INLINE void std_argselect_withnan(
                      });
 }
 
-/* argsort using std::sort */
-template <typename T>
-X86_SIMD_SORT_INLINE void
-std_argsort_withnan(T *arr, arrsize_t *arg, arrsize_t left, arrsize_t right)
+/* True if one of the elements of arr indexed by arg[0, arrsize) is a NaN */
+template <typename T, typename index_t>
+X86_SIMD_SORT_INLINE bool arg_has_nan(T *arr, index_t *arg, arrsize_t arrsize)
 {
-    std::sort(arg + left,
-              arg + right,
-              [arr](arrsize_t left, arrsize_t right) -> bool {
-                  if ((!std::isnan(arr[left])) && (!std::isnan(arr[right]))) {
-                      return arr[left] < arr[right];
-                  }
-                  else if (std::isnan(arr[left])) {
-                      return false;
-                  }
-                  else {
-                      return true;
-                  }
-              });
+    for (arrsize_t i = 0; i < arrsize; i++) {
+        if (std::isnan(arr[arg[i]])) { return true; }
+    }
+    return false;
 }
 
-/* argsort using std::sort */
-template <typename T>
-X86_SIMD_SORT_INLINE void
-std_argsort(T *arr, arrsize_t *arg, arrsize_t left, arrsize_t right)
+/*
+ * argsort of arg[0, arrsize) using std::sort, in the order of vtype: the in
+ * place fallback when there is no memory for the merge sort
+ */
+template <typename vtype, typename T, typename index_t>
+X86_SIMD_SORT_INLINE void std_argsort(T *arr, index_t *arg, arrsize_t arrsize)
 {
-    std::sort(arg + left,
-              arg + right,
-              [arr](arrsize_t left, arrsize_t right) -> bool {
-                  // sort indices according to corresponding array element
-                  return arr[left] < arr[right];
-              });
+    std::sort(arg, arg + arrsize, [arr](index_t left, index_t right) -> bool {
+        return comparison_func<vtype>(arr[left], arr[right]);
+    });
+}
+
+/* argsort using std::sort, NaNs sort after +inf */
+template <typename T, typename index_t>
+X86_SIMD_SORT_INLINE void std_argsort_withnan(T *arr,
+                                              index_t *arg,
+                                              arrsize_t left,
+                                              arrsize_t right,
+                                              bool descending = false)
+{
+    auto less = [arr](index_t left, index_t right) -> bool {
+        if ((!std::isnan(arr[left])) && (!std::isnan(arr[right]))) {
+            return arr[left] < arr[right];
+        }
+        else if (std::isnan(arr[left])) {
+            return false;
+        }
+        else {
+            return true;
+        }
+    };
+    if (descending) {
+        std::sort(arg + left,
+                  arg + right,
+                  [less](index_t left, index_t right) -> bool {
+                      return less(right, left);
+                  });
+    }
+    else {
+        std::sort(arg + left, arg + right, less);
+    }
 }
 
 /*
@@ -172,14 +192,17 @@ X86_SIMD_SORT_INLINE int32_t partition_vec(type_t *arg,
  * Parition an array based on the pivot and returns the index of the
  * last element that is less than equal to the pivot.
  */
-template <typename vtype, typename argtype, typename type_t>
-X86_SIMD_SORT_INLINE arrsize_t partition_avx512(type_t *arr,
-                                                arrsize_t *arg,
-                                                arrsize_t left,
-                                                arrsize_t right,
-                                                type_t pivot,
-                                                type_t *smallest,
-                                                type_t *biggest)
+template <typename vtype,
+          typename argtype,
+          typename type_t,
+          typename index_t>
+X86_SIMD_SORT_INLINE arrsize_t argpartition_avx512(type_t *arr,
+                                                   index_t *arg,
+                                                   arrsize_t left,
+                                                   arrsize_t right,
+                                                   type_t pivot,
+                                                   type_t *smallest,
+                                                   type_t *biggest)
 {
     /* make array length divisible by vtype::numlanes , shortening the array */
     for (int32_t i = (right - left) % vtype::numlanes; i > 0; --i) {
@@ -291,17 +314,18 @@ X86_SIMD_SORT_INLINE arrsize_t partition_avx512(type_t *arr,
 template <typename vtype,
           typename argtype,
           int num_unroll,
-          typename type_t = typename vtype::type_t>
-X86_SIMD_SORT_INLINE arrsize_t partition_avx512_unrolled(type_t *arr,
-                                                         arrsize_t *arg,
-                                                         arrsize_t left,
-                                                         arrsize_t right,
-                                                         type_t pivot,
-                                                         type_t *smallest,
-                                                         type_t *biggest)
+          typename type_t = typename vtype::type_t,
+          typename index_t>
+X86_SIMD_SORT_INLINE arrsize_t argpartition_avx512_unrolled(type_t *arr,
+                                                            index_t *arg,
+                                                            arrsize_t left,
+                                                            arrsize_t right,
+                                                            type_t pivot,
+                                                            type_t *smallest,
+                                                            type_t *biggest)
 {
     if (right - left <= 8 * num_unroll * vtype::numlanes) {
-        return partition_avx512<vtype, argtype>(
+        return argpartition_avx512<vtype, argtype>(
                 arr, arg, left, right, pivot, smallest, biggest);
     }
     /* make array length divisible by vtype::numlanes , shortening the array */
@@ -422,28 +446,25 @@ X86_SIMD_SORT_INLINE arrsize_t partition_avx512_unrolled(type_t *arr,
     return l_store;
 }
 
-template <typename vtype, typename type_t>
+template <typename vtype, typename type_t, typename index_t>
 X86_SIMD_SORT_INLINE type_t get_pivot_64bit(type_t *arr,
-                                            arrsize_t *arg,
+                                            index_t *arg,
                                             const arrsize_t left,
                                             const arrsize_t right)
 {
-    if constexpr (vtype::numlanes == 8) {
+    if constexpr (vtype::numlanes >= 8) {
         if (right - left >= vtype::numlanes) {
-            // median of 8
-            arrsize_t size = (right - left) / 8;
+            // median of 8 or 16
+            arrsize_t size = (right - left) / vtype::numlanes;
+            type_t samples[vtype::numlanes];
+            for (int i = 0; i < vtype::numlanes; i++) {
+                samples[i] = arr[arg[left + (i + 1) * size]];
+            }
             using reg_t = typename vtype::reg_t;
-            reg_t rand_vec = vtype::set(arr[arg[left + size]],
-                                        arr[arg[left + 2 * size]],
-                                        arr[arg[left + 3 * size]],
-                                        arr[arg[left + 4 * size]],
-                                        arr[arg[left + 5 * size]],
-                                        arr[arg[left + 6 * size]],
-                                        arr[arg[left + 7 * size]],
-                                        arr[arg[left + 8 * size]]);
             // pivot will never be a nan, since there are no nan's!
-            reg_t sort = vtype::sort_vec(rand_vec);
-            return ((type_t *)&sort)[4];
+            reg_t sort = vtype::sort_vec(vtype::loadu(samples));
+            vtype::storeu(samples, sort);
+            return samples[vtype::numlanes / 2];
         }
         else {
             return arr[arg[right]];
@@ -468,18 +489,61 @@ X86_SIMD_SORT_INLINE type_t get_pivot_64bit(type_t *arr,
     }
 }
 
-template <typename vtype, typename argtype, typename type_t>
+/*
+ * Sorts runs of 256 indices with the bitonic networks, then merges them with
+ * the SIMD key-value merge on a copy of the keys in the order of arg. keys
+ * is a buffer of arrsize elements, which holds arr[arg[i]] on return. Used
+ * when quicksort isnt making any progress, and by the stable argsort. Without
+ * memory for the merge buffers, arg is sorted in place with std::sort.
+ */
+template <typename vtype,
+          typename argtype,
+          typename type_t,
+          typename index_t>
+X86_SIMD_SORT_INLINE void argsort_merge_sort_(type_t *arr,
+                                              index_t *arg,
+                                              arrsize_t arrsize,
+                                              type_t *keys)
+{
+    constexpr int run = 256;
+    for (arrsize_t i = 0; i < arrsize; i += run) {
+        int32_t n = (int32_t)std::min((arrsize_t)run, arrsize - i);
+        argsort_n<vtype, argtype, run>(arr, arg + i, n);
+    }
+    for (arrsize_t i = 0; i < arrsize; ++i) {
+        keys[i] = arr[arg[i]];
+    }
+    if (!kv_merge_runs_<vtype, argtype>(keys, arg, arrsize, run)) {
+        std_argsort<vtype>(arr, arg, arrsize);
+        for (arrsize_t i = 0; i < arrsize; ++i) {
+            keys[i] = arr[arg[i]];
+        }
+    }
+}
+
+template <typename vtype,
+          typename argtype,
+          typename type_t,
+          typename index_t>
 X86_SIMD_SORT_INLINE void argsort_64bit_(type_t *arr,
-                                         arrsize_t *arg,
+                                         index_t *arg,
                                          arrsize_t left,
                                          arrsize_t right,
                                          arrsize_t max_iters)
 {
     /*
-     * Resort to std::sort if quicksort isnt making any progress
+     * Resort to the SIMD merge sort if quicksort isnt making any progress
      */
     if (max_iters <= 0) {
-        std_argsort(arr, arg, left, right + 1);
+        std::unique_ptr<type_t[]> keys(
+                new (std::nothrow) type_t[right + 1 - left]);
+        if (keys) {
+            argsort_merge_sort_<vtype, argtype>(
+                    arr, arg + left, right + 1 - left, keys.get());
+        }
+        else {
+            std_argsort<vtype>(arr, arg + left, right + 1 - left);
+        }
         return;
     }
     /*
@@ -493,7 +557,7 @@ X86_SIMD_SORT_INLINE void argsort_64bit_(type_t *arr,
     type_t pivot = get_pivot_64bit<vtype>(arr, arg, left, right);
     type_t smallest = vtype::type_max();
     type_t biggest = vtype::type_min();
-    arrsize_t pivot_index = partition_avx512_unrolled<vtype, argtype, 4>(
+    arrsize_t pivot_index = argpartition_avx512_unrolled<vtype, argtype, 4>(
             arr, arg, left, right + 1, pivot, &smallest, &biggest);
     if (pivot != smallest)
         argsort_64bit_<vtype, argtype>(
@@ -503,19 +567,30 @@ X86_SIMD_SORT_INLINE void argsort_64bit_(type_t *arr,
                 arr, arg, pivot_index, right, max_iters - 1);
 }
 
-template <typename vtype, typename argtype, typename type_t>
+template <typename vtype,
+          typename argtype,
+          typename type_t,
+          typename index_t>
 X86_SIMD_SORT_INLINE void argselect_64bit_(type_t *arr,
-                                           arrsize_t *arg,
+                                           index_t *arg,
                                            arrsize_t pos,
                                            arrsize_t left,
                                            arrsize_t right,
                                            arrsize_t max_iters)
 {
     /*
-     * Resort to std::sort if quicksort isnt making any progress
+     * Resort to the SIMD merge sort if quicksort isnt making any progress
      */
     if (max_iters <= 0) {
-        std_argsort(arr, arg, left, right + 1);
+        std::unique_ptr<type_t[]> keys(
+                new (std::nothrow) type_t[right + 1 - left]);
+        if (keys) {
+            argsort_merge_sort_<vtype, argtype>(
+                    arr, arg + left, right + 1 - left, keys.get());
+        }
+        else {
+            std_argsort<vtype>(arr, arg + left, right + 1 - left);
+        }
         return;
     }
     /*
@@ -529,7 +604,7 @@ X86_SIMD_SORT_INLINE void argselect_64bit_(type_t *arr,
     type_t pivot = get_pivot_64bit<vtype>(arr, arg, left, right);
     type_t smallest = vtype::type_max();
     type_t biggest = vtype::type_min();
-    arrsize_t pivot_index = partition_avx512_unrolled<vtype, argtype, 4>(
+    arrsize_t pivot_index = argpartition_avx512_unrolled<vtype, argtype, 4>(
             arr, arg, left, right + 1, pivot, &smallest, &biggest);
     if ((pivot != smallest) && (pos < pivot_index))
         argselect_64bit_<vtype, argtype>(
@@ -539,101 +614,152 @@ X86_SIMD_SORT_INLINE void argselect_64bit_(type_t *arr,
                 arr, arg, pos, pivot_index, right, max_iters - 1);
 }
 
-/* argsort methods for 32-bit and 64-bit dtypes */
-template <typename T>
-X86_SIMD_SORT_INLINE void
-avx512_argsort(T *arr, arrsize_t *arg, arrsize_t arrsize, bool hasnan = false)
-{
-    /* TODO optimization: on 32-bit, use zmm_vector for 32-bit dtype */
-    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+/*
+ * Key and index vtypes for argsort: a key register is paired with an index
+ * register of the same number of lanes. On AVX-512 the narrower of the two
+ * types uses a half width vector, so 32-bit keys with uint32_t indices use
+ * full registers. 128-bit keys are 8 to a pair of registers, which uint64_t
+ * indices fill. The AVX2 key-value networks only handle 4 lanes, so 32-bit
+ * types always use half width vectors there.
+ */
+template <typename T, typename index_t>
+struct avx512_argsort_vtypes {
+    using vectype = typename std::conditional<sizeof(T) < sizeof(index_t),
                                               ymm_vector<T>,
                                               zmm_vector<T>>::type;
-
+    using argtype = typename std::conditional<sizeof(index_t) < sizeof(T)
+                                                      && sizeof(index_t) < 8,
+                                              ymm_vector<index_t>,
+                                              zmm_vector<index_t>>::type;
+};
+
+template <typename T, typename index_t>
+struct avx2_argsort_vtypes {
+    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              avx2_half_vector<T>,
+                                              avx2_vector<T>>::type;
     using argtype =
-            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
-                                      ymm_vector<arrsize_t>,
-                                      zmm_vector<arrsize_t>>::type;
+            typename std::conditional<sizeof(index_t) == sizeof(int32_t),
+                                      avx2_half_vector<index_t>,
+                                      avx2_vector<index_t>>::type;
+};
+
+/*
+ * argsort methods for 32-bit and 64-bit dtypes: arg holds arrsize indices
+ * into arr, 0, ..., arrsize - 1 or any subset of the indices of a larger arr.
+ * The indices are either arrsize_t or uint32_t.
+ */
+template <typename T, typename index_t>
+X86_SIMD_SORT_INLINE void avx512_argsort(T *arr,
+                                         index_t *arg,
+                                         arrsize_t arrsize,
+                                         bool hasnan = false,
+                                         bool descending = false)
+{
+    using vectype = typename avx512_argsort_vtypes<T, index_t>::vectype;
+    using argtype = typename avx512_argsort_vtypes<T, index_t>::argtype;
 
     if (arrsize > 1) {
         if constexpr (std::is_floating_point_v<T>) {
-            if ((hasnan) && (array_has_nan<vectype>(arr, arrsize))) {
-                std_argsort_withnan(arr, arg, 0, arrsize);
+            if ((hasnan) && (arg_has_nan(arr, arg, arrsize))) {
+                std_argsort_withnan(arr, arg, 0, arrsize, descending);
                 return;
             }
         }
         UNUSED(hasnan);
-        argsort_64bit_<vectype, argtype>(
-                arr, arg, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        if (descending) {
+            argsort_64bit_<xss_descending<vectype>, argtype>(
+                    arr, arg, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        }
+        else {
+            argsort_64bit_<vectype, argtype>(
+                    arr, arg, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        }
     }
 }
 
 template <typename T>
-X86_SIMD_SORT_INLINE std::vector<arrsize_t>
-avx512_argsort(T *arr, arrsize_t arrsize, bool hasnan = false)
+X86_SIMD_SORT_INLINE std::vector<arrsize_t> avx512_argsort(T *arr,
+                                                       arrsize_t arrsize,
+                                                       bool hasnan = false,
+                                                       bool descending = false)
 {
+    /*
+     * 32-bit keys with 64-bit indices only fill half a ZMM register. The
+     * indices are allocated here anyway, so sort uint32_t indices instead,
+     * which partitions 16 keys at a time, and widen them into the result.
+     */
+    if constexpr (sizeof(T) == sizeof(uint32_t)
+                  && sizeof(arrsize_t) > sizeof(uint32_t)) {
+        if (arrsize > 256 && arrsize <= std::numeric_limits<uint32_t>::max()) {
+            std::vector<uint32_t> arg32(arrsize);
+            std::iota(arg32.begin(), arg32.end(), 0);
+            avx512_argsort(arr, arg32.data(), arrsize, hasnan, descending);
+            return std::vector<arrsize_t>(arg32.begin(), arg32.end());
+        }
+    }
     std::vector<arrsize_t> indices(arrsize);
     std::iota(indices.begin(), indices.end(), 0);
-    avx512_argsort<T>(arr, indices.data(), arrsize, hasnan);
+    avx512_argsort(arr, indices.data(), arrsize, hasnan, descending);
     return indices;
 }
 
 /* argsort methods for 32-bit and 64-bit dtypes */
-template <typename T>
-X86_SIMD_SORT_INLINE void
-avx2_argsort(T *arr, arrsize_t *arg, arrsize_t arrsize, bool hasnan = false)
+template <typename T, typename index_t>
+X86_SIMD_SORT_INLINE void avx2_argsort(T *arr,
+                                       index_t *arg,
+                                       arrsize_t arrsize,
+                                       bool hasnan = false,
+                                       bool descending = false)
 {
-    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
-                                              avx2_half_vector<T>,
-                                              avx2_vector<T>>::type;
+    using vectype = typename avx2_argsort_vtypes<T, index_t>::vectype;
+    using argtype = typename avx2_argsort_vtypes<T, index_t>::argtype;
 
-    using argtype =
-            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
-                                      avx2_half_vector<arrsize_t>,
-                                      avx2_vector<arrsize_t>>::type;
     if (arrsize > 1) {
         if constexpr (std::is_floating_point_v<T>) {
-            if ((hasnan) && (array_has_nan<vectype>(arr, arrsize))) {
-                std_argsort_withnan(arr, arg, 0, arrsize);
+            if ((hasnan) && (arg_has_nan(arr, arg, arrsize))) {
+                std_argsort_withnan(arr, arg, 0, arrsize, descending);
                 return;
             }
         }
         UNUSED(hasnan);
-        argsort_64bit_<vectype, argtype>(
-                arr, arg, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        if (descending) {
+            argsort_64bit_<xss_descending<vectype>, argtype>(
+                    arr, arg, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        }
+        else {
+            argsort_64bit_<vectype, argtype>(
+                    arr, arg, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+        }
     }
 }
 
 template <typename T>
-X86_SIMD_SORT_INLINE std::vector<arrsize_t>
-avx2_argsort(T *arr, arrsize_t arrsize, bool hasnan = false)
+X86_SIMD_SORT_INLINE std::vector<arrsize_t> avx2_argsort(T *arr,
+                                                     arrsize_t arrsize,
+                                                     bool hasnan = false,
+                                                     bool descending = false)
 {
     std::vector<arrsize_t> indices(arrsize);
     std::iota(indices.begin(), indices.end(), 0);
-    avx2_argsort<T>(arr, indices.data(), arrsize, hasnan);
+    avx2_argsort(arr, indices.data(), arrsize, hasnan, descending);
     return indices;
 }
 
 /* argselect methods for 32-bit and 64-bit dtypes */
-template <typename T>
+template <typename T, typename index_t>
 X86_SIMD_SORT_INLINE void avx512_argselect(T *arr,
-                                           arrsize_t *arg,
+                                           index_t *arg,
                                            arrsize_t k,
                                            arrsize_t arrsize,
                                            bool hasnan = false)
 {
-    /* TODO optimization: on 32-bit, use zmm_vector for 32-bit dtype */
-    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
-                                              ymm_vector<T>,
-                                              zmm_vector<T>>::type;
-
-    using argtype =
-            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
-                                      ymm_vector<arrsize_t>,
-                                      zmm_vector<arrsize_t>>::type;
+    using vectype = typename avx512_argsort_vtypes<T, index_t>::vectype;
+    using argtype = typename avx512_argsort_vtypes<T, index_t>::argtype;
 
     if (arrsize > 1) {
         if constexpr (std::is_floating_point_v<T>) {
-            if ((hasnan) && (array_has_nan<vectype>(arr, arrsize))) {
+            if ((hasnan) && (arg_has_nan(arr, arg, arrsize))) {
                 std_argselect_withnan(arr, arg, k, 0, arrsize);
                 return;
             }
@@ -650,30 +776,24 @@ avx512_argselect(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan = false)
 {
     std::vector<arrsize_t> indices(arrsize);
     std::iota(indices.begin(), indices.end(), 0);
-    avx512_argselect<T>(arr, indices.data(), k, arrsize, hasnan);
+    avx512_argselect(arr, indices.data(), k, arrsize, hasnan);
     return indices;
 }
 
 /* argselect methods for 32-bit and 64-bit dtypes */
-template <typename T>
+template <typename T, typename index_t>
 X86_SIMD_SORT_INLINE void avx2_argselect(T *arr,
-                                         arrsize_t *arg,
+                                         index_t *arg,
                                          arrsize_t k,
                                          arrsize_t arrsize,
                                          bool hasnan = false)
 {
-    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
-                                              avx2_half_vector<T>,
-                                              avx2_vector<T>>::type;
-
-    using argtype =
-            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
-                                      avx2_half_vector<arrsize_t>,
-                                      avx2_vector<arrsize_t>>::type;
+    using vectype = typename avx2_argsort_vtypes<T, index_t>::vectype;
+    using argtype = typename avx2_argsort_vtypes<T, index_t>::argtype;
 
     if (arrsize > 1) {
         if constexpr (std::is_floating_point_v<T>) {
-            if ((hasnan) && (array_has_nan<vectype>(arr, arrsize))) {
+            if ((hasnan) && (arg_has_nan(arr, arg, arrsize))) {
                 std_argselect_withnan(arr, arg, k, 0, arrsize);
                 return;
             }
@@ -690,7 +810,7 @@ avx2_argselect(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan = false)
 {
     std::vector<arrsize_t> indices(arrsize);
     std::iota(indices.begin(), indices.end(), 0);
-    avx2_argselect<T>(arr, indices.data(), k, arrsize, hasnan);
+    avx2_argselect(arr, indices.data(), k, arrsize, hasnan);
     return indices;
 }
 
@@ -12,6 +12,7 @@
 #define X86_SIMD_SORT_INFINITYF std::numeric_limits<float>::infinity()
 #define X86_SIMD_SORT_INFINITYH 0x7c00
 #define X86_SIMD_SORT_NEGINFINITYH 0xfc00
+#define X86_SIMD_SORT_INFINITYBF16 0x7f80
 #define X86_SIMD_SORT_MAX_UINT16 std::numeric_limits<uint16_t>::max()
 #define X86_SIMD_SORT_MAX_INT16 std::numeric_limits<int16_t>::max()
 #define X86_SIMD_SORT_MIN_INT16 std::numeric_limits<int16_t>::min()
@@ -106,6 +107,16 @@ struct avx2_vector;
 template <typename type>
 struct avx2_half_vector;
 
+/* vtype with its order reversed, defined in xss-common-qsort.h */
+template <typename vtype>
+struct xss_descending;
+
+template <typename vtype>
+constexpr bool is_descending_v = false;
+
+template <typename vtype>
+constexpr bool is_descending_v<xss_descending<vtype>> = true;
+
 enum class simd_type : int { AVX2, AVX512 };
 
 template <typename vtype, typename T = typename vtype::type_t>
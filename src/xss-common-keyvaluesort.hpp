@@ -0,0 +1,659 @@
+/*******************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause
+ * Authors: Liu Zhuan <zhuan.liu@intel.com>
+ *          Tang Xi <xi.tang@intel.com>
+ * ****************************************************************/
+
+#ifndef XSS_COMMON_KEYVALUESORT
+#define XSS_COMMON_KEYVALUESORT
+
+#include "xss-common-qsort.h"
+#include "xss-network-keyvaluesort.hpp"
+#include "xss-packed-16bit.hpp"
+
+/*
+ * Parition one ZMM register based on the pivot and returns the index of the
+ * last element that is less than equal to the pivot.
+ */
+template <typename vtype1,
+          typename vtype2,
+          typename type_t1 = typename vtype1::type_t,
+          typename type_t2 = typename vtype2::type_t,
+          typename reg_t1 = typename vtype1::reg_t,
+          typename reg_t2 = typename vtype2::reg_t>
+X86_SIMD_SORT_INLINE int32_t partition_vec_avx512(type_t1 *keys,
+                                           type_t2 *indexes,
+                                           arrsize_t left,
+                                           arrsize_t right,
+                                           const reg_t1 keys_vec,
+                                           const reg_t2 indexes_vec,
+                                           const reg_t1 pivot_vec,
+                                           reg_t1 *smallest_vec,
+                                           reg_t1 *biggest_vec)
+{
+    /* which elements are larger than the pivot */
+    typename vtype1::opmask_t gt_mask = vtype1::ge(keys_vec, pivot_vec);
+    int32_t amount_gt_pivot = _mm_popcnt_u32((int32_t)gt_mask);
+    vtype1::mask_compressstoreu(
+            keys + left, vtype1::knot_opmask(gt_mask), keys_vec);
+    vtype1::mask_compressstoreu(
+            keys + right - amount_gt_pivot, gt_mask, keys_vec);
+    vtype2::mask_compressstoreu(
+            indexes + left, vtype2::knot_opmask(gt_mask), indexes_vec);
+    vtype2::mask_compressstoreu(
+            indexes + right - amount_gt_pivot, gt_mask, indexes_vec);
+    *smallest_vec = vtype1::min(keys_vec, *smallest_vec);
+    *biggest_vec = vtype1::max(keys_vec, *biggest_vec);
+    return amount_gt_pivot;
+}
+
+/*
+ * Parition one AVX2 register based on the pivot and returns the index of the
+ * last element that is less than equal to the pivot.
+ */
+template <typename vtype1,
+          typename vtype2,
+          typename type_t1 = typename vtype1::type_t,
+          typename type_t2 = typename vtype2::type_t,
+          typename reg_t1 = typename vtype1::reg_t,
+          typename reg_t2 = typename vtype2::reg_t>
+X86_SIMD_SORT_INLINE int32_t partition_vec_avx2(type_t1 *keys,
+                                                type_t2 *indexes,
+                                                arrsize_t left,
+                                                arrsize_t right,
+                                                const reg_t1 keys_vec,
+                                                const reg_t2 indexes_vec,
+                                                const reg_t1 pivot_vec,
+                                                reg_t1 *smallest_vec,
+                                                reg_t1 *biggest_vec)
+{
+    /* which elements are larger than the pivot */
+    typename vtype1::opmask_t ge_mask = vtype1::ge(keys_vec, pivot_vec);
+    typename vtype2::opmask_t ge_mask_vtype2
+            = resize_mask<vtype1, vtype2>(ge_mask);
+
+    int32_t amount_ge_pivot
+            = vtype1::double_compressstore(keys + left,
+                                           keys + right - vtype1::numlanes,
+                                           ge_mask,
+                                           keys_vec);
+    vtype2::double_compressstore(indexes + left,
+                                 indexes + right - vtype2::numlanes,
+                                 ge_mask_vtype2,
+                                 indexes_vec);
+    *smallest_vec = vtype1::min(keys_vec, *smallest_vec);
+    *biggest_vec = vtype1::max(keys_vec, *biggest_vec);
+    return amount_ge_pivot;
+}
+
+template <typename vtype1,
+          typename vtype2,
+          typename type_t1 = typename vtype1::type_t,
+          typename type_t2 = typename vtype2::type_t,
+          typename reg_t1 = typename vtype1::reg_t,
+          typename reg_t2 = typename vtype2::reg_t>
+X86_SIMD_SORT_INLINE int32_t partition_vec(type_t1 *keys,
+                                           type_t2 *indexes,
+                                           arrsize_t left,
+                                           arrsize_t right,
+                                           const reg_t1 keys_vec,
+                                           const reg_t2 indexes_vec,
+                                           const reg_t1 pivot_vec,
+                                           reg_t1 *smallest_vec,
+                                           reg_t1 *biggest_vec)
+{
+    if constexpr (vtype1::vec_type == simd_type::AVX512) {
+        return partition_vec_avx512<vtype1, vtype2>(keys,
+                                                    indexes,
+                                                    left,
+                                                    right,
+                                                    keys_vec,
+                                                    indexes_vec,
+                                                    pivot_vec,
+                                                    smallest_vec,
+                                                    biggest_vec);
+    }
+    else if constexpr (vtype1::vec_type == simd_type::AVX2) {
+        return partition_vec_avx2<vtype1, vtype2>(keys,
+                                                  indexes,
+                                                  left,
+                                                  right,
+                                                  keys_vec,
+                                                  indexes_vec,
+                                                  pivot_vec,
+                                                  smallest_vec,
+                                                  biggest_vec);
+    }
+    else {
+        static_assert(sizeof(reg_t2) == 0, "Should not get here");
+    }
+}
+/*
+ * Parition an array based on the pivot and returns the index of the
+ * last element that is less than equal to the pivot.
+ */
+template <typename vtype1,
+          typename vtype2,
+          typename type_t1 = typename vtype1::type_t,
+          typename type_t2 = typename vtype2::type_t,
+          typename reg_t1 = typename vtype1::reg_t,
+          typename reg_t2 = typename vtype2::reg_t>
+X86_SIMD_SORT_INLINE arrsize_t partition_avx512(type_t1 *keys,
+                                                type_t2 *indexes,
+                                                arrsize_t left,
+                                                arrsize_t right,
+                                                type_t1 pivot,
+                                                type_t1 *smallest,
+                                                type_t1 *biggest)
+{
+    /* make array length divisible by vtype1::numlanes , shortening the array */
+    for (int32_t i = (right - left) % vtype1::numlanes; i > 0; --i) {
+        *smallest = std::min(*smallest, keys[left], comparison_func<vtype1>);
+        *biggest = std::max(*biggest, keys[left], comparison_func<vtype1>);
+        if (comparison_func<vtype1>(pivot, keys[left])) {
+            right--;
+            std::swap(keys[left], keys[right]);
+            std::swap(indexes[left], indexes[right]);
+        }
+        else {
+            ++left;
+        }
+    }
+
+    if (left == right)
+        return left; /* less than vtype1::numlanes elements in the array */
+
+    reg_t1 pivot_vec = vtype1::set1(pivot);
+    reg_t1 min_vec = vtype1::set1(*smallest);
+    reg_t1 max_vec = vtype1::set1(*biggest);
+
+    if (right - left == vtype1::numlanes) {
+        reg_t1 keys_vec = vtype1::loadu(keys + left);
+        int32_t amount_gt_pivot;
+
+        reg_t2 indexes_vec = vtype2::loadu(indexes + left);
+        amount_gt_pivot = partition_vec<vtype1, vtype2>(keys,
+                                                        indexes,
+                                                        left,
+                                                        left + vtype1::numlanes,
+                                                        keys_vec,
+                                                        indexes_vec,
+                                                        pivot_vec,
+                                                        &min_vec,
+                                                        &max_vec);
+
+        *smallest = vtype1::reducemin(min_vec);
+        *biggest = vtype1::reducemax(max_vec);
+        return left + (vtype1::numlanes - amount_gt_pivot);
+    }
+
+    // first and last vtype1::numlanes values are partitioned at the end
+    reg_t1 keys_vec_left = vtype1::loadu(keys + left);
+    reg_t1 keys_vec_right = vtype1::loadu(keys + (right - vtype1::numlanes));
+    reg_t2 indexes_vec_left;
+    reg_t2 indexes_vec_right;
+    indexes_vec_left = vtype2::loadu(indexes + left);
+    indexes_vec_right = vtype2::loadu(indexes + (right - vtype1::numlanes));
+
+    // store points of the vectors
+    arrsize_t r_store = right - vtype1::numlanes;
+    arrsize_t l_store = left;
+    // indices for loading the elements
+    left += vtype1::numlanes;
+    right -= vtype1::numlanes;
+    while (right - left != 0) {
+        reg_t1 keys_vec;
+        reg_t2 indexes_vec;
+        /*
+         * if fewer elements are stored on the right side of the array,
+         * then next elements are loaded from the right side,
+         * otherwise from the left side
+         */
+        if ((r_store + vtype1::numlanes) - right < left - l_store) {
+            right -= vtype1::numlanes;
+            keys_vec = vtype1::loadu(keys + right);
+            indexes_vec = vtype2::loadu(indexes + right);
+        }
+        else {
+            keys_vec = vtype1::loadu(keys + left);
+            indexes_vec = vtype2::loadu(indexes + left);
+            left += vtype1::numlanes;
+        }
+        // partition the current vector and save it on both sides of the array
+        int32_t amount_gt_pivot;
+
+        amount_gt_pivot
+                = partition_vec<vtype1, vtype2>(keys,
+                                                indexes,
+                                                l_store,
+                                                r_store + vtype1::numlanes,
+                                                keys_vec,
+                                                indexes_vec,
+                                                pivot_vec,
+                                                &min_vec,
+                                                &max_vec);
+        r_store -= amount_gt_pivot;
+        l_store += (vtype1::numlanes - amount_gt_pivot);
+    }
+
+    /* partition and save vec_left and vec_right */
+    int32_t amount_gt_pivot;
+    amount_gt_pivot = partition_vec<vtype1, vtype2>(keys,
+                                                    indexes,
+                                                    l_store,
+                                                    r_store + vtype1::numlanes,
+                                                    keys_vec_left,
+                                                    indexes_vec_left,
+                                                    pivot_vec,
+                                                    &min_vec,
+                                                    &max_vec);
+    l_store += (vtype1::numlanes - amount_gt_pivot);
+    amount_gt_pivot = partition_vec<vtype1, vtype2>(keys,
+                                                    indexes,
+                                                    l_store,
+                                                    l_store + vtype1::numlanes,
+                                                    keys_vec_right,
+                                                    indexes_vec_right,
+                                                    pivot_vec,
+                                                    &min_vec,
+                                                    &max_vec);
+    l_store += (vtype1::numlanes - amount_gt_pivot);
+    *smallest = vtype1::reducemin(min_vec);
+    *biggest = vtype1::reducemax(max_vec);
+    return l_store;
+}
+
+template <typename vtype1,
+          typename vtype2,
+          int num_unroll,
+          typename type_t1 = typename vtype1::type_t,
+          typename type_t2 = typename vtype2::type_t,
+          typename reg_t1 = typename vtype1::reg_t,
+          typename reg_t2 = typename vtype2::reg_t>
+X86_SIMD_SORT_INLINE arrsize_t partition_avx512_unrolled(type_t1 *keys,
+                                                         type_t2 *indexes,
+                                                         arrsize_t left,
+                                                         arrsize_t right,
+                                                         type_t1 pivot,
+                                                         type_t1 *smallest,
+                                                         type_t1 *biggest)
+{
+    if (right - left <= 8 * num_unroll * vtype1::numlanes) {
+        return partition_avx512<vtype1, vtype2>(
+                keys, indexes, left, right, pivot, smallest, biggest);
+    }
+    /* make array length divisible by vtype1::numlanes , shortening the array */
+    for (int32_t i = ((right - left) % (num_unroll * vtype1::numlanes)); i > 0;
+         --i) {
+        *smallest = std::min(*smallest, keys[left], comparison_func<vtype1>);
+        *biggest = std::max(*biggest, keys[left], comparison_func<vtype1>);
+        if (comparison_func<vtype1>(pivot, keys[left])) {
+            right--;
+            std::swap(keys[left], keys[right]);
+            std::swap(indexes[left], indexes[right]);
+        }
+        else {
+            ++left;
+        }
+    }
+
+    if (left == right) return left;
+
+    reg_t1 pivot_vec = vtype1::set1(pivot);
+    reg_t1 min_vec = vtype1::set1(*smallest);
+    reg_t1 max_vec = vtype1::set1(*biggest);
+
+    // first and last vtype1::numlanes values are partitioned at the end
+    reg_t1 key_left[num_unroll], key_right[num_unroll];
+    reg_t2 indx_left[num_unroll], indx_right[num_unroll];
+    X86_SIMD_SORT_UNROLL_LOOP(8)
+    for (int ii = 0; ii < num_unroll; ++ii) {
+        indx_left[ii] = vtype2::loadu(indexes + left + vtype2::numlanes * ii);
+        key_left[ii] = vtype1::loadu(keys + left + vtype1::numlanes * ii);
+        indx_right[ii] = vtype2::loadu(
+                indexes + (right - vtype2::numlanes * (num_unroll - ii)));
+        key_right[ii] = vtype1::loadu(
+                keys + (right - vtype1::numlanes * (num_unroll - ii)));
+    }
+    // store points of the vectors
+    arrsize_t r_store = right - vtype1::numlanes;
+    arrsize_t l_store = left;
+    // indices for loading the elements
+    left += num_unroll * vtype1::numlanes;
+    right -= num_unroll * vtype1::numlanes;
+    while (right - left != 0) {
+        reg_t2 indx_vec[num_unroll];
+        reg_t1 curr_vec[num_unroll];
+        /*
+         * if fewer elements are stored on the right side of the array,
+         * then next elements are loaded from the right side,
+         * otherwise from the left side
+         */
+        if ((r_store + vtype1::numlanes) - right < left - l_store) {
+            right -= num_unroll * vtype1::numlanes;
+            X86_SIMD_SORT_UNROLL_LOOP(8)
+            for (int ii = 0; ii < num_unroll; ++ii) {
+                indx_vec[ii] = vtype2::loadu(indexes + right
+                                             + ii * vtype2::numlanes);
+                curr_vec[ii]
+                        = vtype1::loadu(keys + right + ii * vtype1::numlanes);
+            }
+        }
+        else {
+            X86_SIMD_SORT_UNROLL_LOOP(8)
+            for (int ii = 0; ii < num_unroll; ++ii) {
+                indx_vec[ii]
+                        = vtype2::loadu(indexes + left + ii * vtype2::numlanes);
+                curr_vec[ii]
+                        = vtype1::loadu(keys + left + ii * vtype1::numlanes);
+            }
+            left += num_unroll * vtype1::numlanes;
+        }
+        // partition the current vector and save it on both sides of the array
+        X86_SIMD_SORT_UNROLL_LOOP(8)
+        for (int ii = 0; ii < num_unroll; ++ii) {
+            int32_t amount_gt_pivot
+                    = partition_vec<vtype1, vtype2>(keys,
+                                                    indexes,
+                                                    l_store,
+                                                    r_store + vtype1::numlanes,
+                                                    curr_vec[ii],
+                                                    indx_vec[ii],
+                                                    pivot_vec,
+                                                    &min_vec,
+                                                    &max_vec);
+            l_store += (vtype1::numlanes - amount_gt_pivot);
+            r_store -= amount_gt_pivot;
+        }
+    }
+
+    /* partition and save key_left and key_right */
+    X86_SIMD_SORT_UNROLL_LOOP(8)
+    for (int ii = 0; ii < num_unroll; ++ii) {
+        int32_t amount_gt_pivot
+                = partition_vec<vtype1, vtype2>(keys,
+                                                indexes,
+                                                l_store,
+                                                r_store + vtype1::numlanes,
+                                                key_left[ii],
+                                                indx_left[ii],
+                                                pivot_vec,
+                                                &min_vec,
+                                                &max_vec);
+        l_store += (vtype1::numlanes - amount_gt_pivot);
+        r_store -= amount_gt_pivot;
+    }
+    X86_SIMD_SORT_UNROLL_LOOP(8)
+    for (int ii = 0; ii < num_unroll; ++ii) {
+        int32_t amount_gt_pivot
+                = partition_vec<vtype1, vtype2>(keys,
+                                                indexes,
+                                                l_store,
+                                                r_store + vtype1::numlanes,
+                                                key_right[ii],
+                                                indx_right[ii],
+                                                pivot_vec,
+                                                &min_vec,
+                                                &max_vec);
+        l_store += (vtype1::numlanes - amount_gt_pivot);
+        r_store -= amount_gt_pivot;
+    }
+    *smallest = vtype1::reducemin(min_vec);
+    *biggest = vtype1::reducemax(max_vec);
+    return l_store;
+}
+
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE void
+heapify(type1_t *keys, type2_t *indexes, arrsize_t idx, arrsize_t size)
+{
+    arrsize_t i = idx;
+    while (true) {
+        arrsize_t j = 2 * i + 1;
+        if (j >= size) { break; }
+        arrsize_t k = j + 1;
+        if (k < size && comparison_func<vtype1>(keys[j], keys[k])) { j = k; }
+        if (comparison_func<vtype1>(keys[j], keys[i])) { break; }
+        std::swap(keys[i], keys[j]);
+        std::swap(indexes[i], indexes[j]);
+        i = j;
+    }
+}
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE void
+heap_sort(type1_t *keys, type2_t *indexes, arrsize_t size)
+{
+    for (arrsize_t i = size / 2 - 1;; i--) {
+        heapify<vtype1, vtype2>(keys, indexes, i, size);
+        if (i == 0) { break; }
+    }
+    for (arrsize_t i = size - 1; i > 0; i--) {
+        std::swap(keys[0], keys[i]);
+        std::swap(indexes[0], indexes[i]);
+        heapify<vtype1, vtype2>(keys, indexes, 0, i);
+    }
+}
+
+/*
+ * Sorts runs of 128 pairs with the bitonic networks and merges them with the
+ * SIMD merge, for when quicksort isnt making any progress. Without memory
+ * for the merge buffers, the pairs are heap sorted in place instead.
+ */
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE void
+kv_merge_sort_(type1_t *keys, type2_t *indexes, arrsize_t size)
+{
+    constexpr int run = 128;
+    for (arrsize_t i = 0; i < size; i += run) {
+        int32_t n = (int32_t)std::min((arrsize_t)run, size - i);
+        kvsort_n<vtype1, vtype2, run>(keys + i, indexes + i, n);
+    }
+    if (!kv_merge_runs_<vtype1, vtype2>(keys, indexes, size, run)) {
+        heap_sort<vtype1, vtype2>(keys, indexes, size);
+    }
+}
+
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE void qsort_64bit_(type1_t *keys,
+                                       type2_t *indexes,
+                                       arrsize_t left,
+                                       arrsize_t right,
+                                       arrsize_t max_iters)
+{
+    /*
+     * Resort to the SIMD merge sort if quicksort isnt making any progress
+     */
+    if (max_iters <= 0) {
+        kv_merge_sort_<vtype1, vtype2>(
+                keys + left, indexes + left, right - left + 1);
+        return;
+    }
+    /*
+     * Base case: use bitonic networks to sort arrays <= 128
+     */
+    if (right + 1 - left <= 128) {
+
+        kvsort_n<vtype1, vtype2, 128>(
+                keys + left, indexes + left, (int32_t)(right + 1 - left));
+        return;
+    }
+
+    type1_t pivot = get_pivot_blocks<vtype1>(keys, left, right);
+    type1_t smallest = vtype1::type_max();
+    type1_t biggest = vtype1::type_min();
+    arrsize_t pivot_index = partition_avx512_unrolled<vtype1, vtype2, 4>(
+            keys, indexes, left, right + 1, pivot, &smallest, &biggest);
+    if (pivot != smallest) {
+        qsort_64bit_<vtype1, vtype2>(
+                keys, indexes, left, pivot_index - 1, max_iters - 1);
+    }
+    if (pivot != biggest) {
+        qsort_64bit_<vtype1, vtype2>(
+                keys, indexes, pivot_index, right, max_iters - 1);
+    }
+}
+
+/*
+ * 16-bit keys are packed with their values into 32-bit or 64-bit words (see
+ * xss-packed-16bit.hpp). 64-bit values do not fit and are replaced by their
+ * index, which then permutes them.
+ */
+template <typename vtype32, typename vtype64, typename T1, typename T2>
+X86_SIMD_SORT_INLINE void xss_qsort_kv_16bit(T1 *keys,
+                                             T2 *values,
+                                             arrsize_t arrsize,
+                                             bool descending)
+{
+    using word_t = typename std::
+            conditional<sizeof(T2) == sizeof(uint16_t), uint32_t, uint64_t>::type;
+    using low_t = typename std::
+            conditional<sizeof(T2) == sizeof(uint16_t), uint16_t, uint32_t>::type;
+    constexpr int shift = 8 * sizeof(word_t) - 16;
+    constexpr word_t lowmask = ((word_t)1 << shift) - 1;
+
+    if (arrsize <= 1) { return; }
+    std::vector<word_t> words(arrsize);
+    for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+        word_t low = ii;
+        if constexpr (sizeof(T2) != sizeof(uint64_t)) {
+            low_t bits;
+            std::memcpy(&bits, values + ii, sizeof(bits));
+            low = bits;
+        }
+        word_t key = xss_to_ordered_16bit(keys[ii], descending);
+        words[ii] = (key << shift) | low;
+    }
+    if constexpr (sizeof(word_t) == sizeof(uint32_t)) {
+        xss_qsort<vtype32, uint32_t>(words.data(), arrsize, false);
+    }
+    else {
+        xss_qsort<vtype64, uint64_t>(words.data(), arrsize, false);
+    }
+    if constexpr (sizeof(T2) == sizeof(uint64_t)) {
+        std::vector<T2> values_bckp(values, values + arrsize);
+        for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+            values[ii] = values_bckp[words[ii] & lowmask];
+        }
+    }
+    else {
+        for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+            low_t bits = (low_t)(words[ii] & lowmask);
+            std::memcpy(values + ii, &bits, sizeof(bits));
+        }
+    }
+    for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+        keys[ii] = xss_from_ordered_16bit<T1>(
+                (uint16_t)(words[ii] >> shift), descending);
+    }
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx512_qsort_kv(T1 *keys,
+                                          T2 *indexes,
+                                          arrsize_t arrsize,
+                                          bool hasnan = false,
+                                          bool descending = false)
+{
+    using keytype =
+            typename std::conditional<sizeof(T1) != sizeof(T2)
+                                              && sizeof(T1) == sizeof(int32_t),
+                                      ymm_vector<T1>,
+                                      zmm_vector<T1>>::type;
+    using valtype =
+            typename std::conditional<sizeof(T1) != sizeof(T2)
+                                              && sizeof(T2) == sizeof(int32_t),
+                                      ymm_vector<T2>,
+                                      zmm_vector<T2>>::type;
+
+    if constexpr (sizeof(T1) == sizeof(uint16_t)) {
+        UNUSED(hasnan);
+        xss_qsort_kv_16bit<zmm_vector<uint32_t>, zmm_vector<uint64_t>>(
+                keys, indexes, arrsize, descending);
+    }
+    else if (arrsize > 1) {
+        arrsize_t nan_count = 0;
+        if constexpr (std::is_floating_point_v<T1>) {
+            if (UNLIKELY(hasnan)) {
+                nan_count = replace_nan_with_inf<keytype>(keys, arrsize);
+            }
+        }
+        UNUSED(hasnan);
+        if (descending) {
+            qsort_64bit_<xss_descending<keytype>, valtype>(
+                    keys,
+                    indexes,
+                    0,
+                    arrsize - 1,
+                    2 * (arrsize_t)log2(arrsize));
+        }
+        else {
+            qsort_64bit_<keytype, valtype>(keys,
+                                           indexes,
+                                           0,
+                                           arrsize - 1,
+                                           2 * (arrsize_t)log2(arrsize));
+        }
+        replace_inf_with_nan(keys, arrsize, nan_count, descending);
+    }
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx2_qsort_kv(T1 *keys,
+                                        T2 *indexes,
+                                        arrsize_t arrsize,
+                                        bool hasnan = false,
+                                        bool descending = false)
+{
+    /* The key-value networks only handle 4 lanes on AVX2 */
+    using keytype = typename std::conditional<sizeof(T1) == sizeof(int32_t),
+                                              avx2_half_vector<T1>,
+                                              avx2_vector<T1>>::type;
+    using valtype = typename std::conditional<sizeof(T2) == sizeof(int32_t),
+                                              avx2_half_vector<T2>,
+                                              avx2_vector<T2>>::type;
+
+    if constexpr (sizeof(T1) == sizeof(uint16_t)) {
+        UNUSED(hasnan);
+        xss_qsort_kv_16bit<avx2_vector<uint32_t>, avx2_vector<uint64_t>>(
+                keys, indexes, arrsize, descending);
+    }
+    else if (arrsize > 1) {
+        arrsize_t nan_count = 0;
+        if constexpr (std::is_floating_point_v<T1>) {
+            if (UNLIKELY(hasnan)) {
+                nan_count = replace_nan_with_inf<keytype>(keys, arrsize);
+            }
+        }
+        UNUSED(hasnan);
+        if (descending) {
+            qsort_64bit_<xss_descending<keytype>, valtype>(
+                    keys,
+                    indexes,
+                    0,
+                    arrsize - 1,
+                    2 * (arrsize_t)log2(arrsize));
+        }
+        else {
+            qsort_64bit_<keytype, valtype>(keys,
+                                           indexes,
+                                           0,
+                                           arrsize - 1,
+                                           2 * (arrsize_t)log2(arrsize));
+        }
+        replace_inf_with_nan(keys, arrsize, nan_count, descending);
+    }
+}
+#endif // XSS_COMMON_KEYVALUESORT
@@ -97,18 +97,28 @@ X86_SIMD_SORT_INLINE bool array_has_nan(type_t *arr, arrsize_t size)
     return found_nan;
 }
 
+/*
+ * NaNs sort after +inf: they are written back at the end of an ascending
+ * sort and at the start of a descending one
+ */
 template <typename type_t>
-X86_SIMD_SORT_INLINE void
-replace_inf_with_nan(type_t *arr, arrsize_t size, arrsize_t nan_count)
+X86_SIMD_SORT_INLINE void replace_inf_with_nan(type_t *arr,
+                                               arrsize_t size,
+                                               arrsize_t nan_count,
+                                               bool descending = false)
 {
-    for (arrsize_t ii = size - 1; nan_count > 0; --ii) {
-        if constexpr (std::is_floating_point_v<type_t>) {
-            arr[ii] = std::numeric_limits<type_t>::quiet_NaN();
-        }
-        else {
-            arr[ii] = 0xFFFF;
-        }
-        nan_count -= 1;
+    type_t nan;
+    if constexpr (std::is_floating_point_v<type_t>) {
+        nan = std::numeric_limits<type_t>::quiet_NaN();
+    }
+    else {
+        nan = 0xFFFF;
+    }
+    if (descending) {
+        std::fill(arr, arr + nan_count, nan);
+    }
+    else {
+        std::fill(arr + size - nan_count, arr + size, nan);
     }
 }
 
@@ -137,10 +147,84 @@ X86_SIMD_SORT_INLINE arrsize_t move_nans_to_end_of_array(T *arr, arrsize_t size)
     return size - count - 1;
 }
 
+/*
+ * Sort all the NAN's to the start of the array and return the index of the
+ * first elem in the array which is not a nan
+ */
+template <typename T>
+X86_SIMD_SORT_INLINE arrsize_t move_nans_to_start_of_array(T *arr,
+                                                           arrsize_t size)
+{
+    arrsize_t count = 0;
+    for (arrsize_t ii = 0; ii < size; ++ii) {
+        if (is_a_nan(arr[ii])) { std::swap(arr[ii], arr[count++]); }
+    }
+    return count;
+}
+
+/*
+ * Descending order: vtype with ge, min and max swapped. The partitioning, the
+ * bitonic networks and the merges only compare elements through these and
+ * pad with zmm_max and type_max, so with vtype replaced by
+ * xss_descending<vtype> they sort in descending order at the same cost.
+ */
+template <typename vtype>
+struct xss_descending : vtype {
+    using ascending_vtype = vtype;
+    using type_t = typename vtype::type_t;
+    using reg_t = typename vtype::reg_t;
+    using opmask_t = typename vtype::opmask_t;
+
+    static type_t type_max()
+    {
+        return vtype::type_min();
+    }
+    static type_t type_min()
+    {
+        return vtype::type_max();
+    }
+    static reg_t zmm_max()
+    {
+        return vtype::set1(vtype::type_min());
+    }
+    static opmask_t ge(reg_t x, reg_t y)
+    {
+        return vtype::ge(y, x);
+    }
+    /* Also the halfreg_t overloads */
+    template <typename mm_t>
+    static mm_t min(mm_t x, mm_t y)
+    {
+        return vtype::max(x, y);
+    }
+    template <typename mm_t>
+    static mm_t max(mm_t x, mm_t y)
+    {
+        return vtype::min(x, y);
+    }
+    static type_t reducemax(reg_t v)
+    {
+        return vtype::reducemin(v);
+    }
+    static type_t reducemin(reg_t v)
+    {
+        return vtype::reducemax(v);
+    }
+    static reg_t sort_vec(reg_t x)
+    {
+        return vtype::reverse(vtype::sort_vec(x));
+    }
+};
+
 template <typename vtype, typename T>
 X86_SIMD_SORT_INLINE bool comparison_func(const T &a, const T &b)
 {
-    return a < b;
+    if constexpr (is_descending_v<vtype>) {
+        return comparison_func<typename vtype::ascending_vtype>(b, a);
+    }
+    else {
+        return a < b;
+    }
 }
 
 /*
@@ -480,15 +564,18 @@ X86_SIMD_SORT_INLINE arrsize_t partition_avx512_unrolled(type_t *arr,
 template <typename vtype, int maxN>
 void sort_n(typename vtype::type_t *arr, int N);
 
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE void merge_sort_(type_t *arr, arrsize_t arrsize);
+
 template <typename vtype, typename type_t>
 static void
 qsort_(type_t *arr, arrsize_t left, arrsize_t right, arrsize_t max_iters)
 {
     /*
-     * Resort to std::sort if quicksort isnt making any progress
+     * Resort to the SIMD merge sort if quicksort isnt making any progress
      */
     if (max_iters <= 0) {
-        std::sort(arr + left, arr + right + 1, comparison_func<vtype>);
+        merge_sort_<vtype>(arr + left, right + 1 - left);
         return;
     }
     /*
@@ -527,10 +614,10 @@ X86_SIMD_SORT_INLINE void qselect_(type_t *arr,
                                    arrsize_t max_iters)
 {
     /*
-     * Resort to std::sort if quicksort isnt making any progress
+     * Resort to the SIMD merge sort if quicksort isnt making any progress
      */
     if (max_iters <= 0) {
-        std::sort(arr + left, arr + right + 1, comparison_func<vtype>);
+        merge_sort_<vtype>(arr + left, right + 1 - left);
         return;
     }
     /*
@@ -557,73 +644,112 @@ X86_SIMD_SORT_INLINE void qselect_(type_t *arr,
 }
 
 // Quicksort routines:
-template <typename vtype, typename T>
+template <typename vtype, typename T, bool descending = false>
 X86_SIMD_SORT_INLINE void xss_qsort(T *arr, arrsize_t arrsize, bool hasnan)
 {
+    using sort_vtype = typename std::
+            conditional<descending, xss_descending<vtype>, vtype>::type;
     if (arrsize > 1) {
         if constexpr (std::is_floating_point_v<T>) {
             arrsize_t nan_count = 0;
             if (UNLIKELY(hasnan)) {
                 nan_count = replace_nan_with_inf<vtype>(arr, arrsize);
             }
-            qsort_<vtype, T>(arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
-            replace_inf_with_nan(arr, arrsize, nan_count);
+            qsort_<sort_vtype, T>(
+                    arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+            replace_inf_with_nan(arr, arrsize, nan_count, descending);
         }
         else {
             UNUSED(hasnan);
-            qsort_<vtype, T>(arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+            qsort_<sort_vtype, T>(
+                    arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
         }
     }
 }
 
 // Quick select methods
-template <typename vtype, typename T>
+template <typename vtype, typename T, bool descending = false>
 X86_SIMD_SORT_INLINE void
 xss_qselect(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
 {
+    using sort_vtype = typename std::
+            conditional<descending, xss_descending<vtype>, vtype>::type;
+    arrsize_t indx_first_elem = 0;
     arrsize_t indx_last_elem = arrsize - 1;
     if constexpr (std::is_floating_point_v<T>) {
         if (UNLIKELY(hasnan)) {
-            indx_last_elem = move_nans_to_end_of_array(arr, arrsize);
+            if constexpr (descending) {
+                indx_first_elem = move_nans_to_start_of_array(arr, arrsize);
+            }
+            else {
+                indx_last_elem = move_nans_to_end_of_array(arr, arrsize);
+            }
         }
     }
     UNUSED(hasnan);
-    if (indx_last_elem >= k) {
-        qselect_<vtype, T>(
-                arr, k, 0, indx_last_elem, 2 * (arrsize_t)log2(indx_last_elem));
+    if (indx_last_elem >= k && k >= indx_first_elem) {
+        qselect_<sort_vtype, T>(
+                arr,
+                k,
+                indx_first_elem,
+                indx_last_elem,
+                2 * (arrsize_t)log2(indx_last_elem - indx_first_elem));
     }
 }
 
 // Partial sort methods:
-template <typename vtype, typename T>
+template <typename vtype, typename T, bool descending = false>
 X86_SIMD_SORT_INLINE void
 xss_partial_qsort(T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan)
 {
-    xss_qselect<vtype, T>(arr, k - 1, arrsize, hasnan);
-    xss_qsort<vtype, T>(arr, k - 1, hasnan);
+    xss_qselect<vtype, T, descending>(arr, k - 1, arrsize, hasnan);
+    xss_qsort<vtype, T, descending>(arr, k - 1, hasnan);
 }
 
 #define DEFINE_METHODS(ISA, VTYPE) \
     template <typename T> \
-    X86_SIMD_SORT_INLINE void ISA##_qsort( \
-            T *arr, arrsize_t size, bool hasnan = false) \
+    X86_SIMD_SORT_INLINE void ISA##_qsort(T *arr, \
+                                          arrsize_t size, \
+                                          bool hasnan = false, \
+                                          bool descending = false) \
     { \
-        xss_qsort<VTYPE, T>(arr, size, hasnan); \
+        if (descending) { xss_qsort<VTYPE, T, true>(arr, size, hasnan); } \
+        else { \
+            xss_qsort<VTYPE, T>(arr, size, hasnan); \
+        } \
     } \
     template <typename T> \
-    X86_SIMD_SORT_INLINE void ISA##_qselect( \
-            T *arr, arrsize_t k, arrsize_t size, bool hasnan = false) \
+    X86_SIMD_SORT_INLINE void ISA##_qselect(T *arr, \
+                                            arrsize_t k, \
+                                            arrsize_t size, \
+                                            bool hasnan = false, \
+                                            bool descending = false) \
     { \
-        xss_qselect<VTYPE, T>(arr, k, size, hasnan); \
+        if (descending) { \
+            xss_qselect<VTYPE, T, true>(arr, k, size, hasnan); \
+        } \
+        else { \
+            xss_qselect<VTYPE, T>(arr, k, size, hasnan); \
+        } \
     } \
     template <typename T> \
-    X86_SIMD_SORT_INLINE void ISA##_partial_qsort( \
-            T *arr, arrsize_t k, arrsize_t size, bool hasnan = false) \
+    X86_SIMD_SORT_INLINE void ISA##_partial_qsort(T *arr, \
+                                                  arrsize_t k, \
+                                                  arrsize_t size, \
+                                                  bool hasnan = false, \
+                                                  bool descending = false) \
     { \
-        xss_partial_qsort<VTYPE, T>(arr, k, size, hasnan); \
+        if (descending) { \
+            xss_partial_qsort<VTYPE, T, true>(arr, k, size, hasnan); \
+        } \
+        else { \
+            xss_partial_qsort<VTYPE, T>(arr, k, size, hasnan); \
+        } \
     }
 
 DEFINE_METHODS(avx512, zmm_vector<T>)
 DEFINE_METHODS(avx2, avx2_vector<T>)
 
+#include "xss-simd-merge.hpp"
+
 #endif // XSS_COMMON_QSORT
@@ -0,0 +1,74 @@
+#ifndef XSS_COUNTING_SORT
+#define XSS_COUNTING_SORT
+
+/*
+ * Counting sort for 8-bit integers: a histogram of the 256 possible values is
+ * built in one read of the array, and the array is then rewritten as runs of
+ * equal values, each run being a memset, from the largest value down for a
+ * descending sort. Both steps are linear in the array size and the second one
+ * is bound by the store bandwidth.
+ *
+ * The histogram uses 4 interleaved sets of counters, read from 8 bytes at a
+ * time, so that consecutive increments of the same value do not wait on each
+ * other. Since the output is fully sorted either way, quickselect and partial
+ * sort are the counting sort too.
+ */
+
+#include "xss-common-includes.h"
+#include <functional>
+#include <type_traits>
+
+/*
+ * Below this many elements, the 256 counters cost more than std::sort
+ */
+constexpr arrsize_t xss_counting_sort_threshold = 64;
+
+template <typename T>
+X86_SIMD_SORT_INLINE void counting_sort_histogram(const T *arr,
+                                                  arrsize_t arrsize,
+                                                  arrsize_t *count)
+{
+    arrsize_t counts[4][256] = {};
+    arrsize_t i = 0;
+    for (; i + 8 <= arrsize; i += 8) {
+        uint64_t bytes;
+        std::memcpy(&bytes, arr + i, sizeof(bytes));
+        X86_SIMD_SORT_UNROLL_LOOP(8)
+        for (int j = 0; j < 8; ++j) {
+            counts[j % 4][(bytes >> (8 * j)) & 0xFF]++;
+        }
+    }
+    for (; i < arrsize; ++i) {
+        counts[0][(uint8_t)arr[i]]++;
+    }
+    for (int v = 0; v < 256; ++v) {
+        count[v] = counts[0][v] + counts[1][v] + counts[2][v] + counts[3][v];
+    }
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+xss_counting_sort(T *arr, arrsize_t arrsize, bool descending = false)
+{
+    static_assert(sizeof(T) == 1, "counting sort supports 8-bit types only");
+    if (arrsize < xss_counting_sort_threshold) {
+        if (descending) { std::sort(arr, arr + arrsize, std::greater<T>()); }
+        else {
+            std::sort(arr, arr + arrsize);
+        }
+        return;
+    }
+    /* count is indexed by the bit pattern of the values */
+    arrsize_t count[256];
+    counting_sort_histogram(arr, arrsize, count);
+    /* Signed types start with the negative values, i.e. 0x80 */
+    constexpr int first = std::is_signed_v<T> ? 0x80 : 0;
+    arrsize_t pos = 0;
+    for (int i = 0; i < 256; ++i) {
+        uint8_t val = (uint8_t)(first + (descending ? 255 - i : i));
+        std::memset(arr + pos, val, count[val]);
+        pos += count[val];
+    }
+}
+
+#endif // XSS_COUNTING_SORT
@@ -0,0 +1,298 @@
+#ifndef XSS_MERGE
+#define XSS_MERGE
+
+/*
+ * Merge of two sorted arrays, and of two sorted key-value arrays, with the
+ * SIMD merges of xss-simd-merge.hpp: the output is written one register at a
+ * time, each the lower half of a bitonic merge of the register in flight with
+ * the next register of the input whose head is the smallest.
+ *
+ * Sorted floating point arrays may end with NaNs (qsort with hasnan places
+ * them there). The merges of xss-simd-merge.hpp do not handle NaNs, so those
+ * of both inputs are split off and copied to the end of the output.
+ *
+ * The k-way merge is a balanced binary tree of these two-way merges with the
+ * runs as its leaves. Every inner node below the root owns a buffer of
+ * xss_kway_block_bytes, which it refills from its two children whenever it is
+ * half empty, so the elements in flight between the levels stay in L2 however
+ * long the runs are. The root writes straight to the output.
+ */
+
+#include "xss-common-qsort.h"
+
+/*
+ * Number of NaNs at the end of the sorted array arr[0, arrsize)
+ */
+template <typename T>
+X86_SIMD_SORT_INLINE arrsize_t merge_nan_count(const T *arr, arrsize_t arrsize)
+{
+    arrsize_t count = 0;
+    if constexpr (std::is_floating_point_v<T>) {
+        while (count < arrsize && std::isnan(arr[arrsize - 1 - count])) {
+            ++count;
+        }
+    }
+    else {
+        UNUSED(arr);
+        UNUSED(arrsize);
+    }
+    return count;
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void
+xss_merge(const T *a, arrsize_t na, const T *b, arrsize_t nb, T *out)
+{
+    arrsize_t nan_a = merge_nan_count(a, na);
+    arrsize_t nan_b = merge_nan_count(b, nb);
+    na -= nan_a;
+    nb -= nan_b;
+    merge_sorted_<vtype>(a, na, b, nb, out);
+    out = std::copy(a + na, a + na + nan_a, out + na + nb);
+    std::copy(b + nb, b + nb + nan_b, out);
+}
+
+template <typename vtype1, typename vtype2, typename T1, typename T2>
+X86_SIMD_SORT_INLINE void xss_merge_kv(const T1 *akey,
+                                       const T2 *aval,
+                                       arrsize_t na,
+                                       const T1 *bkey,
+                                       const T2 *bval,
+                                       arrsize_t nb,
+                                       T1 *outkey,
+                                       T2 *outval)
+{
+    arrsize_t nan_a = merge_nan_count(akey, na);
+    arrsize_t nan_b = merge_nan_count(bkey, nb);
+    na -= nan_a;
+    nb -= nan_b;
+    kv_merge_sorted_<vtype1, vtype2>(
+            akey, aval, na, bkey, bval, nb, outkey, outval);
+    arrsize_t pos = na + nb;
+    std::copy(akey + na, akey + na + nan_a, outkey + pos);
+    std::copy(aval + na, aval + na + nan_a, outval + pos);
+    pos += nan_a;
+    std::copy(bkey + nb, bkey + nb + nan_b, outkey + pos);
+    std::copy(bval + nb, bval + nb + nan_b, outval + pos);
+}
+
+/*
+ * Size of the buffer of every inner node of the k-way merge tree
+ */
+constexpr arrsize_t xss_kway_block_bytes = 16384;
+
+/*
+ * Node of the k-way merge tree. The unconsumed elements of a leaf are the
+ * rest of its run, those of an inner node the rest of its buffer.
+ */
+template <typename T>
+struct xss_kway_node {
+    const T *ptr;
+    arrsize_t len;
+    /* Elements still to be merged into the buffer, 0 for a leaf */
+    arrsize_t pending;
+    arrsize_t cap;
+    std::unique_ptr<T[]> buf;
+    xss_kway_node *left;
+    xss_kway_node *right;
+};
+
+template <typename T>
+X86_SIMD_SORT_INLINE xss_kway_node<T> *
+kway_build(std::vector<xss_kway_node<T>> &nodes,
+           const T *const *runs,
+           const arrsize_t *sizes,
+           arrsize_t lo,
+           arrsize_t hi)
+{
+    if (hi - lo == 1) {
+        nodes.push_back({runs[lo], sizes[lo], 0, 0, nullptr, nullptr, nullptr});
+        return &nodes.back();
+    }
+    arrsize_t mid = lo + (hi - lo) / 2;
+    xss_kway_node<T> *left = kway_build(nodes, runs, sizes, lo, mid);
+    xss_kway_node<T> *right = kway_build(nodes, runs, sizes, mid, hi);
+    arrsize_t total = left->len + left->pending + right->len + right->pending;
+    arrsize_t cap = std::min(total, xss_kway_block_bytes / sizeof(T));
+    std::unique_ptr<T[]> buf(new T[cap]);
+    const T *ptr = buf.get();
+    nodes.push_back({ptr, 0, total, cap, std::move(buf), left, right});
+    return &nodes.back();
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE arrsize_t kway_merge_into(xss_kway_node<T> *a,
+                                               xss_kway_node<T> *b,
+                                               T *dst,
+                                               arrsize_t space);
+
+/*
+ * Tops up the buffer of node once it is half empty
+ */
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void kway_refill(xss_kway_node<T> *node)
+{
+    if (node->pending == 0 || 2 * node->len > node->cap) { return; }
+    T *buf = node->buf.get();
+    if (node->ptr != buf) {
+        std::copy(node->ptr, node->ptr + node->len, buf);
+        node->ptr = buf;
+    }
+    arrsize_t n = kway_merge_into<vtype>(
+            node->left, node->right, buf + node->len, node->cap - node->len);
+    node->len += n;
+    node->pending -= n;
+}
+
+/*
+ * Merges the output of the nodes a and b into dst, until space elements are
+ * written or both are finished, and returns the number of elements written.
+ * Every element still to come from an unfinished node is at least the last
+ * one of its buffer, so a step only emits the elements up to the smaller of
+ * those.
+ */
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE arrsize_t kway_merge_into(xss_kway_node<T> *a,
+                                               xss_kway_node<T> *b,
+                                               T *dst,
+                                               arrsize_t space)
+{
+    arrsize_t written = 0;
+    while (written < space) {
+        kway_refill<vtype>(a);
+        kway_refill<vtype>(b);
+        arrsize_t na = a->len, nb = b->len;
+        if (a->pending != 0
+            && (b->pending == 0 || !(b->ptr[nb - 1] < a->ptr[na - 1]))) {
+            nb = std::upper_bound(b->ptr, b->ptr + nb, a->ptr[na - 1])
+                    - b->ptr;
+        }
+        else if (b->pending != 0) {
+            na = std::upper_bound(a->ptr, a->ptr + na, b->ptr[nb - 1])
+                    - a->ptr;
+        }
+        if (na + nb == 0) { break; }
+        arrsize_t n = std::min(na + nb, space - written);
+        if (n < na + nb) {
+            na = merge_path_split<vtype>(a->ptr, na, b->ptr, nb, n);
+            nb = n - na;
+        }
+        merge_sorted_<vtype>(a->ptr, na, b->ptr, nb, dst + written);
+        a->ptr += na;
+        a->len -= na;
+        b->ptr += nb;
+        b->len -= nb;
+        written += n;
+    }
+    return written;
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void xss_kway_merge(const T *const *runs,
+                                         const arrsize_t *sizes,
+                                         arrsize_t k,
+                                         T *out)
+{
+    if (k == 0) { return; }
+    if (k == 1) {
+        std::copy(runs[0], runs[0] + sizes[0], out);
+        return;
+    }
+    std::vector<arrsize_t> nan_count(k), len(k);
+    arrsize_t total = 0;
+    for (arrsize_t i = 0; i < k; ++i) {
+        nan_count[i] = merge_nan_count(runs[i], sizes[i]);
+        len[i] = sizes[i] - nan_count[i];
+        total += len[i];
+    }
+    /* The root has no buffer: its two children are merged into out */
+    std::vector<xss_kway_node<T>> nodes;
+    nodes.reserve(2 * k);
+    arrsize_t mid = k / 2;
+    xss_kway_node<T> *left = kway_build(nodes, runs, len.data(), 0, mid);
+    xss_kway_node<T> *right = kway_build(nodes, runs, len.data(), mid, k);
+    kway_merge_into<vtype>(left, right, out, total);
+    out += total;
+    for (arrsize_t i = 0; i < k; ++i) {
+        out = std::copy(runs[i] + len[i], runs[i] + sizes[i], out);
+    }
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+avx512_merge(const T *a, arrsize_t na, const T *b, arrsize_t nb, T *out)
+{
+    xss_merge<zmm_vector<T>>(a, na, b, nb, out);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+avx2_merge(const T *a, arrsize_t na, const T *b, arrsize_t nb, T *out)
+{
+    xss_merge<avx2_vector<T>>(a, na, b, nb, out);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx512_kway_merge(const T *const *runs,
+                                            const arrsize_t *sizes,
+                                            arrsize_t k,
+                                            T *out)
+{
+    xss_kway_merge<zmm_vector<T>>(runs, sizes, k, out);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx2_kway_merge(const T *const *runs,
+                                          const arrsize_t *sizes,
+                                          arrsize_t k,
+                                          T *out)
+{
+    xss_kway_merge<avx2_vector<T>>(runs, sizes, k, out);
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx512_merge_kv(const T1 *akey,
+                                          const T2 *aval,
+                                          arrsize_t na,
+                                          const T1 *bkey,
+                                          const T2 *bval,
+                                          arrsize_t nb,
+                                          T1 *outkey,
+                                          T2 *outval)
+{
+    using keytype =
+            typename std::conditional<sizeof(T1) != sizeof(T2)
+                                              && sizeof(T1) == sizeof(int32_t),
+                                      ymm_vector<T1>,
+                                      zmm_vector<T1>>::type;
+    using valtype =
+            typename std::conditional<sizeof(T1) != sizeof(T2)
+                                              && sizeof(T2) == sizeof(int32_t),
+                                      ymm_vector<T2>,
+                                      zmm_vector<T2>>::type;
+    xss_merge_kv<keytype, valtype>(
+            akey, aval, na, bkey, bval, nb, outkey, outval);
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx2_merge_kv(const T1 *akey,
+                                        const T2 *aval,
+                                        arrsize_t na,
+                                        const T1 *bkey,
+                                        const T2 *bval,
+                                        arrsize_t nb,
+                                        T1 *outkey,
+                                        T2 *outval)
+{
+    /* The key-value networks only handle 4 lanes on AVX2 */
+    using keytype = typename std::conditional<sizeof(T1) == sizeof(int32_t),
+                                              avx2_half_vector<T1>,
+                                              avx2_vector<T1>>::type;
+    using valtype = typename std::conditional<sizeof(T2) == sizeof(int32_t),
+                                              avx2_half_vector<T2>,
+                                              avx2_vector<T2>>::type;
+    xss_merge_kv<keytype, valtype>(
+            akey, aval, na, bkey, bval, nb, outkey, outval);
+}
+
+#endif // XSS_MERGE
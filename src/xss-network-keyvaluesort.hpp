@@ -440,9 +440,28 @@ bitonic_fullmerge_n_vec(typename keyType::reg_t *keys,
     }
 }
 
+/*
+ * Gathers keys[indices[0, num)] and fills the remaining lanes with the max.
+ * Hardware gathers sign extend 32-bit indices, so uint32_t indices beyond
+ * INT32_MAX are loaded one at a time instead.
+ */
+template <typename keyType, typename index_t>
+X86_SIMD_SORT_INLINE typename keyType::reg_t
+partial_i64gather(typename keyType::type_t *keys, index_t *indices, int num)
+{
+    typename keyType::type_t vals[keyType::numlanes];
+    keyType::storeu(vals, keyType::zmm_max());
+    for (int i = 0; i < num; i++) {
+        vals[i] = keys[indices[i]];
+    }
+    return keyType::loadu(vals);
+}
+
 template <typename keyType, typename indexType, int numVecs>
 X86_SIMD_SORT_INLINE void
-argsort_n_vec(typename keyType::type_t *keys, arrsize_t *indices, int N)
+argsort_n_vec(typename keyType::type_t *keys,
+              typename indexType::type_t *indices,
+              int N)
 {
     using kreg_t = typename keyType::reg_t;
     using ireg_t = typename indexType::reg_t;
@@ -483,11 +502,21 @@ argsort_n_vec(typename keyType::type_t *keys, arrsize_t *indices, int N)
                 resize_mask<keyType, indexType>(ioMasks[i - numVecs / 2]),
                 indices + i * indexType::numlanes);
 
-        keyVecs[i] = keyType::template mask_i64gather<sizeof(
-                typename keyType::type_t)>(keyType::zmm_max(),
-                                           ioMasks[i - numVecs / 2],
-                                           indexVecs[i],
-                                           keys);
+        if constexpr (sizeof(typename indexType::type_t)
+                      < sizeof(arrsize_t)) {
+            keyVecs[i] = partial_i64gather<keyType>(
+                    keys,
+                    indices + i * indexType::numlanes,
+                    std::min(std::max(0, N - i * keyType::numlanes),
+                             (int)keyType::numlanes));
+        }
+        else {
+            keyVecs[i] = keyType::template mask_i64gather<sizeof(
+                    typename keyType::type_t)>(keyType::zmm_max(),
+                                               ioMasks[i - numVecs / 2],
+                                               indexVecs[i],
+                                               keys);
+        }
     }
 
     // Sort each loaded vector
@@ -554,9 +583,10 @@ X86_SIMD_SORT_INLINE void kvsort_n_vec(typename keyType::type_t *keys,
     for (int i = numVecs / 2, j = 0; i < numVecs; i++, j++) {
         keyVecs[i] = keyType::mask_loadu(
                 keyType::zmm_max(), ioMasks[j], keys + i * keyType::numlanes);
-        valueVecs[i] = valueType::mask_loadu(valueType::zmm_max(),
-                                             ioMasks[j],
-                                             values + i * valueType::numlanes);
+        valueVecs[i] = valueType::mask_loadu(
+                valueType::zmm_max(),
+                resize_mask<keyType, valueType>(ioMasks[j]),
+                values + i * valueType::numlanes);
     }
 
     // Sort each loaded vector
@@ -579,14 +609,17 @@ X86_SIMD_SORT_INLINE void kvsort_n_vec(typename keyType::type_t *keys,
     for (int i = numVecs / 2, j = 0; i < numVecs; i++, j++) {
         keyType::mask_storeu(
                 keys + i * keyType::numlanes, ioMasks[j], keyVecs[i]);
-        valueType::mask_storeu(
-                values + i * valueType::numlanes, ioMasks[j], valueVecs[i]);
+        valueType::mask_storeu(values + i * valueType::numlanes,
+                               resize_mask<keyType, valueType>(ioMasks[j]),
+                               valueVecs[i]);
     }
 }
 
 template <typename keyType, typename indexType, int maxN>
 X86_SIMD_SORT_INLINE void
-argsort_n(typename keyType::type_t *keys, arrsize_t *indices, int N)
+argsort_n(typename keyType::type_t *keys,
+          typename indexType::type_t *indices,
+          int N)
 {
     static_assert(keyType::numlanes == indexType::numlanes,
                   "invalid pairing of value/index types");
@@ -0,0 +1,149 @@
+#ifndef XSS_PACKED_16BIT
+#define XSS_PACKED_16BIT
+
+/*
+ * Key-value sort and argsort of 16-bit keys. There are no 16-bit key-value
+ * networks: instead every key, mapped to an unsigned integer of the same
+ * order, is packed in the upper 16 bits of a 32-bit or 64-bit word with its
+ * value or its index in the lower bits, and the words are sorted by the
+ * 32-bit or 64-bit quicksort. Indices take 48 bits, i.e. arrays of less than
+ * 2^48 elements.
+ */
+
+#include "xss-common-qsort.h"
+#include <numeric>
+
+/*
+ * Maps a uint16_t, int16_t or _Float16 key to a uint16_t of the same order,
+ * reversed for descending. Every _Float16 NaN is ordered after +inf as 0xFFFF,
+ * which is a NaN again once mapped back.
+ */
+template <typename T>
+X86_SIMD_SORT_INLINE uint16_t xss_to_ordered_16bit(T key, bool descending)
+{
+    uint16_t bits;
+    std::memcpy(&bits, &key, sizeof(bits));
+    if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        bits ^= 0x8000;
+    }
+    else if constexpr (!std::is_integral_v<T>) {
+        if ((bits & 0x7FFF) > X86_SIMD_SORT_INFINITYH) { bits = 0xFFFF; }
+        else if (bits & 0x8000) {
+            bits = (uint16_t)~bits;
+        }
+        else {
+            bits ^= 0x8000;
+        }
+    }
+    return descending ? (uint16_t)~bits : bits;
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE T xss_from_ordered_16bit(uint16_t bits, bool descending)
+{
+    if (descending) { bits = (uint16_t)~bits; }
+    if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        bits ^= 0x8000;
+    }
+    else if constexpr (!std::is_integral_v<T>) {
+        if (bits & 0x8000) { bits ^= 0x8000; }
+        else {
+            bits = (uint16_t)~bits;
+        }
+    }
+    T key;
+    std::memcpy(&key, &bits, sizeof(key));
+    return key;
+}
+
+/*
+ * Orders the indices in arg by the keys they point to: sort is called on the
+ * packed words, and sorts them or only selects one of them. 64-bit indices
+ * are packed in place in arg; uint32_t indices are too narrow and need a
+ * temporary array of words.
+ */
+template <typename T, typename index_t, typename SortFunc>
+X86_SIMD_SORT_INLINE void xss_argsort_packed_16bit(T *arr,
+                                                   index_t *arg,
+                                                   arrsize_t arrsize,
+                                                   bool descending,
+                                                   SortFunc sort)
+{
+    constexpr uint64_t indexmask = ((uint64_t)1 << 48) - 1;
+    std::vector<uint64_t> buffer;
+    uint64_t *words;
+    if constexpr (std::is_same_v<index_t, uint64_t>) { words = arg; }
+    else {
+        buffer.resize(arrsize);
+        words = buffer.data();
+    }
+    for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+        uint64_t key = xss_to_ordered_16bit(arr[arg[ii]], descending);
+        words[ii] = (key << 48) | (uint64_t)arg[ii];
+    }
+    sort(words, arrsize);
+    for (arrsize_t ii = 0; ii < arrsize; ++ii) {
+        arg[ii] = (index_t)(words[ii] & indexmask);
+    }
+}
+
+/*
+ * argsort and argselect methods for 16-bit dtypes. Equal keys keep their
+ * indices in increasing order, and NaNs are ordered after +inf like in
+ * qsort.
+ */
+#define DEFINE_16BIT_PACKED_ARG_METHODS(ISA, VTYPE64) \
+    template <typename T, typename index_t> \
+    X86_SIMD_SORT_INLINE void ISA##_argsort_16bit(T *arr, \
+                                                  index_t *arg, \
+                                                  arrsize_t arrsize, \
+                                                  bool hasnan = false, \
+                                                  bool descending = false) \
+    { \
+        UNUSED(hasnan); \
+        if (arrsize <= 1) { return; } \
+        xss_argsort_packed_16bit( \
+                arr, arg, arrsize, descending, [](uint64_t *w, arrsize_t n) { \
+                    xss_qsort<VTYPE64, uint64_t>(w, n, false); \
+                }); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argsort_16bit( \
+            T *arr, \
+            arrsize_t arrsize, \
+            bool hasnan = false, \
+            bool descending = false) \
+    { \
+        std::vector<arrsize_t> indices(arrsize); \
+        std::iota(indices.begin(), indices.end(), 0); \
+        ISA##_argsort_16bit(arr, indices.data(), arrsize, hasnan, descending); \
+        return indices; \
+    } \
+    template <typename T, typename index_t> \
+    X86_SIMD_SORT_INLINE void ISA##_argselect_16bit(T *arr, \
+                                                    index_t *arg, \
+                                                    arrsize_t k, \
+                                                    arrsize_t arrsize, \
+                                                    bool hasnan = false) \
+    { \
+        UNUSED(hasnan); \
+        if ((arrsize <= 1) || (k >= arrsize)) { return; } \
+        xss_argsort_packed_16bit( \
+                arr, arg, arrsize, false, [k](uint64_t *w, arrsize_t n) { \
+                    xss_qselect<VTYPE64, uint64_t>(w, k, n, false); \
+                }); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argselect_16bit( \
+            T *arr, arrsize_t k, arrsize_t arrsize, bool hasnan = false) \
+    { \
+        std::vector<arrsize_t> indices(arrsize); \
+        std::iota(indices.begin(), indices.end(), 0); \
+        ISA##_argselect_16bit(arr, indices.data(), k, arrsize, hasnan); \
+        return indices; \
+    }
+
+DEFINE_16BIT_PACKED_ARG_METHODS(avx512, zmm_vector<uint64_t>)
+DEFINE_16BIT_PACKED_ARG_METHODS(avx2, avx2_vector<uint64_t>)
+
+#endif // XSS_PACKED_16BIT
@@ -0,0 +1,479 @@
+#ifndef XSS_PARALLEL_ARGSORT
+#define XSS_PARALLEL_ARGSORT
+
+/*
+ * Multi-threaded argsort and argselect for 32-bit and 64-bit dtypes. These
+ * follow the same scheme as the multi-threaded quicksort (see
+ * xss-parallel-qsort.hpp), using the index based partition kernels of
+ * xss-common-argsort.h. NaNs are handled like std_argsort_withnan: the
+ * indices of the NaNs are moved to the end of arg and the rest of the array
+ * is sorted with the vectorized kernels.
+ */
+
+#include "xss-common-argsort.h"
+#include "xss-packed-16bit.hpp"
+#include "xss-parallel-qsort.hpp"
+
+template <typename vtype, typename argtype, typename type_t>
+static void argsort_parallel_(type_t *arr,
+                              arrsize_t *arg,
+                              arrsize_t left,
+                              arrsize_t right,
+                              arrsize_t max_iters,
+                              xss_thread_pool &pool)
+{
+    if ((right + 1 - left <= xss_parallel_task_cutoff) || (max_iters <= 0)) {
+        argsort_64bit_<vtype, argtype>(arr, arg, left, right, max_iters);
+        return;
+    }
+    type_t pivot = get_pivot_64bit<vtype>(arr, arg, left, right);
+    type_t smallest = vtype::type_max();
+    type_t biggest = vtype::type_min();
+    arrsize_t pivot_index = argpartition_avx512_unrolled<vtype, argtype, 4>(
+            arr, arg, left, right + 1, pivot, &smallest, &biggest);
+    if (pivot != smallest) {
+        pool.submit([arr, arg, left, pivot_index, max_iters, &pool]() {
+            argsort_parallel_<vtype, argtype>(
+                    arr, arg, left, pivot_index - 1, max_iters - 1, pool);
+        });
+    }
+    if (pivot != biggest) {
+        argsort_parallel_<vtype, argtype>(
+                arr, arg, pivot_index, right, max_iters - 1, pool);
+    }
+}
+
+template <typename vtype, typename argtype, typename type_t>
+X86_SIMD_SORT_INLINE arrsize_t
+parallel_partition_avx512(type_t *arr,
+                          arrsize_t *arg,
+                          arrsize_t left,
+                          arrsize_t right,
+                          arrsize_t nblocks,
+                          type_t pivot,
+                          type_t *smallest,
+                          type_t *biggest,
+                          xss_thread_pool &pool)
+{
+    return parallel_partition_<vtype>(
+            left,
+            right,
+            nblocks,
+            smallest,
+            biggest,
+            [arr, arg, pivot](arrsize_t begin,
+                              arrsize_t end,
+                              type_t *blk_smallest,
+                              type_t *blk_biggest) {
+                return argpartition_avx512_unrolled<vtype, argtype, 4>(
+                        arr, arg, begin, end, pivot, blk_smallest, blk_biggest);
+            },
+            [arg](arrsize_t a, arrsize_t b, arrsize_t len) {
+                std::swap_ranges(arg + a, arg + a + len, arg + b);
+            },
+            pool);
+}
+
+/*
+ * Moves the indices of the NaNs in arr to the end of arg[0, arrsize) and
+ * returns the number of non-NaN elements
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE arrsize_t parallel_move_nan_args_to_end(
+        type_t *arr, arrsize_t *arg, arrsize_t arrsize, xss_thread_pool &pool)
+{
+    /* Partitioning uses the same machinery as the vectorized partitions:
+     * "smaller than pivot" here means "not a NaN". */
+    type_t unused_min = vtype::type_max(), unused_max = vtype::type_min();
+    return parallel_partition_<vtype>(
+            0,
+            arrsize,
+            parallel_num_blocks(0, arrsize - 1, pool.num_threads()),
+            &unused_min,
+            &unused_max,
+            [arr, arg](arrsize_t begin, arrsize_t end, type_t *, type_t *) {
+                return (arrsize_t)(std::partition(arg + begin,
+                                                  arg + end,
+                                                  [arr](arrsize_t ii) {
+                                                      return !std::isnan(
+                                                              arr[ii]);
+                                                  })
+                                   - arg);
+            },
+            [arg](arrsize_t a, arrsize_t b, arrsize_t len) {
+                std::swap_ranges(arg + a, arg + a + len, arg + b);
+            },
+            pool);
+}
+
+template <typename vtype, typename argtype, typename type_t>
+X86_SIMD_SORT_INLINE void argsort_parallel_all_(type_t *arr,
+                                                arrsize_t *arg,
+                                                arrsize_t arrsize,
+                                                xss_thread_pool &pool)
+{
+    auto split = [arr, arg, &pool](const xss_subarray &sub,
+                                   arrsize_t nblocks,
+                                   std::vector<xss_subarray> &children) {
+        type_t pivot = get_pivot_64bit<vtype>(arr, arg, sub.left, sub.right);
+        type_t smallest = vtype::type_max();
+        type_t biggest = vtype::type_min();
+        arrsize_t pivot_index
+                = parallel_partition_avx512<vtype, argtype>(arr,
+                                                            arg,
+                                                            sub.left,
+                                                            sub.right + 1,
+                                                            nblocks,
+                                                            pivot,
+                                                            &smallest,
+                                                            &biggest,
+                                                            pool);
+        if (pivot != smallest) {
+            children.push_back({sub.left, pivot_index - 1, sub.max_iters - 1});
+        }
+        if (pivot != biggest) {
+            children.push_back({pivot_index, sub.right, sub.max_iters - 1});
+        }
+    };
+    auto sort = [arr, arg, &pool](const xss_subarray &sub) {
+        argsort_parallel_<vtype, argtype>(
+                arr, arg, sub.left, sub.right, sub.max_iters, pool);
+    };
+    parallel_sort_(arrsize, 2 * (arrsize_t)log2(arrsize), split, sort, pool);
+}
+
+template <typename vtype, typename argtype, typename type_t>
+X86_SIMD_SORT_INLINE void argselect_parallel_(type_t *arr,
+                                              arrsize_t *arg,
+                                              arrsize_t pos,
+                                              arrsize_t arrsize,
+                                              xss_thread_pool &pool)
+{
+    arrsize_t left = 0, right = arrsize - 1;
+    arrsize_t max_iters = 2 * (arrsize_t)log2(arrsize);
+    arrsize_t nblocks = parallel_num_blocks(left, right, pool.num_threads());
+    while ((nblocks > 1) && (max_iters > 0)) {
+        type_t pivot = get_pivot_64bit<vtype>(arr, arg, left, right);
+        type_t smallest = vtype::type_max();
+        type_t biggest = vtype::type_min();
+        arrsize_t pivot_index
+                = parallel_partition_avx512<vtype, argtype>(arr,
+                                                            arg,
+                                                            left,
+                                                            right + 1,
+                                                            nblocks,
+                                                            pivot,
+                                                            &smallest,
+                                                            &biggest,
+                                                            pool);
+        if ((pivot != smallest) && (pos < pivot_index)) {
+            right = pivot_index - 1;
+        }
+        else if ((pivot != biggest) && (pos >= pivot_index)) {
+            left = pivot_index;
+        }
+        else {
+            return;
+        }
+        max_iters -= 1;
+        nblocks = parallel_num_blocks(left, right, pool.num_threads());
+    }
+    argselect_64bit_<vtype, argtype>(arr, arg, pos, left, right, max_iters);
+}
+
+/* Fills arg with 0, 1, ..., arrsize - 1 one chunk per thread */
+X86_SIMD_SORT_INLINE void
+parallel_iota(arrsize_t *arg, arrsize_t arrsize, xss_thread_pool &pool)
+{
+    arrsize_t nchunks = pool.num_threads();
+    arrsize_t chunk = (arrsize + nchunks - 1) / nchunks;
+    for (arrsize_t start = 0; start < arrsize; start += chunk) {
+        arrsize_t len = std::min(chunk, arrsize - start);
+        pool.submit([arg, start, len]() {
+            std::iota(arg + start, arg + start + len, start);
+        });
+    }
+    pool.wait();
+}
+
+template <typename vtype, typename argtype, typename T>
+X86_SIMD_SORT_INLINE void xss_argsort_parallel(T *arr,
+                                               arrsize_t *arg,
+                                               arrsize_t arrsize,
+                                               bool hasnan,
+                                               xss_thread_pool &pool)
+{
+    if (arrsize <= 1) { return; }
+    if constexpr (std::is_floating_point_v<T>) {
+        if (hasnan) {
+            arrsize = parallel_move_nan_args_to_end<vtype>(
+                    arr, arg, arrsize, pool);
+        }
+    }
+    UNUSED(hasnan);
+    if (arrsize > 1) {
+        argsort_parallel_all_<vtype, argtype>(arr, arg, arrsize, pool);
+    }
+}
+
+template <typename vtype, typename argtype, typename T>
+X86_SIMD_SORT_INLINE void xss_argselect_parallel(T *arr,
+                                                 arrsize_t *arg,
+                                                 arrsize_t k,
+                                                 arrsize_t arrsize,
+                                                 bool hasnan,
+                                                 xss_thread_pool &pool)
+{
+    if (arrsize <= 1) { return; }
+    if constexpr (std::is_floating_point_v<T>) {
+        if (hasnan) {
+            arrsize = parallel_move_nan_args_to_end<vtype>(
+                    arr, arg, arrsize, pool);
+        }
+    }
+    UNUSED(hasnan);
+    if (k < arrsize) {
+        argselect_parallel_<vtype, argtype>(arr, arg, k, arrsize, pool);
+    }
+}
+
+/* argsort methods for 32-bit and 64-bit dtypes */
+template <typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t> avx512_argsort_parallel(
+        T *arr, arrsize_t arrsize, bool hasnan, xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1) || (arrsize <= xss_parallel_task_cutoff)) {
+        return avx512_argsort(arr, arrsize, hasnan);
+    }
+    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              ymm_vector<T>,
+                                              zmm_vector<T>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      ymm_vector<arrsize_t>,
+                                      zmm_vector<arrsize_t>>::type;
+    std::vector<arrsize_t> indices(arrsize);
+    parallel_iota(indices.data(), arrsize, pool);
+    xss_argsort_parallel<vectype, argtype>(
+            arr, indices.data(), arrsize, hasnan, pool);
+    return indices;
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t> avx2_argsort_parallel(
+        T *arr, arrsize_t arrsize, bool hasnan, xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1) || (arrsize <= xss_parallel_task_cutoff)) {
+        return avx2_argsort(arr, arrsize, hasnan);
+    }
+    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              avx2_half_vector<T>,
+                                              avx2_vector<T>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      avx2_half_vector<arrsize_t>,
+                                      avx2_vector<arrsize_t>>::type;
+    std::vector<arrsize_t> indices(arrsize);
+    parallel_iota(indices.data(), arrsize, pool);
+    xss_argsort_parallel<vectype, argtype>(
+            arr, indices.data(), arrsize, hasnan, pool);
+    return indices;
+}
+
+/* argselect methods for 32-bit and 64-bit dtypes */
+template <typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t>
+avx512_argselect_parallel(T *arr,
+                          arrsize_t k,
+                          arrsize_t arrsize,
+                          bool hasnan,
+                          xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1)
+        || (arrsize <= 2 * xss_parallel_block_cutoff)) {
+        return avx512_argselect(arr, k, arrsize, hasnan);
+    }
+    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              ymm_vector<T>,
+                                              zmm_vector<T>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      ymm_vector<arrsize_t>,
+                                      zmm_vector<arrsize_t>>::type;
+    std::vector<arrsize_t> indices(arrsize);
+    parallel_iota(indices.data(), arrsize, pool);
+    xss_argselect_parallel<vectype, argtype>(
+            arr, indices.data(), k, arrsize, hasnan, pool);
+    return indices;
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t>
+avx2_argselect_parallel(T *arr,
+                        arrsize_t k,
+                        arrsize_t arrsize,
+                        bool hasnan,
+                        xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1)
+        || (arrsize <= 2 * xss_parallel_block_cutoff)) {
+        return avx2_argselect(arr, k, arrsize, hasnan);
+    }
+    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              avx2_half_vector<T>,
+                                              avx2_vector<T>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      avx2_half_vector<arrsize_t>,
+                                      avx2_vector<arrsize_t>>::type;
+    std::vector<arrsize_t> indices(arrsize);
+    parallel_iota(indices.data(), arrsize, pool);
+    xss_argselect_parallel<vectype, argtype>(
+            arr, indices.data(), k, arrsize, hasnan, pool);
+    return indices;
+}
+
+/* Run on a pool of nthreads threads or on an executor of the caller */
+#define DEFINE_PARALLEL_ARG_METHODS(ISA) \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argsort_parallel( \
+            T *arr, \
+            arrsize_t arrsize, \
+            bool hasnan = false, \
+            unsigned nthreads = 0) \
+    { \
+        xss_thread_pool pool(xss_get_num_threads(nthreads)); \
+        return ISA##_argsort_parallel(arr, arrsize, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argsort_parallel( \
+            T *arr, \
+            arrsize_t arrsize, \
+            bool hasnan, \
+            const xss_executor &executor) \
+    { \
+        xss_thread_pool pool(executor); \
+        return ISA##_argsort_parallel(arr, arrsize, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argselect_parallel( \
+            T *arr, \
+            arrsize_t k, \
+            arrsize_t arrsize, \
+            bool hasnan = false, \
+            unsigned nthreads = 0) \
+    { \
+        xss_thread_pool pool(xss_get_num_threads(nthreads)); \
+        return ISA##_argselect_parallel(arr, k, arrsize, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argselect_parallel( \
+            T *arr, \
+            arrsize_t k, \
+            arrsize_t arrsize, \
+            bool hasnan, \
+            const xss_executor &executor) \
+    { \
+        xss_thread_pool pool(executor); \
+        return ISA##_argselect_parallel(arr, k, arrsize, hasnan, pool); \
+    }
+
+DEFINE_PARALLEL_ARG_METHODS(avx512)
+DEFINE_PARALLEL_ARG_METHODS(avx2)
+
+/*
+ * argsort and argselect methods for 16-bit dtypes: the packed words of
+ * xss-packed-16bit.hpp are sorted or selected in parallel
+ */
+template <typename vtype64, typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t>
+xss_argsort_16bit_parallel(T *arr, arrsize_t arrsize, xss_thread_pool &pool)
+{
+    std::vector<arrsize_t> indices(arrsize);
+    parallel_iota(indices.data(), arrsize, pool);
+    if (arrsize > 1) {
+        xss_argsort_packed_16bit(
+                arr,
+                indices.data(),
+                arrsize,
+                false,
+                [&pool](uint64_t *words, arrsize_t n) {
+                    xss_qsort_parallel<vtype64, uint64_t>(
+                            words, n, false, pool);
+                });
+    }
+    return indices;
+}
+
+template <typename vtype64, typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t> xss_argselect_16bit_parallel(
+        T *arr, arrsize_t k, arrsize_t arrsize, xss_thread_pool &pool)
+{
+    std::vector<arrsize_t> indices(arrsize);
+    parallel_iota(indices.data(), arrsize, pool);
+    if ((arrsize > 1) && (k < arrsize)) {
+        xss_argsort_packed_16bit(
+                arr,
+                indices.data(),
+                arrsize,
+                false,
+                [k, &pool](uint64_t *words, arrsize_t n) {
+                    xss_qselect_parallel<vtype64, uint64_t>(
+                            words, k, n, false, pool);
+                });
+    }
+    return indices;
+}
+
+#define DEFINE_PARALLEL_16BIT_ARG_METHODS(ISA, VTYPE64) \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argsort_16bit_parallel( \
+            T *arr, \
+            arrsize_t arrsize, \
+            bool hasnan = false, \
+            unsigned nthreads = 0) \
+    { \
+        UNUSED(hasnan); \
+        xss_thread_pool pool(xss_get_num_threads(nthreads)); \
+        return xss_argsort_16bit_parallel<VTYPE64>(arr, arrsize, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> ISA##_argsort_16bit_parallel( \
+            T *arr, \
+            arrsize_t arrsize, \
+            bool hasnan, \
+            const xss_executor &executor) \
+    { \
+        UNUSED(hasnan); \
+        xss_thread_pool pool(executor); \
+        return xss_argsort_16bit_parallel<VTYPE64>(arr, arrsize, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> \
+    ISA##_argselect_16bit_parallel(T *arr, \
+                                   arrsize_t k, \
+                                   arrsize_t arrsize, \
+                                   bool hasnan = false, \
+                                   unsigned nthreads = 0) \
+    { \
+        UNUSED(hasnan); \
+        xss_thread_pool pool(xss_get_num_threads(nthreads)); \
+        return xss_argselect_16bit_parallel<VTYPE64>(arr, k, arrsize, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE std::vector<arrsize_t> \
+    ISA##_argselect_16bit_parallel(T *arr, \
+                                   arrsize_t k, \
+                                   arrsize_t arrsize, \
+                                   bool hasnan, \
+                                   const xss_executor &executor) \
+    { \
+        UNUSED(hasnan); \
+        xss_thread_pool pool(executor); \
+        return xss_argselect_16bit_parallel<VTYPE64>(arr, k, arrsize, pool); \
+    }
+
+DEFINE_PARALLEL_16BIT_ARG_METHODS(avx512, zmm_vector<uint64_t>)
+DEFINE_PARALLEL_16BIT_ARG_METHODS(avx2, avx2_vector<uint64_t>)
+
+#endif // XSS_PARALLEL_ARGSORT
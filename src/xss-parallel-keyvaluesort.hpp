@@ -0,0 +1,245 @@
+#ifndef XSS_PARALLEL_KEYVALUESORT
+#define XSS_PARALLEL_KEYVALUESORT
+
+/*
+ * Multi-threaded key-value sort. Follows the same scheme as the
+ * multi-threaded quicksort (see xss-parallel-qsort.hpp): the keys drive the
+ * partitioning and every move of a key is mirrored on the value array, both
+ * in the block partitions and when swapping the misplaced elements. Small
+ * sub-arrays are sorted with the serial qsort_64bit_.
+ */
+
+#include "xss-common-keyvaluesort.hpp"
+#include "xss-parallel-qsort.hpp"
+
+/*
+ * Names every template argument of the key-value partition_avx512_unrolled,
+ * which also serves the AVX2 vtypes.
+ */
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE arrsize_t kv_partition_avx512_unrolled(type1_t *keys,
+                                                            type2_t *indexes,
+                                                            arrsize_t left,
+                                                            arrsize_t right,
+                                                            type1_t pivot,
+                                                            type1_t *smallest,
+                                                            type1_t *biggest)
+{
+    return partition_avx512_unrolled<vtype1, vtype2, 4, type1_t, type2_t>(
+            keys, indexes, left, right, pivot, smallest, biggest);
+}
+
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+static void qsort_kv_parallel_(type1_t *keys,
+                               type2_t *indexes,
+                               arrsize_t left,
+                               arrsize_t right,
+                               arrsize_t max_iters,
+                               xss_thread_pool &pool)
+{
+    if ((right + 1 - left <= xss_parallel_task_cutoff) || (max_iters <= 0)) {
+        qsort_64bit_<vtype1, vtype2>(keys, indexes, left, right, max_iters);
+        return;
+    }
+    type1_t pivot = get_pivot_blocks<vtype1>(keys, left, right);
+    type1_t smallest = vtype1::type_max();
+    type1_t biggest = vtype1::type_min();
+    arrsize_t pivot_index = kv_partition_avx512_unrolled<vtype1, vtype2>(
+            keys, indexes, left, right + 1, pivot, &smallest, &biggest);
+    if (pivot != smallest) {
+        pool.submit([keys, indexes, left, pivot_index, max_iters, &pool]() {
+            qsort_kv_parallel_<vtype1, vtype2>(
+                    keys, indexes, left, pivot_index - 1, max_iters - 1, pool);
+        });
+    }
+    if (pivot != biggest) {
+        qsort_kv_parallel_<vtype1, vtype2>(
+                keys, indexes, pivot_index, right, max_iters - 1, pool);
+    }
+}
+
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE arrsize_t
+parallel_partition_avx512_kv(type1_t *keys,
+                             type2_t *indexes,
+                             arrsize_t left,
+                             arrsize_t right,
+                             arrsize_t nblocks,
+                             type1_t pivot,
+                             type1_t *smallest,
+                             type1_t *biggest,
+                             xss_thread_pool &pool)
+{
+    return parallel_partition_<vtype1>(
+            left,
+            right,
+            nblocks,
+            smallest,
+            biggest,
+            [keys, indexes, pivot](arrsize_t begin,
+                                   arrsize_t end,
+                                   type1_t *blk_smallest,
+                                   type1_t *blk_biggest) {
+                return kv_partition_avx512_unrolled<vtype1, vtype2>(
+                        keys,
+                        indexes,
+                        begin,
+                        end,
+                        pivot,
+                        blk_smallest,
+                        blk_biggest);
+            },
+            [keys, indexes](arrsize_t a, arrsize_t b, arrsize_t len) {
+                std::swap_ranges(keys + a, keys + a + len, keys + b);
+                std::swap_ranges(indexes + a, indexes + a + len, indexes + b);
+            },
+            pool);
+}
+
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE void qsort_kv_parallel_all_(type1_t *keys,
+                                                 type2_t *indexes,
+                                                 arrsize_t arrsize,
+                                                 xss_thread_pool &pool)
+{
+    auto split = [keys, indexes, &pool](const xss_subarray &sub,
+                                        arrsize_t nblocks,
+                                        std::vector<xss_subarray> &children) {
+        type1_t pivot = get_pivot_blocks<vtype1>(keys, sub.left, sub.right);
+        type1_t smallest = vtype1::type_max();
+        type1_t biggest = vtype1::type_min();
+        arrsize_t pivot_index
+                = parallel_partition_avx512_kv<vtype1, vtype2>(keys,
+                                                               indexes,
+                                                               sub.left,
+                                                               sub.right + 1,
+                                                               nblocks,
+                                                               pivot,
+                                                               &smallest,
+                                                               &biggest,
+                                                               pool);
+        if (pivot != smallest) {
+            children.push_back({sub.left, pivot_index - 1, sub.max_iters - 1});
+        }
+        if (pivot != biggest) {
+            children.push_back({pivot_index, sub.right, sub.max_iters - 1});
+        }
+    };
+    auto sort = [keys, indexes, &pool](const xss_subarray &sub) {
+        qsort_kv_parallel_<vtype1, vtype2>(
+                keys, indexes, sub.left, sub.right, sub.max_iters, pool);
+    };
+    parallel_sort_(arrsize, 2 * (arrsize_t)log2(arrsize), split, sort, pool);
+}
+
+template <typename keytype,
+          typename valtype,
+          typename T1 = typename keytype::type_t,
+          typename T2 = typename valtype::type_t>
+X86_SIMD_SORT_INLINE void xss_qsort_kv_parallel(T1 *keys,
+                                                T2 *indexes,
+                                                arrsize_t arrsize,
+                                                bool hasnan,
+                                                xss_thread_pool &pool)
+{
+    if constexpr (std::is_floating_point_v<T1>) {
+        arrsize_t nan_count = 0;
+        if (UNLIKELY(hasnan)) {
+            nan_count = parallel_replace_nan_with_inf<keytype>(
+                    keys, arrsize, pool);
+        }
+        qsort_kv_parallel_all_<keytype, valtype>(keys, indexes, arrsize, pool);
+        replace_inf_with_nan(keys, arrsize, nan_count);
+    }
+    else {
+        UNUSED(hasnan);
+        qsort_kv_parallel_all_<keytype, valtype>(keys, indexes, arrsize, pool);
+    }
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx512_qsort_kv_parallel(T1 *keys,
+                                                   T2 *indexes,
+                                                   arrsize_t arrsize,
+                                                   bool hasnan,
+                                                   xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1) || (arrsize <= xss_parallel_task_cutoff)) {
+        avx512_qsort_kv(keys, indexes, arrsize, hasnan);
+        return;
+    }
+    using keytype =
+            typename std::conditional<sizeof(T1) != sizeof(T2)
+                                              && sizeof(T1) == sizeof(int32_t),
+                                      ymm_vector<T1>,
+                                      zmm_vector<T1>>::type;
+    using valtype =
+            typename std::conditional<sizeof(T1) != sizeof(T2)
+                                              && sizeof(T2) == sizeof(int32_t),
+                                      ymm_vector<T2>,
+                                      zmm_vector<T2>>::type;
+    xss_qsort_kv_parallel<keytype, valtype>(
+            keys, indexes, arrsize, hasnan, pool);
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx2_qsort_kv_parallel(T1 *keys,
+                                                 T2 *indexes,
+                                                 arrsize_t arrsize,
+                                                 bool hasnan,
+                                                 xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1) || (arrsize <= xss_parallel_task_cutoff)) {
+        avx2_qsort_kv(keys, indexes, arrsize, hasnan);
+        return;
+    }
+    using keytype = typename std::conditional<sizeof(T1) == sizeof(int32_t),
+                                              avx2_half_vector<T1>,
+                                              avx2_vector<T1>>::type;
+    using valtype = typename std::conditional<sizeof(T2) == sizeof(int32_t),
+                                              avx2_half_vector<T2>,
+                                              avx2_vector<T2>>::type;
+    xss_qsort_kv_parallel<keytype, valtype>(
+            keys, indexes, arrsize, hasnan, pool);
+}
+
+/* Run on a pool of nthreads threads or on an executor of the caller */
+#define DEFINE_PARALLEL_KV_METHODS(ISA) \
+    template <typename T1, typename T2> \
+    X86_SIMD_SORT_INLINE void ISA##_qsort_kv_parallel(T1 *keys, \
+                                                      T2 *indexes, \
+                                                      arrsize_t arrsize, \
+                                                      bool hasnan = false, \
+                                                      unsigned nthreads = 0) \
+    { \
+        xss_thread_pool pool(xss_get_num_threads(nthreads)); \
+        ISA##_qsort_kv_parallel(keys, indexes, arrsize, hasnan, pool); \
+    } \
+    template <typename T1, typename T2> \
+    X86_SIMD_SORT_INLINE void ISA##_qsort_kv_parallel( \
+            T1 *keys, \
+            T2 *indexes, \
+            arrsize_t arrsize, \
+            bool hasnan, \
+            const xss_executor &executor) \
+    { \
+        xss_thread_pool pool(executor); \
+        ISA##_qsort_kv_parallel(keys, indexes, arrsize, hasnan, pool); \
+    }
+
+DEFINE_PARALLEL_KV_METHODS(avx512)
+DEFINE_PARALLEL_KV_METHODS(avx2)
+
+#endif // XSS_PARALLEL_KEYVALUESORT
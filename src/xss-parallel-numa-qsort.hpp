@@ -0,0 +1,445 @@
+#ifndef XSS_PARALLEL_NUMA_QSORT
+#define XSS_PARALLEL_NUMA_QSORT
+
+/*
+ * NUMA-aware multi-threaded quicksort, for arrays sorted by threads spread
+ * over several memory nodes (e.g. both sockets of a 2-socket machine), where
+ * the plain parallel quicksort ends up reading and writing remote memory for
+ * a good part of its passes.
+ *
+ * The work is split into one domain per NUMA node, each with its own thread
+ * pool whose threads are bound to the node:
+ * (1) Domain d copies its range of the array into a scratch buffer; the first
+ * touch places the copy in node-local memory. The copy is then sorted with the
+ * multi-threaded quicksort (see xss-parallel-qsort.hpp) using the threads of
+ * the domain only.
+ * (2) The sorted ranges are merged pairwise, log2(domains) rounds, with the
+ * SIMD merge of xss-simd-merge.hpp. Every domain produces the part of the
+ * merged output that has the same position as its own range (found with a
+ * merge path search), so the merge work is spread evenly over the nodes.
+ *
+ * Node detection and thread binding use libnuma when XSS_USE_LIBNUMA is
+ * defined (link with -lnuma). Without it, or when libnuma is not usable at
+ * runtime, the machine is treated as a single node and the sort is the plain
+ * parallel quicksort. Asking for more domains than there are nodes maps the
+ * domains round-robin onto the nodes, which exercises the local sort + merge
+ * scheme on a single node machine.
+ *
+ * The pools of the domains are created once and used by all the phases. They
+ * can also be executors of the caller, one per domain, in which case the
+ * caller is in charge of running the tasks of each domain on its node.
+ */
+
+#include "xss-parallel-qsort.hpp"
+#include "xss-simd-merge.hpp"
+#include <functional>
+#ifdef XSS_USE_LIBNUMA
+#include <numa.h>
+#endif
+
+/*
+ * Domain boundaries are rounded to this many bytes so that no page of the
+ * scratch buffer is shared by two nodes
+ */
+constexpr arrsize_t xss_numa_page_size = 4096;
+
+/*
+ * The NUMA nodes that have CPUs to run on; {-1} when they cannot be queried
+ */
+X86_SIMD_SORT_INLINE std::vector<int> xss_numa_nodes()
+{
+    std::vector<int> nodes;
+#ifdef XSS_USE_LIBNUMA
+    if (numa_available() >= 0) {
+        struct bitmask *cpus = numa_allocate_cpumask();
+        for (int node = 0; node <= numa_max_node(); ++node) {
+            if (numa_bitmask_isbitset(numa_all_nodes_ptr, node)
+                && (numa_node_to_cpus(node, cpus) == 0)
+                && (numa_bitmask_weight(cpus) > 0)) {
+                nodes.push_back(node);
+            }
+        }
+        numa_free_cpumask(cpus);
+    }
+#endif
+    if (nodes.empty()) { nodes.push_back(-1); }
+    return nodes;
+}
+
+/*
+ * Restricts the calling thread (and the threads it creates afterwards) to the
+ * CPUs of node, and makes it allocate memory on that node
+ */
+X86_SIMD_SORT_INLINE void xss_numa_bind_thread(int node)
+{
+#ifdef XSS_USE_LIBNUMA
+    if (node >= 0) {
+        numa_run_on_node(node);
+        numa_set_localalloc();
+    }
+#else
+    UNUSED(node);
+#endif
+}
+
+namespace {
+
+/*
+ * The thread pools of the domains, created once per sort. run(phase) calls
+ * phase(domain, pool) for every domain, which submits the work of the domain
+ * to its pool, and returns when the tasks of all the domains are done.
+ *
+ * The built-in pools are each owned by a driver thread bound to the node of
+ * the domain (so that the workers it starts are bound to the node too),
+ * which waits for the phases and runs them. Pools over executors of the
+ * caller spawn no thread: the calling thread submits the phase of every
+ * domain and then waits for them in turn.
+ */
+class xss_numa_domains {
+public:
+    using phase_t = std::function<void(arrsize_t, xss_thread_pool &)>;
+
+    xss_numa_domains(const std::vector<int> &nodes,
+                     arrsize_t ndomains,
+                     unsigned nthreads)
+        : num_domains(ndomains)
+    {
+        drivers.reserve(ndomains);
+        for (arrsize_t d = 0; d < ndomains; ++d) {
+            drivers.emplace_back([this, node = nodes[d % nodes.size()],
+                                  nthreads, d]() {
+                xss_numa_bind_thread(node);
+                xss_thread_pool pool(nthreads);
+                drive(d, pool);
+            });
+        }
+    }
+
+    xss_numa_domains(const xss_executor *executors, arrsize_t ndomains)
+        : num_domains(ndomains)
+    {
+        pools.reserve(ndomains);
+        for (arrsize_t d = 0; d < ndomains; ++d) {
+            pools.emplace_back(new xss_thread_pool(executors[d]));
+        }
+    }
+
+    xss_numa_domains(const xss_numa_domains &) = delete;
+    xss_numa_domains &operator=(const xss_numa_domains &) = delete;
+
+    ~xss_numa_domains()
+    {
+        if (drivers.empty()) { return; }
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            stop = true;
+        }
+        start_cv.notify_all();
+        for (auto &t : drivers) {
+            t.join();
+        }
+    }
+
+    arrsize_t size() const
+    {
+        return num_domains;
+    }
+
+    void run(const phase_t &phase)
+    {
+        if (drivers.empty()) {
+            for (arrsize_t d = 0; d < num_domains; ++d) {
+                phase(d, *pools[d]);
+            }
+            for (arrsize_t d = 0; d < num_domains; ++d) {
+                pools[d]->wait();
+            }
+            return;
+        }
+        std::unique_lock<std::mutex> lk(lock);
+        current = &phase;
+        running = num_domains;
+        ++generation;
+        start_cv.notify_all();
+        done_cv.wait(lk, [this]() { return running == 0; });
+        current = nullptr;
+    }
+
+private:
+    void drive(arrsize_t d, xss_thread_pool &pool)
+    {
+        arrsize_t seen = 0;
+        std::unique_lock<std::mutex> lk(lock);
+        while (true) {
+            start_cv.wait(lk, [this, seen]() {
+                return stop || (generation != seen);
+            });
+            if (stop) { return; }
+            seen = generation;
+            const phase_t &phase = *current;
+            lk.unlock();
+            phase(d, pool);
+            pool.wait();
+            lk.lock();
+            if (--running == 0) { done_cv.notify_one(); }
+        }
+    }
+
+    arrsize_t num_domains;
+    /* Pools over executors of the caller */
+    std::vector<std::unique_ptr<xss_thread_pool>> pools;
+    /* Driver threads of the built-in pools */
+    std::vector<std::thread> drivers;
+    std::mutex lock;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const phase_t *current = nullptr;
+    arrsize_t generation = 0;
+    arrsize_t running = 0;
+    bool stop = false;
+};
+
+} // namespace
+
+/*
+ * Submits func(start, n) for every chunk of [0, len), one chunk per thread of
+ * pool
+ */
+template <typename Func>
+X86_SIMD_SORT_INLINE void
+xss_submit_chunks(xss_thread_pool &pool, arrsize_t len, Func func)
+{
+    arrsize_t nchunks = pool.num_threads();
+    arrsize_t chunk = (len + nchunks - 1) / nchunks;
+    for (arrsize_t start = 0; start < len; start += chunk) {
+        arrsize_t n = std::min(chunk, len - start);
+        pool.submit([func, start, n]() { func(start, n); });
+    }
+}
+
+/*
+ * Submits the tasks writing out[k0, k1) of the merge of a[0, na) and
+ * b[0, nb), spread over the threads of pool
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE void parallel_merge_range_(const type_t *a,
+                                                arrsize_t na,
+                                                const type_t *b,
+                                                arrsize_t nb,
+                                                type_t *out,
+                                                arrsize_t k0,
+                                                arrsize_t k1,
+                                                xss_thread_pool &pool)
+{
+    arrsize_t nchunks = parallel_num_blocks(k0, k1 - 1, pool.num_threads());
+    arrsize_t chunk = (k1 - k0 + nchunks - 1) / nchunks;
+    for (arrsize_t begin = k0; begin < k1; begin += chunk) {
+        arrsize_t end = std::min(begin + chunk, k1);
+        pool.submit([a, na, b, nb, out, begin, end]() {
+            arrsize_t ia = merge_path_split<vtype>(a, na, b, nb, begin);
+            arrsize_t ja = merge_path_split<vtype>(a, na, b, nb, end);
+            arrsize_t ib = begin - ia, jb = end - ja;
+            merge_sorted_<vtype>(
+                    a + ia, ja - ia, b + ib, jb - ib, out + begin);
+        });
+    }
+}
+
+/*
+ * Sorts arr with the pools of domains, one range of the array per domain.
+ * NaNs are replaced with +inf along the way; returns how many were found.
+ */
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE arrsize_t qsort_numa_parallel_(T *arr,
+                                                    arrsize_t arrsize,
+                                                    bool hasnan,
+                                                    xss_numa_domains &domains)
+{
+    /* Page aligned scratch buffer and domain boundaries */
+    constexpr arrsize_t page = xss_numa_page_size / sizeof(T);
+    arrsize_t ndomains = domains.size();
+    std::unique_ptr<char[]> raw(
+            new char[arrsize * sizeof(T) + xss_numa_page_size]);
+    T *scratch = (T *)(((uintptr_t)raw.get() + xss_numa_page_size - 1)
+                       & ~(uintptr_t)(xss_numa_page_size - 1));
+    std::vector<arrsize_t> offset(ndomains + 1);
+    for (arrsize_t d = 0; d < ndomains; ++d) {
+        offset[d] = (arrsize / ndomains * d) / page * page;
+    }
+    offset[ndomains] = arrsize;
+
+    /* (1) Node-local copy and sort of every domain */
+    std::atomic<arrsize_t> nan_count(0);
+    domains.run([&](arrsize_t d, xss_thread_pool &pool) {
+        const T *from = arr + offset[d];
+        T *local = scratch + offset[d];
+        xss_submit_chunks(pool,
+                          offset[d + 1] - offset[d],
+                          [from, local, hasnan, &nan_count](arrsize_t start,
+                                                            arrsize_t n) {
+                              std::copy(from + start,
+                                        from + start + n,
+                                        local + start);
+                              if constexpr (std::is_floating_point_v<T>) {
+                                  if (UNLIKELY(hasnan)) {
+                                      nan_count += replace_nan_with_inf<vtype>(
+                                              local + start, n);
+                                  }
+                              }
+                              else {
+                                  UNUSED(hasnan);
+                              }
+                          });
+    });
+    domains.run([&](arrsize_t d, xss_thread_pool &pool) {
+        qsort_parallel_start_<vtype>(
+                scratch + offset[d], offset[d + 1] - offset[d], pool);
+    });
+
+    /* (2) Pairwise merges, ping-ponging between scratch and arr */
+    T *src = scratch, *dst = arr;
+    for (arrsize_t width = 1; width < ndomains; width *= 2) {
+        domains.run([&](arrsize_t d, xss_thread_pool &pool) {
+            arrsize_t first = d / (2 * width) * (2 * width);
+            arrsize_t lo = offset[first];
+            arrsize_t mid = offset[std::min(first + width, ndomains)];
+            arrsize_t hi = offset[std::min(first + 2 * width, ndomains)];
+            parallel_merge_range_<vtype>(src + lo,
+                                         mid - lo,
+                                         src + mid,
+                                         hi - mid,
+                                         dst + lo,
+                                         offset[d] - lo,
+                                         offset[d + 1] - lo,
+                                         pool);
+        });
+        std::swap(src, dst);
+    }
+    if (src != arr) {
+        domains.run([&](arrsize_t d, xss_thread_pool &pool) {
+            const T *from = src + offset[d];
+            T *to = arr + offset[d];
+            xss_submit_chunks(pool,
+                              offset[d + 1] - offset[d],
+                              [from, to](arrsize_t start, arrsize_t n) {
+                                  std::copy(from + start,
+                                            from + start + n,
+                                            to + start);
+                              });
+        });
+    }
+    return nan_count;
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void xss_qsort_numa_parallel(T *arr,
+                                                  arrsize_t arrsize,
+                                                  bool hasnan,
+                                                  unsigned nthreads,
+                                                  unsigned ndomains)
+{
+    std::vector<int> nodes = xss_numa_nodes();
+    nthreads = xss_get_num_threads(nthreads);
+    if (ndomains == 0) { ndomains = nodes.size(); }
+    /* Every domain has to get at least a thread and a few pages */
+    ndomains = std::min<arrsize_t>(
+            {ndomains, nthreads, arrsize / xss_parallel_task_cutoff});
+    if (ndomains <= 1) {
+        xss_thread_pool pool(nthreads);
+        xss_qsort_parallel<vtype, T>(arr, arrsize, hasnan, pool);
+        return;
+    }
+    xss_numa_domains domains(nodes, ndomains, nthreads / ndomains);
+    arrsize_t nan_count
+            = qsort_numa_parallel_<vtype>(arr, arrsize, hasnan, domains);
+    if constexpr (std::is_floating_point_v<T>) {
+        replace_inf_with_nan(arr, arrsize, nan_count);
+    }
+    else {
+        UNUSED(nan_count);
+    }
+}
+
+/*
+ * Same as above with one executor of the caller per domain: executors[d]
+ * sorts and merges the range of domain d, and is expected to run its tasks
+ * on the CPUs of one NUMA node.
+ */
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void
+xss_qsort_numa_parallel(T *arr,
+                        arrsize_t arrsize,
+                        bool hasnan,
+                        const xss_executor *executors,
+                        unsigned ndomains)
+{
+    if ((executors == nullptr) || (ndomains == 0)) {
+        xss_qsort<vtype, T>(arr, arrsize, hasnan);
+        return;
+    }
+    /* Every domain has to get at least a few pages */
+    ndomains = std::min<arrsize_t>(ndomains,
+                                   arrsize / xss_parallel_task_cutoff);
+    if (ndomains <= 1) {
+        xss_thread_pool pool(executors[0]);
+        xss_qsort_parallel<vtype, T>(arr, arrsize, hasnan, pool);
+        return;
+    }
+    xss_numa_domains domains(executors, ndomains);
+    arrsize_t nan_count
+            = qsort_numa_parallel_<vtype>(arr, arrsize, hasnan, domains);
+    if constexpr (std::is_floating_point_v<T>) {
+        replace_inf_with_nan(arr, arrsize, nan_count);
+    }
+    else {
+        UNUSED(nan_count);
+    }
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx512_qsort_numa_parallel(T *arr,
+                                                     arrsize_t arrsize,
+                                                     bool hasnan = false,
+                                                     unsigned nthreads = 0,
+                                                     unsigned ndomains = 0)
+{
+    xss_qsort_numa_parallel<zmm_vector<T>, T>(
+            arr, arrsize, hasnan, nthreads, ndomains);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx2_qsort_numa_parallel(T *arr,
+                                                   arrsize_t arrsize,
+                                                   bool hasnan = false,
+                                                   unsigned nthreads = 0,
+                                                   unsigned ndomains = 0)
+{
+    xss_qsort_numa_parallel<avx2_vector<T>, T>(
+            arr, arrsize, hasnan, nthreads, ndomains);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+avx512_qsort_numa_parallel(T *arr,
+                           arrsize_t arrsize,
+                           bool hasnan,
+                           const xss_executor *executors,
+                           unsigned ndomains)
+{
+    xss_qsort_numa_parallel<zmm_vector<T>, T>(
+            arr, arrsize, hasnan, executors, ndomains);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+avx2_qsort_numa_parallel(T *arr,
+                         arrsize_t arrsize,
+                         bool hasnan,
+                         const xss_executor *executors,
+                         unsigned ndomains)
+{
+    xss_qsort_numa_parallel<avx2_vector<T>, T>(
+            arr, arrsize, hasnan, executors, ndomains);
+}
+
+#endif // XSS_PARALLEL_NUMA_QSORT
@@ -0,0 +1,544 @@
+#ifndef XSS_PARALLEL_QSORT
+#define XSS_PARALLEL_QSORT
+
+/*
+ * Multi-threaded quicksort and quickselect.
+ *
+ * (1) Top of the recursion: while there are fewer sub-arrays than threads,
+ * the biggest sub-array is partitioned with all the threads of the pool (see
+ * parallel_partition_ below).
+ * (2) Once there is enough parallelism, every sub-array is sorted in a task
+ * of a work-stealing thread pool (see xss-thread-pool.hpp): after
+ * partitioning a sub-array, the left partition is handed off to the pool as a
+ * new task and the current thread carries on with the right partition.
+ * Sub-arrays smaller than xss_parallel_task_cutoff are sorted with the serial
+ * qsort_ since they are not worth the overhead of a task.
+ */
+
+#include "xss-common-qsort.h"
+#include "xss-thread-pool.hpp"
+
+/*
+ * Sub-arrays with fewer elements than this are sorted serially in the task
+ * that produced them
+ */
+constexpr arrsize_t xss_parallel_task_cutoff = 1 << 16;
+/*
+ * Smallest block handled by a single thread in the parallel partition
+ */
+constexpr arrsize_t xss_parallel_block_cutoff = 1 << 16;
+
+struct xss_subarray {
+    arrsize_t left;
+    arrsize_t right; /* inclusive */
+    arrsize_t max_iters;
+};
+
+/*
+ * Number of blocks to use when partitioning [left, right] with nthreads
+ * threads; 1 means the partition is not worth parallelizing.
+ */
+X86_SIMD_SORT_INLINE arrsize_t parallel_num_blocks(arrsize_t left,
+                                                   arrsize_t right,
+                                                   unsigned nthreads)
+{
+    arrsize_t nblocks = (right + 1 - left) / xss_parallel_block_cutoff;
+    return std::max<arrsize_t>(1, std::min<arrsize_t>(nblocks, nthreads));
+}
+
+/*
+ * Swaps the misplaced elements [first, last) where the i-th misplaced
+ * element >= pivot lives in one of the big_left ranges and the i-th
+ * misplaced element < pivot lives in one of the small_right ranges.
+ */
+template <typename SwapRanges>
+X86_SIMD_SORT_INLINE void
+swap_misplaced(const std::vector<std::pair<arrsize_t, arrsize_t>> &big_left,
+               const std::vector<std::pair<arrsize_t, arrsize_t>> &small_right,
+               arrsize_t first,
+               arrsize_t last,
+               SwapRanges swap_ranges)
+{
+    /* Locate element number first in both lists of ranges */
+    size_t ib = 0, is = 0;
+    arrsize_t pos_b = first, pos_s = first;
+    while (pos_b >= big_left[ib].second - big_left[ib].first) {
+        pos_b -= big_left[ib].second - big_left[ib].first;
+        ++ib;
+    }
+    while (pos_s >= small_right[is].second - small_right[is].first) {
+        pos_s -= small_right[is].second - small_right[is].first;
+        ++is;
+    }
+    arrsize_t remaining = last - first;
+    while (remaining > 0) {
+        arrsize_t b = big_left[ib].first + pos_b;
+        arrsize_t s = small_right[is].first + pos_s;
+        arrsize_t len = std::min({remaining,
+                                  big_left[ib].second - b,
+                                  small_right[is].second - s});
+        swap_ranges(b, s, len);
+        remaining -= len;
+        pos_b += len;
+        pos_s += len;
+        if (big_left[ib].first + pos_b == big_left[ib].second) {
+            ++ib;
+            pos_b = 0;
+        }
+        if (small_right[is].first + pos_s == small_right[is].second) {
+            ++is;
+            pos_s = 0;
+        }
+    }
+}
+
+/*
+ * Partitions [left, right) using nblocks threads of the pool:
+ * (1) The range is split into nblocks contiguous blocks which are partitioned
+ * concurrently by block_partition(begin, end, &smallest, &biggest). It has to
+ * return the index of the first element >= pivot in [begin, end) and update
+ * smallest and biggest like partition_avx512_unrolled.
+ * (2) Every block now has its elements < pivot followed by elements >= pivot,
+ * which determines the final split point of the whole range. The elements
+ * >= pivot on the left of the split point are swapped with the elements <
+ * pivot on its right using swap_ranges(a, b, len), again spread over all the
+ * threads.
+ * Returns the index of the first element >= pivot, just like the serial
+ * partition routines. Must not be called from within a task of the pool.
+ */
+template <typename vtype,
+          typename type_t,
+          typename BlockPartition,
+          typename SwapRanges>
+X86_SIMD_SORT_INLINE arrsize_t parallel_partition_(arrsize_t left,
+                                                   arrsize_t right,
+                                                   arrsize_t nblocks,
+                                                   type_t *smallest,
+                                                   type_t *biggest,
+                                                   BlockPartition block_partition,
+                                                   SwapRanges swap_ranges,
+                                                   xss_thread_pool &pool)
+{
+    arrsize_t blocksize = (right - left) / nblocks;
+    auto block_begin = [=](arrsize_t b) { return left + b * blocksize; };
+    auto block_end = [=](arrsize_t b) {
+        return (b == nblocks - 1) ? right : left + (b + 1) * blocksize;
+    };
+
+    std::vector<arrsize_t> split(nblocks);
+    std::vector<type_t> mins(nblocks, vtype::type_max());
+    std::vector<type_t> maxs(nblocks, vtype::type_min());
+    for (arrsize_t b = 0; b < nblocks; ++b) {
+        pool.submit([&, b]() {
+            split[b] = block_partition(
+                    block_begin(b), block_end(b), &mins[b], &maxs[b]);
+        });
+    }
+    pool.wait();
+
+    arrsize_t mid = left;
+    for (arrsize_t b = 0; b < nblocks; ++b) {
+        mid += split[b] - block_begin(b);
+        *smallest = std::min(*smallest, mins[b], comparison_func<vtype>);
+        *biggest = std::max(*biggest, maxs[b], comparison_func<vtype>);
+    }
+
+    /* Misplaced elements: >= pivot in [left, mid) and < pivot in [mid, right) */
+    std::vector<std::pair<arrsize_t, arrsize_t>> big_left, small_right;
+    arrsize_t num_misplaced = 0;
+    for (arrsize_t b = 0; b < nblocks; ++b) {
+        arrsize_t hi = std::min(block_end(b), mid);
+        if (split[b] < hi) {
+            big_left.emplace_back(split[b], hi);
+            num_misplaced += hi - split[b];
+        }
+        arrsize_t lo = std::max(block_begin(b), mid);
+        if (lo < split[b]) { small_right.emplace_back(lo, split[b]); }
+    }
+    if (num_misplaced == 0) { return mid; }
+
+    arrsize_t chunk = std::max((num_misplaced + nblocks - 1) / nblocks,
+                               xss_parallel_block_cutoff);
+    for (arrsize_t first = 0; first < num_misplaced; first += chunk) {
+        arrsize_t last = std::min(first + chunk, num_misplaced);
+        pool.submit([&, first, last]() {
+            swap_misplaced(big_left, small_right, first, last, swap_ranges);
+        });
+    }
+    pool.wait();
+    return mid;
+}
+
+/*
+ * Starts sorting [0, arrsize) with all the threads of the pool. split(sub,
+ * nblocks, children) partitions sub using nblocks threads and appends the
+ * sub-arrays that still need sorting to children; sort(sub) sorts sub and is
+ * run as a task of the pool. Returns once the top of the recursion is done:
+ * the sort is finished by the next pool.wait().
+ */
+template <typename SplitFunc, typename SortFunc>
+X86_SIMD_SORT_INLINE void parallel_sort_start_(arrsize_t arrsize,
+                                               arrsize_t max_iters,
+                                               SplitFunc split,
+                                               SortFunc sort,
+                                               xss_thread_pool &pool)
+{
+    std::vector<xss_subarray> subarrays = {{0, arrsize - 1, max_iters}};
+    std::vector<xss_subarray> leaves;
+    while (!subarrays.empty()
+           && (subarrays.size() + leaves.size() < pool.num_threads())) {
+        auto biggest = std::max_element(
+                subarrays.begin(),
+                subarrays.end(),
+                [](const xss_subarray &a, const xss_subarray &b) {
+                    return a.right - a.left < b.right - b.left;
+                });
+        xss_subarray sub = *biggest;
+        subarrays.erase(biggest);
+        arrsize_t nblocks
+                = parallel_num_blocks(sub.left, sub.right, pool.num_threads());
+        if ((nblocks == 1) || (sub.max_iters <= 0)) {
+            leaves.push_back(sub);
+            continue;
+        }
+        split(sub, nblocks, subarrays);
+    }
+    leaves.insert(leaves.end(), subarrays.begin(), subarrays.end());
+    for (auto sub : leaves) {
+        pool.submit([sort, sub]() { sort(sub); });
+    }
+}
+
+/*
+ * Sorts [0, arrsize) with all the threads of the pool, see
+ * parallel_sort_start_
+ */
+template <typename SplitFunc, typename SortFunc>
+X86_SIMD_SORT_INLINE void parallel_sort_(arrsize_t arrsize,
+                                         arrsize_t max_iters,
+                                         SplitFunc split,
+                                         SortFunc sort,
+                                         xss_thread_pool &pool)
+{
+    parallel_sort_start_(arrsize, max_iters, split, sort, pool);
+    pool.wait();
+}
+
+template <typename vtype, typename type_t>
+static void qsort_parallel_(type_t *arr,
+                            arrsize_t left,
+                            arrsize_t right,
+                            arrsize_t max_iters,
+                            xss_thread_pool &pool)
+{
+    /*
+     * Small sub-arrays (and sub-arrays on which quicksort isnt making any
+     * progress) are handled by the serial qsort_
+     */
+    if ((right + 1 - left <= xss_parallel_task_cutoff) || (max_iters <= 0)) {
+        qsort_<vtype>(arr, left, right, max_iters);
+        return;
+    }
+
+    auto pivot_result = get_pivot_smart<vtype, type_t>(arr, left, right);
+    type_t pivot = pivot_result.pivot;
+
+    if (pivot_result.result == pivot_result_t::Sorted) { return; }
+
+    type_t smallest = vtype::type_max();
+    type_t biggest = vtype::type_min();
+
+    arrsize_t pivot_index
+            = partition_avx512_unrolled<vtype, vtype::partition_unroll_factor>(
+                    arr, left, right + 1, pivot, &smallest, &biggest);
+
+    if (pivot_result.result == pivot_result_t::Only2Values) { return; }
+
+    if (pivot != smallest) {
+        pool.submit([arr, left, pivot_index, max_iters, &pool]() {
+            qsort_parallel_<vtype>(
+                    arr, left, pivot_index - 1, max_iters - 1, pool);
+        });
+    }
+    if (pivot != biggest) {
+        qsort_parallel_<vtype>(arr, pivot_index, right, max_iters - 1, pool);
+    }
+}
+
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE arrsize_t
+parallel_partition_avx512(type_t *arr,
+                          arrsize_t left,
+                          arrsize_t right,
+                          arrsize_t nblocks,
+                          type_t pivot,
+                          type_t *smallest,
+                          type_t *biggest,
+                          xss_thread_pool &pool)
+{
+    return parallel_partition_<vtype>(
+            left,
+            right,
+            nblocks,
+            smallest,
+            biggest,
+            [arr, pivot](arrsize_t begin,
+                         arrsize_t end,
+                         type_t *blk_smallest,
+                         type_t *blk_biggest) {
+                return partition_avx512_unrolled<vtype,
+                                                 vtype::partition_unroll_factor>(
+                        arr, begin, end, pivot, blk_smallest, blk_biggest);
+            },
+            [arr](arrsize_t a, arrsize_t b, arrsize_t len) {
+                std::swap_ranges(arr + a, arr + a + len, arr + b);
+            },
+            pool);
+}
+
+/*
+ * Starts sorting arr with all the threads of pool, assuming arr has no NaNs;
+ * arr is sorted after the next pool.wait()
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE void
+qsort_parallel_start_(type_t *arr, arrsize_t arrsize, xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1) || (arrsize <= xss_parallel_task_cutoff)) {
+        if (arrsize > 1) {
+            pool.submit([arr, arrsize]() {
+                qsort_<vtype, type_t>(
+                        arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+            });
+        }
+        return;
+    }
+
+    auto split = [arr, &pool](const xss_subarray &sub,
+                              arrsize_t nblocks,
+                              std::vector<xss_subarray> &children) {
+        auto pivot_result
+                = get_pivot_smart<vtype, type_t>(arr, sub.left, sub.right);
+        type_t pivot = pivot_result.pivot;
+
+        if (pivot_result.result == pivot_result_t::Sorted) { return; }
+
+        type_t smallest = vtype::type_max();
+        type_t biggest = vtype::type_min();
+
+        arrsize_t pivot_index = parallel_partition_avx512<vtype>(arr,
+                                                                 sub.left,
+                                                                 sub.right + 1,
+                                                                 nblocks,
+                                                                 pivot,
+                                                                 &smallest,
+                                                                 &biggest,
+                                                                 pool);
+
+        if (pivot_result.result == pivot_result_t::Only2Values) { return; }
+
+        if (pivot != smallest) {
+            children.push_back({sub.left, pivot_index - 1, sub.max_iters - 1});
+        }
+        if (pivot != biggest) {
+            children.push_back({pivot_index, sub.right, sub.max_iters - 1});
+        }
+    };
+    auto sort = [arr, &pool](const xss_subarray &sub) {
+        qsort_parallel_<vtype>(arr, sub.left, sub.right, sub.max_iters, pool);
+    };
+    parallel_sort_start_(
+            arrsize, 2 * (arrsize_t)log2(arrsize), split, sort, pool);
+}
+
+/*
+ * Sorts arr with all the threads of pool, assuming arr has no NaNs
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE void
+qsort_parallel_all_(type_t *arr, arrsize_t arrsize, xss_thread_pool &pool)
+{
+    qsort_parallel_start_<vtype>(arr, arrsize, pool);
+    pool.wait();
+}
+
+/*
+ * Replaces NaNs with +inf (see replace_nan_with_inf) one chunk per thread and
+ * returns the total number of NaNs found
+ */
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE arrsize_t parallel_replace_nan_with_inf(
+        T *arr, arrsize_t arrsize, xss_thread_pool &pool)
+{
+    std::atomic<arrsize_t> nan_count(0);
+    arrsize_t nchunks = pool.num_threads();
+    arrsize_t chunk = (arrsize + nchunks - 1) / nchunks;
+    for (arrsize_t start = 0; start < arrsize; start += chunk) {
+        arrsize_t len = std::min(chunk, arrsize - start);
+        pool.submit([arr, start, len, &nan_count]() {
+            nan_count += replace_nan_with_inf<vtype>(arr + start, len);
+        });
+    }
+    pool.wait();
+    return nan_count;
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void xss_qsort_parallel(T *arr,
+                                             arrsize_t arrsize,
+                                             bool hasnan,
+                                             xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1) || (arrsize <= xss_parallel_task_cutoff)) {
+        xss_qsort<vtype, T>(arr, arrsize, hasnan);
+        return;
+    }
+
+    if constexpr (std::is_floating_point_v<T>) {
+        arrsize_t nan_count = 0;
+        if (UNLIKELY(hasnan)) {
+            nan_count = parallel_replace_nan_with_inf<vtype>(
+                    arr, arrsize, pool);
+        }
+        qsort_parallel_all_<vtype>(arr, arrsize, pool);
+        replace_inf_with_nan(arr, arrsize, nan_count);
+    }
+    else {
+        UNUSED(hasnan);
+        qsort_parallel_all_<vtype>(arr, arrsize, pool);
+    }
+}
+
+/*
+ * Quickselect on [0, last_elem]: the partitions are done in parallel until
+ * the sub-array containing pos gets too small to benefit from threads.
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE void qselect_parallel_(type_t *arr,
+                                            arrsize_t pos,
+                                            arrsize_t last_elem,
+                                            xss_thread_pool &pool)
+{
+    arrsize_t left = 0, right = last_elem;
+    arrsize_t max_iters = 2 * (arrsize_t)log2(last_elem);
+    arrsize_t nblocks = parallel_num_blocks(left, right, pool.num_threads());
+    while ((nblocks > 1) && (max_iters > 0)) {
+        type_t pivot = get_pivot<vtype, type_t>(arr, left, right);
+        type_t smallest = vtype::type_max();
+        type_t biggest = vtype::type_min();
+
+        arrsize_t pivot_index = parallel_partition_avx512<vtype>(arr,
+                                                                 left,
+                                                                 right + 1,
+                                                                 nblocks,
+                                                                 pivot,
+                                                                 &smallest,
+                                                                 &biggest,
+                                                                 pool);
+
+        if ((pivot != smallest) && (pos < pivot_index)) {
+            right = pivot_index - 1;
+        }
+        else if ((pivot != biggest) && (pos >= pivot_index)) {
+            left = pivot_index;
+        }
+        else {
+            return;
+        }
+        max_iters -= 1;
+        nblocks = parallel_num_blocks(left, right, pool.num_threads());
+    }
+    qselect_<vtype>(arr, pos, left, right, max_iters);
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void xss_qselect_parallel(T *arr,
+                                               arrsize_t k,
+                                               arrsize_t arrsize,
+                                               bool hasnan,
+                                               xss_thread_pool &pool)
+{
+    if ((pool.num_threads() == 1)
+        || (arrsize <= 2 * xss_parallel_block_cutoff)) {
+        xss_qselect<vtype, T>(arr, k, arrsize, hasnan);
+        return;
+    }
+
+    arrsize_t indx_last_elem = arrsize - 1;
+    if constexpr (std::is_floating_point_v<T>) {
+        if (UNLIKELY(hasnan)) {
+            indx_last_elem = move_nans_to_end_of_array(arr, arrsize);
+        }
+    }
+    UNUSED(hasnan);
+    if (indx_last_elem >= k) {
+        qselect_parallel_<vtype>(arr, k, indx_last_elem, pool);
+    }
+}
+
+/*
+ * Every parallel routine comes in three flavours: the one doing the work on
+ * an xss_thread_pool, and two wrappers running it on a pool of nthreads
+ * threads or on an executor supplied by the caller.
+ */
+#define DEFINE_PARALLEL_METHODS(ISA, VTYPE) \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE void ISA##_qsort_parallel( \
+            T *arr, arrsize_t size, bool hasnan, xss_thread_pool &pool) \
+    { \
+        xss_qsort_parallel<VTYPE, T>(arr, size, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE void ISA##_qsort_parallel(T *arr, \
+                                                   arrsize_t size, \
+                                                   bool hasnan = false, \
+                                                   unsigned nthreads = 0) \
+    { \
+        xss_thread_pool pool(xss_get_num_threads(nthreads)); \
+        ISA##_qsort_parallel(arr, size, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE void ISA##_qsort_parallel( \
+            T *arr, \
+            arrsize_t size, \
+            bool hasnan, \
+            const xss_executor &executor) \
+    { \
+        xss_thread_pool pool(executor); \
+        ISA##_qsort_parallel(arr, size, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE void ISA##_qselect_parallel(T *arr, \
+                                                     arrsize_t k, \
+                                                     arrsize_t size, \
+                                                     bool hasnan, \
+                                                     xss_thread_pool &pool) \
+    { \
+        xss_qselect_parallel<VTYPE, T>(arr, k, size, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE void ISA##_qselect_parallel(T *arr, \
+                                                     arrsize_t k, \
+                                                     arrsize_t size, \
+                                                     bool hasnan = false, \
+                                                     unsigned nthreads = 0) \
+    { \
+        xss_thread_pool pool(xss_get_num_threads(nthreads)); \
+        ISA##_qselect_parallel(arr, k, size, hasnan, pool); \
+    } \
+    template <typename T> \
+    X86_SIMD_SORT_INLINE void ISA##_qselect_parallel( \
+            T *arr, \
+            arrsize_t k, \
+            arrsize_t size, \
+            bool hasnan, \
+            const xss_executor &executor) \
+    { \
+        xss_thread_pool pool(executor); \
+        ISA##_qselect_parallel(arr, k, size, hasnan, pool); \
+    }
+
+DEFINE_PARALLEL_METHODS(avx512, zmm_vector<T>)
+DEFINE_PARALLEL_METHODS(avx2, avx2_vector<T>)
+
+#endif // XSS_PARALLEL_QSORT
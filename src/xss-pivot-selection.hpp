@@ -9,7 +9,7 @@ template <typename type_t>
 struct pivot_results {
 
     pivot_result_t result = pivot_result_t::Normal;
-    type_t pivot = 0;
+    type_t pivot {};
 
     pivot_results(type_t _pivot,
                   pivot_result_t _result = pivot_result_t::Normal)
@@ -19,11 +19,26 @@ struct pivot_results {
     }
 };
 
-template <typename type_t>
+/* The value that follows value in the sort order of vtype */
+template <typename vtype, typename type_t>
 type_t next_value(type_t value)
 {
     // TODO this probably handles non-native float16 wrong
-    if constexpr (std::is_floating_point<type_t>::value) {
+    if constexpr (is_descending_v<vtype>) {
+        if constexpr (std::is_floating_point<type_t>::value) {
+            return std::nextafter(value,
+                                  -std::numeric_limits<type_t>::infinity());
+        }
+        else {
+            if (value > std::numeric_limits<type_t>::min()) {
+                return value - 1;
+            }
+            else {
+                return value;
+            }
+        }
+    }
+    else if constexpr (std::is_floating_point<type_t>::value) {
         return std::nextafter(value, std::numeric_limits<type_t>::infinity());
     }
     else {
@@ -51,7 +66,8 @@ X86_SIMD_SORT_INLINE type_t get_pivot(type_t *arr,
     reg_t rand_vec = vtype::loadu(samples);
     reg_t sort = vtype::sort_vec(rand_vec);
 
-    return ((type_t *)&sort)[vtype::numlanes / 2];
+    vtype::storeu(samples, sort);
+    return samples[vtype::numlanes / 2];
 }
 
 template <typename vtype, typename type_t>
@@ -150,7 +166,7 @@ get_pivot_smart(type_t *arr, const arrsize_t left, const arrsize_t right)
     else if (median == smallest) {
         // If median == smallest, that implies approximately half the array is equal to smallest, unless we were very unlucky with our sample
         // Try just doing the next largest value greater than this seemingly very common value to seperate them out
-        return pivot_results<type_t>(next_value<type_t>(median));
+        return pivot_results<type_t>(next_value<vtype, type_t>(median));
     }
     else if (median == largest) {
         // If median == largest, that implies approximately half the array is equal to largest, unless we were very unlucky with our sample
@@ -178,8 +194,8 @@ get_pivot_near_constant(type_t *arr,
 
     arrsize_t index = left;
 
-    type_t value1 = 0;
-    type_t value2 = 0;
+    type_t value1 {};
+    type_t value2 {};
 
     // First, search for any value not equal to the common value
     // First vectorized
@@ -0,0 +1,168 @@
+#ifndef XSS_RADIX_QSORT
+#define XSS_RADIX_QSORT
+
+/*
+ * Hybrid MSD radix sort / quicksort for 32-bit and 64-bit integers, for
+ * large arrays of uniformly distributed keys (hashes, ids):
+ * (1) The range [min, max] of the keys is found with SIMD min/max and split
+ * into 256 equal buckets, the top 8 bits of (key - min). One counting pass
+ * scatters the array into the scratch buffer by bucket.
+ * (2) Buckets larger than xss_radix_bucket_size are split again on the next 8
+ * bits while being scattered back into arr. Smaller buckets are just copied
+ * back.
+ * (3) Every bucket, now in arr and small enough to be cache resident, is
+ * sorted with qsort_ (i.e. the vectorized partitions and bitonic networks).
+ *
+ * Splitting by range rather than by the top bits of the type keeps the
+ * buckets balanced for keys that only use part of the type (e.g. ids in
+ * [0, 10^6) stored as int32_t). Skewed distributions produce uneven buckets
+ * but every bucket is still sorted correctly by qsort_.
+ */
+
+#include "xss-common-qsort.h"
+#include "xss-radix-sort.hpp"
+
+/*
+ * Buckets of at most this many elements are sorted with qsort_
+ */
+constexpr arrsize_t xss_radix_bucket_size = 16384;
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void
+radix_minmax(const T *arr, arrsize_t arrsize, T *smallest, T *biggest)
+{
+    using reg_t = typename vtype::reg_t;
+    constexpr arrsize_t numlanes = vtype::numlanes;
+    T min_val = arr[0], max_val = arr[0];
+    arrsize_t i = 0;
+    if (arrsize >= 2 * numlanes) {
+        reg_t min_vec1 = vtype::loadu(arr), max_vec1 = min_vec1;
+        reg_t min_vec2 = vtype::loadu(arr + numlanes), max_vec2 = min_vec2;
+        for (i = 2 * numlanes; i + 2 * numlanes <= arrsize;
+             i += 2 * numlanes) {
+            reg_t v1 = vtype::loadu(arr + i);
+            reg_t v2 = vtype::loadu(arr + i + numlanes);
+            min_vec1 = vtype::min(min_vec1, v1);
+            max_vec1 = vtype::max(max_vec1, v1);
+            min_vec2 = vtype::min(min_vec2, v2);
+            max_vec2 = vtype::max(max_vec2, v2);
+        }
+        min_val = vtype::reducemin(vtype::min(min_vec1, min_vec2));
+        max_val = vtype::reducemax(vtype::max(max_vec1, max_vec2));
+    }
+    for (; i < arrsize; ++i) {
+        min_val = std::min(min_val, arr[i]);
+        max_val = std::max(max_val, arr[i]);
+    }
+    *smallest = min_val;
+    *biggest = max_val;
+}
+
+/*
+ * Stable scatter of src[0, arrsize) into dst by the bucket
+ * ((radix_key(x) - base) >> shift) & 0xFF of each element x. On return
+ * offset[d] is the start of bucket d in dst, offset[256] == arrsize.
+ */
+template <typename T, typename U = std::make_unsigned_t<T>>
+X86_SIMD_SORT_INLINE void radix_msd_pass(const T *src,
+                                         T *dst,
+                                         arrsize_t arrsize,
+                                         U base,
+                                         int shift,
+                                         arrsize_t *offset)
+{
+    arrsize_t count[4][256] = {};
+    arrsize_t i = 0;
+    for (; i + 4 <= arrsize; i += 4) {
+        X86_SIMD_SORT_UNROLL_LOOP(4)
+        for (int j = 0; j < 4; ++j) {
+            count[j][((radix_key(src[i + j]) - base) >> shift) & 0xFF]++;
+        }
+    }
+    for (; i < arrsize; ++i) {
+        count[0][((radix_key(src[i]) - base) >> shift) & 0xFF]++;
+    }
+    arrsize_t next[256];
+    arrsize_t sum = 0;
+    for (int d = 0; d < 256; ++d) {
+        offset[d] = next[d] = sum;
+        sum += count[0][d] + count[1][d] + count[2][d] + count[3][d];
+    }
+    offset[256] = sum;
+    for (i = 0; i < arrsize; ++i) {
+        dst[next[((radix_key(src[i]) - base) >> shift) & 0xFF]++] = src[i];
+    }
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void radix_qsort_bucket(T *arr, arrsize_t arrsize)
+{
+    if (arrsize > 1) {
+        qsort_<vtype, T>(arr, 0, arrsize - 1, 2 * (arrsize_t)log2(arrsize));
+    }
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void xss_radix_qsort(T *arr, arrsize_t arrsize)
+{
+    static_assert(std::is_integral_v<T> && sizeof(T) >= 4,
+                  "hybrid radix sort supports 32-bit and 64-bit integers");
+    using U = std::make_unsigned_t<T>;
+    if (arrsize <= xss_radix_bucket_size) {
+        radix_qsort_bucket<vtype>(arr, arrsize);
+        return;
+    }
+
+    T smallest, biggest;
+    radix_minmax<vtype>(arr, arrsize, &smallest, &biggest);
+    if (smallest == biggest) { return; }
+    U base = radix_key(smallest);
+    U range = radix_key(biggest) - base;
+    int rangebits = 64 - __builtin_clzll((unsigned long long)range);
+    int shift = std::max(rangebits - 8, 0);
+
+    /* (1) arr -> buf */
+    std::unique_ptr<T[]> buf(new T[arrsize]);
+    arrsize_t offset[257];
+    radix_msd_pass(arr, buf.get(), arrsize, base, shift, offset);
+
+    for (int d = 0; d < 256; ++d) {
+        arrsize_t start = offset[d];
+        arrsize_t len = offset[d + 1] - start;
+        if (len <= xss_radix_bucket_size || shift == 0) {
+            /* (3) all keys of a bucket are equal when shift is 0 */
+            std::copy(buf.get() + start, buf.get() + start + len, arr + start);
+            if (shift > 0) { radix_qsort_bucket<vtype>(arr + start, len); }
+            continue;
+        }
+        /* (2) buf -> arr on the next 8 bits, then (3) */
+        U subbase = base + ((U)d << shift);
+        int subshift = std::max(shift - 8, 0);
+        arrsize_t suboffset[257];
+        radix_msd_pass(buf.get() + start,
+                       arr + start,
+                       len,
+                       subbase,
+                       subshift,
+                       suboffset);
+        if (subshift == 0) { continue; }
+        for (int s = 0; s < 256; ++s) {
+            radix_qsort_bucket<vtype>(arr + start + suboffset[s],
+                                      suboffset[s + 1] - suboffset[s]);
+        }
+    }
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx512_radix_qsort(T *arr, arrsize_t arrsize)
+{
+    xss_radix_qsort<zmm_vector<T>, T>(arr, arrsize);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void avx2_radix_qsort(T *arr, arrsize_t arrsize)
+{
+    xss_radix_qsort<avx2_vector<T>, T>(arr, arrsize);
+}
+
+#endif // XSS_RADIX_QSORT
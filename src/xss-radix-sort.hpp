@@ -0,0 +1,121 @@
+#ifndef XSS_RADIX_SORT
+#define XSS_RADIX_SORT
+
+/*
+ * LSD radix sort for 16-bit integers: two stable counting passes over the
+ * low and the high byte, ping-ponging between arr and a scratch buffer. Its
+ * cost is linear in the array size, and above a few hundred elements it is
+ * faster than the 16-bit quicksort.
+ *
+ * The histograms of both bytes are built in a single read of the array, with
+ * 4 interleaved sets of counters so that consecutive increments of the same
+ * bucket do not wait on each other. A pass whose byte is the same for all the
+ * keys would only copy the array and is skipped. A descending sort flips all
+ * the bits of the keys.
+ */
+
+#include "xss-common-includes.h"
+#include <memory>
+#include <type_traits>
+
+/*
+ * x86simdsort::qsort uses the radix sort for 16-bit arrays of at least this
+ * many elements
+ */
+constexpr arrsize_t xss_radix_sort_threshold = 512;
+
+/*
+ * Maps T to an unsigned integer with the same ordering: the sign bit of
+ * signed types is flipped
+ */
+template <typename T>
+X86_SIMD_SORT_INLINE std::make_unsigned_t<T> radix_key(T val)
+{
+    using U = std::make_unsigned_t<T>;
+    if constexpr (std::is_signed_v<T>) {
+        return (U)((U)val ^ ((U)1 << (8 * sizeof(T) - 1)));
+    }
+    else {
+        return (U)val;
+    }
+}
+
+/*
+ * Stable scatter of src[0, arrsize) into dst by the byte at bit position
+ * shift of the keys; count holds the histogram of that byte. Descending
+ * order uses the keys with all their bits flipped.
+ */
+template <typename T>
+X86_SIMD_SORT_INLINE void radix_scatter_pass(const T *src,
+                                             T *dst,
+                                             arrsize_t arrsize,
+                                             const arrsize_t *count,
+                                             int shift,
+                                             std::make_unsigned_t<T> flip)
+{
+    arrsize_t offset[256];
+    arrsize_t sum = 0;
+    for (int i = 0; i < 256; ++i) {
+        offset[i] = sum;
+        sum += count[i];
+    }
+    for (arrsize_t i = 0; i < arrsize; ++i) {
+        dst[offset[((radix_key(src[i]) ^ flip) >> shift) & 0xFF]++] = src[i];
+    }
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+xss_radix_sort(T *arr, arrsize_t arrsize, bool descending = false)
+{
+    static_assert(sizeof(T) == 2, "radix sort supports 16-bit types only");
+    if (arrsize <= 1) { return; }
+    using U = std::make_unsigned_t<T>;
+    U flip = descending ? (U)~(U)0 : (U)0;
+
+    /* Histograms of the low (0) and high (1) bytes */
+    arrsize_t count[4][2][256] = {};
+    arrsize_t i = 0;
+    for (; i + 4 <= arrsize; i += 4) {
+        X86_SIMD_SORT_UNROLL_LOOP(4)
+        for (int j = 0; j < 4; ++j) {
+            auto key = (U)(radix_key(arr[i + j]) ^ flip);
+            count[j][0][key & 0xFF]++;
+            count[j][1][key >> 8]++;
+        }
+    }
+    for (; i < arrsize; ++i) {
+        auto key = (U)(radix_key(arr[i]) ^ flip);
+        count[0][0][key & 0xFF]++;
+        count[0][1][key >> 8]++;
+    }
+    for (int j = 1; j < 4; ++j) {
+        for (int b = 0; b < 2; ++b) {
+            for (int d = 0; d < 256; ++d) {
+                count[0][b][d] += count[j][b][d];
+            }
+        }
+    }
+
+    /* A byte that is the same for all the keys does not need a pass */
+    auto key0 = (U)(radix_key(arr[0]) ^ flip);
+    bool skip_lo = count[0][0][key0 & 0xFF] == arrsize;
+    bool skip_hi = count[0][1][key0 >> 8] == arrsize;
+    if (skip_lo && skip_hi) { return; }
+
+    std::unique_ptr<T[]> buf(new T[arrsize]);
+    if (skip_lo) {
+        radix_scatter_pass(arr, buf.get(), arrsize, count[0][1], 8, flip);
+        std::copy(buf.get(), buf.get() + arrsize, arr);
+    }
+    else if (skip_hi) {
+        radix_scatter_pass(arr, buf.get(), arrsize, count[0][0], 0, flip);
+        std::copy(buf.get(), buf.get() + arrsize, arr);
+    }
+    else {
+        radix_scatter_pass(arr, buf.get(), arrsize, count[0][0], 0, flip);
+        radix_scatter_pass(buf.get(), arr, arrsize, count[0][1], 8, flip);
+    }
+}
+
+#endif // XSS_RADIX_SORT
@@ -0,0 +1,436 @@
+#ifndef XSS_SIMD_MERGE
+#define XSS_SIMD_MERGE
+
+/*
+ * Vectorized merge of two sorted arrays, based on the bitonic merge of two
+ * sorted registers: with one register reversed, a compare-exchange splits
+ * the 2 * numlanes elements into two bitonic halves which are each sorted by
+ * log2(numlanes) half-cleaner steps. The lower register is written out and
+ * the upper one stays in flight, merged with the next vector read from the
+ * input whose head is the smallest.
+ *
+ * The key-value merge does the same on pairs of registers, with the values
+ * following their keys through the bitonic network of
+ * xss-network-keyvaluesort.hpp.
+ *
+ * Bottom-up merge sorts built on the merges are the bounded worst case
+ * fallback of the quicksorts, for inputs on which the pivots do not split
+ * the array (see qsort_, qselect_, qsort_64bit_ and argsort_64bit_).
+ */
+
+#include "xss-network-qsort.hpp"
+#include "xss-network-keyvaluesort.hpp"
+#include <memory>
+#include <new>
+
+/*
+ * Merges the sorted registers lo and hi: on return lo holds the numlanes
+ * smallest elements and hi the numlanes largest, both sorted.
+ */
+template <typename vtype, typename reg_t = typename vtype::reg_t>
+X86_SIMD_SORT_FINLINE void bitonic_merge_two_vec(reg_t &lo, reg_t &hi)
+{
+    reg_t regs[2] = {lo, vtype::reverse(hi)};
+    COEX<vtype>(regs[0], regs[1]);
+    internal_merge_n_vec<vtype, 2, vtype::numlanes, false>(regs);
+    lo = regs[0];
+    hi = regs[1];
+}
+
+/*
+ * Reads a sorted array one register at a time. The last, partial register is
+ * padded with type_max so that the padding always ends up at the end of the
+ * merged output.
+ */
+template <typename vtype, typename type_t = typename vtype::type_t>
+struct xss_merge_reader {
+    using reg_t = typename vtype::reg_t;
+    static constexpr arrsize_t numlanes = vtype::numlanes;
+
+    const type_t *ptr;
+    arrsize_t left;
+
+    bool empty() const
+    {
+        return left == 0;
+    }
+    type_t head() const
+    {
+        return *ptr;
+    }
+    reg_t next()
+    {
+        if (left >= numlanes) {
+            reg_t v = vtype::loadu(ptr);
+            ptr += numlanes;
+            left -= numlanes;
+            return v;
+        }
+        type_t buf[numlanes];
+        std::fill(buf, buf + numlanes, vtype::type_max());
+        std::copy(ptr, ptr + left, buf);
+        ptr += left;
+        left = 0;
+        return vtype::loadu(buf);
+    }
+};
+
+/*
+ * One merge of two sorted arrays in progress: lo and hi are merged, lo is
+ * written out and hi stays in flight, merged with the next register read.
+ * Each merge depends on the previous one through hi, so a single merge is
+ * bound by the latency of the bitonic network; merge_sorted_ runs two
+ * independent ones side by side.
+ */
+template <typename vtype, typename type_t = typename vtype::type_t>
+struct xss_merge_state {
+    using reg_t = typename vtype::reg_t;
+    static constexpr arrsize_t numlanes = vtype::numlanes;
+
+    xss_merge_reader<vtype> ra, rb;
+    type_t *out;
+    arrsize_t remaining;
+    reg_t lo, hi;
+
+    /* a and b must not be empty */
+    xss_merge_state(const type_t *a,
+                    arrsize_t na,
+                    const type_t *b,
+                    arrsize_t nb,
+                    type_t *dst)
+        : ra {a, na}, rb {b, nb}, out(dst), remaining(na + nb)
+    {
+        lo = ra.next();
+        hi = rb.next();
+    }
+
+    bool can_step() const
+    {
+        return ra.left >= numlanes && rb.left >= numlanes;
+    }
+
+    /*
+     * Writes out numlanes elements while both inputs have a full register
+     * left. Which one is read next is unpredictable on random data, so it is
+     * selected without a branch.
+     */
+    void step()
+    {
+        bitonic_merge_two_vec<vtype>(lo, hi);
+        vtype::storeu(out, lo);
+        out += numlanes;
+        remaining -= numlanes;
+        bool take_a = comparison_func<vtype>(ra.head(), rb.head());
+        lo = vtype::loadu(take_a ? ra.ptr : rb.ptr);
+        arrsize_t step_a = take_a ? numlanes : 0;
+        ra.ptr += step_a;
+        ra.left -= step_a;
+        rb.ptr += numlanes - step_a;
+        rb.left -= numlanes - step_a;
+    }
+
+    void finish()
+    {
+        while (can_step()) {
+            step();
+        }
+        while (true) {
+            bitonic_merge_two_vec<vtype>(lo, hi);
+            if (remaining <= numlanes) { break; }
+            vtype::storeu(out, lo);
+            out += numlanes;
+            remaining -= numlanes;
+            /* Everything left (at most numlanes elements) sits in hi */
+            if (ra.empty() && rb.empty()) {
+                lo = hi;
+                break;
+            }
+            bool take_a = !ra.empty()
+                    && (rb.empty()
+                        || comparison_func<vtype>(ra.head(), rb.head()));
+            lo = take_a ? ra.next() : rb.next();
+        }
+        type_t buf[numlanes];
+        vtype::storeu(buf, lo);
+        std::copy(buf, buf + remaining, out);
+    }
+};
+
+/*
+ * Merge path: returns how many of the first k elements of the merge of a[0,
+ * na) and b[0, nb) come from a, so that the merge can be split into
+ * independent chunks of the output.
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE arrsize_t merge_path_split(const type_t *a,
+                                                arrsize_t na,
+                                                const type_t *b,
+                                                arrsize_t nb,
+                                                arrsize_t k)
+{
+    arrsize_t lo = (k > nb) ? k - nb : 0;
+    arrsize_t hi = std::min(k, na);
+    while (lo < hi) {
+        arrsize_t i = lo + (hi - lo) / 2;
+        if (comparison_func<vtype>(a[i], b[k - i - 1])) { lo = i + 1; }
+        else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+/*
+ * Merges of at least this many registers are split in two halves at the
+ * merge path, which are merged side by side. Only the merge of 64-bit
+ * AVX-512 registers, whose network is a chain of lane permutes, is latency
+ * bound enough to gain from it.
+ */
+constexpr arrsize_t xss_merge_split_regs = 64;
+
+/*
+ * Merges the sorted arrays a[0, na) and b[0, nb) into out[0, na + nb), which
+ * must not overlap with either input. The arrays must not contain NaNs.
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE void merge_sorted_(const type_t *a,
+                                        arrsize_t na,
+                                        const type_t *b,
+                                        arrsize_t nb,
+                                        type_t *out)
+{
+    if (na == 0 || nb == 0) {
+        std::copy(a, a + na, out);
+        std::copy(b, b + nb, out + na);
+        return;
+    }
+    constexpr bool split = sizeof(type_t) == 8 && vtype::numlanes == 8;
+    if (split && na + nb >= xss_merge_split_regs * vtype::numlanes) {
+        arrsize_t half = (na + nb) / 2;
+        arrsize_t ia = merge_path_split<vtype>(a, na, b, nb, half);
+        arrsize_t ib = half - ia;
+        if (ia != 0 && ib != 0 && ia != na && ib != nb) {
+            xss_merge_state<vtype> s1(a, ia, b, ib, out);
+            xss_merge_state<vtype> s2(
+                    a + ia, na - ia, b + ib, nb - ib, out + half);
+            while (s1.can_step() && s2.can_step()) {
+                s1.step();
+                s2.step();
+            }
+            s1.finish();
+            s2.finish();
+            return;
+        }
+    }
+    xss_merge_state<vtype> s(a, na, b, nb, out);
+    s.finish();
+}
+
+/*
+ * Scalar merge of sorted pairs, for the ends of kv_merge_sorted_
+ */
+template <typename vtype1, typename type1_t, typename type2_t>
+X86_SIMD_SORT_INLINE void kv_merge_scalar(const type1_t *ka,
+                                          const type2_t *va,
+                                          arrsize_t na,
+                                          const type1_t *kb,
+                                          const type2_t *vb,
+                                          arrsize_t nb,
+                                          type1_t *kout,
+                                          type2_t *vout)
+{
+    arrsize_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        if (comparison_func<vtype1>(kb[j], ka[i])) {
+            *kout++ = kb[j];
+            *vout++ = vb[j++];
+        }
+        else {
+            *kout++ = ka[i];
+            *vout++ = va[i++];
+        }
+    }
+    std::copy(ka + i, ka + na, kout);
+    std::copy(va + i, va + na, vout);
+    std::copy(kb + j, kb + nb, kout + (na - i));
+    std::copy(vb + j, vb + nb, vout + (na - i));
+}
+
+/*
+ * Merges the sorted pairs (ka, va)[0, na) and (kb, vb)[0, nb) by key into
+ * (kout, vout)[0, na + nb), which must not overlap with either input. The
+ * keys must not contain NaNs.
+ *
+ * Padding a partial register with type_max, as merge_sorted_ does, could
+ * push a real pair with a type_max key out of the output. The merge is
+ * therefore only vectorized while the input to read from has a full register
+ * left; the rest is merged in scalar code.
+ */
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE void kv_merge_sorted_(const type1_t *ka,
+                                           const type2_t *va,
+                                           arrsize_t na,
+                                           const type1_t *kb,
+                                           const type2_t *vb,
+                                           arrsize_t nb,
+                                           type1_t *kout,
+                                           type2_t *vout)
+{
+    using reg_t1 = typename vtype1::reg_t;
+    using reg_t2 = typename vtype2::reg_t;
+    constexpr arrsize_t numlanes = vtype1::numlanes;
+    static_assert(numlanes == vtype2::numlanes,
+                  "invalid pairing of key/value types");
+    if (na < numlanes || nb < numlanes) {
+        kv_merge_scalar<vtype1>(ka, va, na, kb, vb, nb, kout, vout);
+        return;
+    }
+
+    reg_t1 keys[2] = {vtype1::loadu(ka), vtype1::loadu(kb)};
+    reg_t2 vals[2] = {vtype2::loadu(va), vtype2::loadu(vb)};
+    arrsize_t i = numlanes, j = numlanes;
+    bool take_a;
+    while (true) {
+        bitonic_merge_n_vec<vtype1, vtype2, 2>(keys, vals);
+        vtype1::storeu(kout, keys[0]);
+        vtype2::storeu(vout, vals[0]);
+        kout += numlanes;
+        vout += numlanes;
+        take_a = (i < na)
+                && (j == nb || !comparison_func<vtype1>(kb[j], ka[i]));
+        if (take_a ? (na - i < numlanes) : (nb - j < numlanes)) { break; }
+        /* Selected without a branch, see merge_sorted_ */
+        keys[0] = vtype1::loadu(take_a ? ka + i : kb + j);
+        vals[0] = vtype2::loadu(take_a ? va + i : vb + j);
+        arrsize_t step_a = take_a ? numlanes : 0;
+        i += step_a;
+        j += numlanes - step_a;
+    }
+
+    /*
+     * The register in flight is merged with what is left of the input that
+     * ran short, at most 2 * numlanes - 1 pairs, and those with the other
+     * input
+     */
+    type1_t kreg[numlanes], ktail[2 * numlanes];
+    type2_t vreg[numlanes], vtail[2 * numlanes];
+    vtype1::storeu(kreg, keys[1]);
+    vtype2::storeu(vreg, vals[1]);
+    if (!take_a) {
+        std::swap(ka, kb);
+        std::swap(va, vb);
+        std::swap(na, nb);
+        std::swap(i, j);
+    }
+    kv_merge_scalar<vtype1>(
+            kreg, vreg, numlanes, ka + i, va + i, na - i, ktail, vtail);
+    kv_merge_scalar<vtype1>(ktail,
+                            vtail,
+                            numlanes + na - i,
+                            kb + j,
+                            vb + j,
+                            nb - j,
+                            kout,
+                            vout);
+}
+
+/*
+ * Bottom-up merge sort: runs of vtype::network_sort_threshold elements are
+ * sorted with the bitonic networks, then merged pairwise between arr and a
+ * scratch buffer until one run is left. O(n log n) whatever the input, and
+ * vectorized throughout. The array must not contain NaNs. If there is no
+ * memory for the scratch buffer, the array is sorted in place with std::sort
+ * instead.
+ */
+template <typename vtype, typename type_t>
+X86_SIMD_SORT_INLINE void merge_sort_(type_t *arr, arrsize_t arrsize)
+{
+    constexpr arrsize_t run = vtype::network_sort_threshold;
+    std::unique_ptr<type_t[]> buf;
+    if (arrsize > run) {
+        buf.reset(new (std::nothrow) type_t[arrsize]);
+        if (!buf) {
+            std::sort(arr, arr + arrsize, comparison_func<vtype, type_t>);
+            return;
+        }
+    }
+    for (arrsize_t i = 0; i < arrsize; i += run) {
+        sort_n<vtype, vtype::network_sort_threshold>(
+                arr + i, (int32_t)std::min(run, arrsize - i));
+    }
+    if (arrsize <= run) { return; }
+
+    type_t *src = arr, *dst = buf.get();
+    for (arrsize_t width = run; width < arrsize; width *= 2) {
+        for (arrsize_t i = 0; i < arrsize; i += 2 * width) {
+            arrsize_t na = std::min(width, arrsize - i);
+            arrsize_t nb = std::min(width, arrsize - i - na);
+            if (nb == 0
+                || !comparison_func<vtype>(src[i + na], src[i + na - 1])) {
+                /* Already in order */
+                std::copy(src + i, src + i + na + nb, dst + i);
+                continue;
+            }
+            merge_sorted_<vtype>(src + i, na, src + i + na, nb, dst + i);
+        }
+        std::swap(src, dst);
+    }
+    if (src != arr) { std::copy(src, src + arrsize, arr); }
+}
+
+/*
+ * Merges the sorted runs of run pairs that (keys, values)[0, arrsize) is made
+ * of, the last one possibly shorter, into a single sorted run. Returns false,
+ * with the runs left as they are, if there is no memory for the scratch
+ * buffers.
+ */
+template <typename vtype1,
+          typename vtype2,
+          typename type1_t = typename vtype1::type_t,
+          typename type2_t = typename vtype2::type_t>
+X86_SIMD_SORT_INLINE bool kv_merge_runs_(type1_t *keys,
+                                         type2_t *values,
+                                         arrsize_t arrsize,
+                                         arrsize_t run)
+{
+    if (arrsize <= run) { return true; }
+
+    std::unique_ptr<type1_t[]> kbuf(new (std::nothrow) type1_t[arrsize]);
+    std::unique_ptr<type2_t[]> vbuf(new (std::nothrow) type2_t[arrsize]);
+    if (!kbuf || !vbuf) { return false; }
+    type1_t *ksrc = keys, *kdst = kbuf.get();
+    type2_t *vsrc = values, *vdst = vbuf.get();
+    for (arrsize_t width = run; width < arrsize; width *= 2) {
+        for (arrsize_t i = 0; i < arrsize; i += 2 * width) {
+            arrsize_t na = std::min(width, arrsize - i);
+            arrsize_t nb = std::min(width, arrsize - i - na);
+            if (nb == 0
+                || !comparison_func<vtype1>(ksrc[i + na], ksrc[i + na - 1])) {
+                /* Already in order */
+                std::copy(ksrc + i, ksrc + i + na + nb, kdst + i);
+                std::copy(vsrc + i, vsrc + i + na + nb, vdst + i);
+                continue;
+            }
+            kv_merge_sorted_<vtype1, vtype2>(ksrc + i,
+                                             vsrc + i,
+                                             na,
+                                             ksrc + i + na,
+                                             vsrc + i + na,
+                                             nb,
+                                             kdst + i,
+                                             vdst + i);
+        }
+        std::swap(ksrc, kdst);
+        std::swap(vsrc, vdst);
+    }
+    if (ksrc != keys) {
+        std::copy(ksrc, ksrc + arrsize, keys);
+        std::copy(vsrc, vsrc + arrsize, values);
+    }
+    return true;
+}
+
+#endif // XSS_SIMD_MERGE
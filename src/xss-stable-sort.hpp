@@ -0,0 +1,210 @@
+#ifndef XSS_STABLE_SORT
+#define XSS_STABLE_SORT
+
+/*
+ * Stable sorts on the SIMD merge sort of xss-simd-merge.hpp: sorted runs from
+ * the bitonic networks are merged pairwise, so the cost is O(n log n)
+ * whatever the input, like std::stable_sort.
+ *
+ * Neither the networks nor the bitonic merge keep equal keys in order, so
+ * stability is restored afterwards: the argsort starts from the identity
+ * permutation, i.e. every index is the original position of its key, and the
+ * stable order is the one where the indices of equal keys are increasing. One
+ * pass over the sorted keys finds the runs of equal keys and sorts the
+ * indices of each with the quicksort. Key-value sort is the stable argsort of
+ * the keys followed by a gather of the keys and the values.
+ *
+ * Equal keys of a key-only sort are bit-identical except -0.0 and +0.0, whose
+ * order of appearance is recorded before the sort and written back after.
+ * NaNs are moved to the end in all three sorts; like qsort, the key-only sort
+ * does not preserve their bit patterns.
+ */
+
+#include "xss-common-argsort.h"
+
+/*
+ * Sorts the indices of every run of equal keys in arg; keys[i] is the key of
+ * arg[i] and is sorted
+ */
+template <typename argtype, typename type_t>
+X86_SIMD_SORT_INLINE void
+stable_order_ties(const type_t *keys, arrsize_t *arg, arrsize_t arrsize)
+{
+    arrsize_t start = 0;
+    for (arrsize_t i = 1; i <= arrsize; ++i) {
+        if (i < arrsize && keys[i] == keys[start]) { continue; }
+        arrsize_t len = i - start;
+        if (len > 1) {
+            qsort_<argtype, arrsize_t>(
+                    arg, start, i - 1, 2 * (arrsize_t)log2(len));
+        }
+        start = i;
+    }
+}
+
+/*
+ * Stable argsort of arr into arg; keys is a buffer of arrsize elements which
+ * holds the sorted keys on return
+ */
+template <typename vtype, typename argtype, typename T>
+X86_SIMD_SORT_INLINE void xss_stable_argsort(
+        T *arr, arrsize_t *arg, T *keys, arrsize_t arrsize, bool hasnan)
+{
+    /* NaNs go to the end, in their original order */
+    arrsize_t num = arrsize;
+    if constexpr (std::is_floating_point_v<T>) {
+        if (hasnan && array_has_nan<vtype>(arr, arrsize)) {
+            num = 0;
+            for (arrsize_t i = 0; i < arrsize; ++i) {
+                if (!std::isnan(arr[i])) { arg[num++] = i; }
+            }
+            for (arrsize_t i = 0, j = num; i < arrsize; ++i) {
+                if (std::isnan(arr[i])) {
+                    arg[j] = i;
+                    keys[j++] = arr[i];
+                }
+            }
+        }
+        else {
+            std::iota(arg, arg + arrsize, 0);
+        }
+    }
+    else {
+        UNUSED(hasnan);
+        std::iota(arg, arg + arrsize, 0);
+    }
+    argsort_merge_sort_<vtype, argtype>(arr, arg, num, keys);
+    stable_order_ties<argtype>(keys, arg, num);
+}
+
+template <typename vtype, typename argtype, typename T1, typename T2>
+X86_SIMD_SORT_INLINE void
+xss_stable_qsort_kv(T1 *keys, T2 *values, arrsize_t arrsize, bool hasnan)
+{
+    if (arrsize <= 1) { return; }
+    std::vector<arrsize_t> arg(arrsize);
+    std::unique_ptr<T1[]> sorted_keys(new T1[arrsize]);
+    xss_stable_argsort<vtype, argtype>(
+            keys, arg.data(), sorted_keys.get(), arrsize, hasnan);
+    std::unique_ptr<T2[]> sorted_values(new T2[arrsize]);
+    for (arrsize_t i = 0; i < arrsize; ++i) {
+        sorted_values[i] = values[arg[i]];
+    }
+    std::copy(sorted_keys.get(), sorted_keys.get() + arrsize, keys);
+    std::copy(sorted_values.get(), sorted_values.get() + arrsize, values);
+}
+
+template <typename vtype, typename T>
+X86_SIMD_SORT_INLINE void
+xss_stable_qsort(T *arr, arrsize_t arrsize, bool hasnan)
+{
+    if (arrsize <= 1) { return; }
+    if constexpr (std::is_floating_point_v<T>) {
+        /* Signs of the zeros, in input order */
+        std::vector<bool> negzero;
+        for (arrsize_t i = 0; i < arrsize; ++i) {
+            if (arr[i] == 0) { negzero.push_back(std::signbit(arr[i])); }
+        }
+        arrsize_t nan_count = 0;
+        if (UNLIKELY(hasnan)) {
+            nan_count = replace_nan_with_inf<vtype>(arr, arrsize);
+        }
+        merge_sort_<vtype>(arr, arrsize);
+        replace_inf_with_nan(arr, arrsize, nan_count);
+        if (!negzero.empty()) {
+            T *zeros = std::lower_bound(arr, arr + arrsize - nan_count, (T)0);
+            for (arrsize_t i = 0; i < negzero.size(); ++i) {
+                zeros[i] = negzero[i] ? (T)-0.0 : (T)0.0;
+            }
+        }
+    }
+    else {
+        /* Equal integers are indistinguishable */
+        UNUSED(hasnan);
+        merge_sort_<vtype>(arr, arrsize);
+    }
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+avx512_stable_qsort(T *arr, arrsize_t arrsize, bool hasnan = false)
+{
+    xss_stable_qsort<zmm_vector<T>>(arr, arrsize, hasnan);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t>
+avx512_stable_argsort(T *arr, arrsize_t arrsize, bool hasnan = false)
+{
+    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              ymm_vector<T>,
+                                              zmm_vector<T>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      ymm_vector<arrsize_t>,
+                                      zmm_vector<arrsize_t>>::type;
+    std::vector<arrsize_t> arg(arrsize);
+    std::unique_ptr<T[]> keys(new T[arrsize]);
+    xss_stable_argsort<vectype, argtype>(
+            arr, arg.data(), keys.get(), arrsize, hasnan);
+    return arg;
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx512_stable_qsort_kv(T1 *keys,
+                                                 T2 *values,
+                                                 arrsize_t arrsize,
+                                                 bool hasnan = false)
+{
+    using vectype = typename std::conditional<sizeof(T1) == sizeof(int32_t),
+                                              ymm_vector<T1>,
+                                              zmm_vector<T1>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      ymm_vector<arrsize_t>,
+                                      zmm_vector<arrsize_t>>::type;
+    xss_stable_qsort_kv<vectype, argtype>(keys, values, arrsize, hasnan);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE void
+avx2_stable_qsort(T *arr, arrsize_t arrsize, bool hasnan = false)
+{
+    xss_stable_qsort<avx2_vector<T>>(arr, arrsize, hasnan);
+}
+
+template <typename T>
+X86_SIMD_SORT_INLINE std::vector<arrsize_t>
+avx2_stable_argsort(T *arr, arrsize_t arrsize, bool hasnan = false)
+{
+    using vectype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              avx2_half_vector<T>,
+                                              avx2_vector<T>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      avx2_half_vector<arrsize_t>,
+                                      avx2_vector<arrsize_t>>::type;
+    std::vector<arrsize_t> arg(arrsize);
+    std::unique_ptr<T[]> keys(new T[arrsize]);
+    xss_stable_argsort<vectype, argtype>(
+            arr, arg.data(), keys.get(), arrsize, hasnan);
+    return arg;
+}
+
+template <typename T1, typename T2>
+X86_SIMD_SORT_INLINE void avx2_stable_qsort_kv(T1 *keys,
+                                               T2 *values,
+                                               arrsize_t arrsize,
+                                               bool hasnan = false)
+{
+    using vectype = typename std::conditional<sizeof(T1) == sizeof(int32_t),
+                                              avx2_half_vector<T1>,
+                                              avx2_vector<T1>>::type;
+    using argtype =
+            typename std::conditional<sizeof(arrsize_t) == sizeof(int32_t),
+                                      avx2_half_vector<arrsize_t>,
+                                      avx2_vector<arrsize_t>>::type;
+    xss_stable_qsort_kv<vectype, argtype>(keys, values, arrsize, hasnan);
+}
+
+#endif // XSS_STABLE_SORT
@@ -0,0 +1,296 @@
+#ifndef XSS_THREAD_POOL
+#define XSS_THREAD_POOL
+
+/*
+ * A small work-stealing thread pool used by the parallel sorting routines.
+ *
+ * Every participating thread owns a task deque: it pushes and pops tasks at
+ * the back of its own deque (LIFO, which keeps the working set of a quicksort
+ * recursion cache-hot) and steals from the front of the other deques when its
+ * own deque runs dry. Threads that are not part of the pool (i.e. the thread
+ * that created it) push into and help from deque 0. The thread calling wait()
+ * participates in executing tasks until every task submitted so far,
+ * including tasks submitted by other tasks, has finished.
+ *
+ * Tasks are plain function pointers with a void* argument so that the pool
+ * can be driven from C-style interfaces as well; the templated submit()
+ * boxes an arbitrary callable on the heap.
+ *
+ * Worker threads are only started by the first submit(), so creating a pool
+ * for an array that ends up being sorted serially costs nothing. Instead of
+ * its own threads, a pool can also forward all its tasks to an xss_executor
+ * supplied by the caller (see below).
+ *
+ * The pool is defined in an anonymous namespace on purpose: the headers in
+ * this directory get compiled once per target ISA and must not share
+ * (possibly differently vectorized) definitions across translation units.
+ */
+
+#include "xss-common-includes.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/*
+ * An executor owned by the caller, e.g. an application wide thread pool, that
+ * the parallel routines run their tasks on instead of spawning threads:
+ * submit(ctx, func, arg) must eventually run func(arg) on any thread, and
+ * wait(ctx) must block until every task submitted so far, including the tasks
+ * submitted by other tasks, has finished. num_threads is the parallelism to
+ * plan for; 1 makes the routines run serially in the calling thread.
+ *
+ * An executor without a submit function stands for the built-in pool with
+ * num_threads threads (all the hardware threads when num_threads is 0).
+ */
+struct xss_executor {
+    void (*submit)(void *ctx, void (*func)(void *), void *arg);
+    void (*wait)(void *ctx);
+    void *ctx;
+    unsigned num_threads;
+};
+
+/*
+ * Copies an executor of another interface with the same members, e.g.
+ * x86simdsort::executor
+ */
+template <typename executor_t>
+X86_SIMD_SORT_INLINE xss_executor xss_make_executor(const executor_t &e)
+{
+    return {e.submit, e.wait, e.ctx, e.num_threads};
+}
+
+template <typename executor_t>
+X86_SIMD_SORT_INLINE std::vector<xss_executor>
+xss_make_executors(const std::vector<executor_t> &executors)
+{
+    std::vector<xss_executor> result;
+    result.reserve(executors.size());
+    for (const auto &e : executors) {
+        result.push_back(xss_make_executor(e));
+    }
+    return result;
+}
+
+/*
+ * Returns the number of threads to use for a parallel routine: nthreads = 0
+ * means "use all the hardware threads".
+ */
+X86_SIMD_SORT_INLINE unsigned xss_get_num_threads(unsigned nthreads)
+{
+    if (nthreads == 0) {
+        nthreads = std::thread::hardware_concurrency();
+        if (nthreads == 0) { nthreads = 1; }
+    }
+    return nthreads;
+}
+
+namespace {
+
+class xss_thread_pool {
+public:
+    using task_func_t = void (*)(void *);
+
+    explicit xss_thread_pool(unsigned nthreads)
+        : num_queues(nthreads > 0 ? nthreads : 1), pending(0), queued(0)
+    {
+        queues.reserve(num_queues);
+        for (unsigned ii = 0; ii < num_queues; ++ii) {
+            queues.emplace_back(new task_queue);
+        }
+    }
+
+    explicit xss_thread_pool(const xss_executor &executor)
+        : xss_thread_pool(executor.submit == nullptr
+                                  ? xss_get_num_threads(executor.num_threads)
+                                  : 1)
+    {
+        if (executor.submit != nullptr) {
+            num_queues = std::max(executor.num_threads, 1u);
+            external = &executor;
+        }
+    }
+
+    xss_thread_pool(const xss_thread_pool &) = delete;
+    xss_thread_pool &operator=(const xss_thread_pool &) = delete;
+
+    ~xss_thread_pool()
+    {
+        wait();
+        if (workers.empty()) { return; }
+        {
+            std::lock_guard<std::mutex> lk(sleep_lock);
+            stop = true;
+        }
+        sleep_cv.notify_all();
+        for (auto &t : workers) {
+            t.join();
+        }
+    }
+
+    unsigned num_threads() const
+    {
+        return num_queues;
+    }
+
+    void submit(task_func_t func, void *arg)
+    {
+        if (external != nullptr) {
+            external->submit(external->ctx, func, arg);
+            return;
+        }
+        /*
+         * Only the thread owning the pool can submit before the workers
+         * exist, so there is no race on starting them.
+         */
+        if (workers.size() + 1 < num_queues) { start_workers(); }
+        pending.fetch_add(1, std::memory_order_relaxed);
+        unsigned qid = (current_pool == this) ? current_queue : 0;
+        {
+            std::lock_guard<std::mutex> lk(queues[qid]->lock);
+            queues[qid]->tasks.push_back({func, arg});
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        /* Pairs with the predicate check in sleep(): avoids lost wake-ups */
+        { std::lock_guard<std::mutex> lk(sleep_lock); }
+        sleep_cv.notify_one();
+    }
+
+    template <typename Func>
+    void submit(Func &&func)
+    {
+        using func_t = typename std::decay<Func>::type;
+        func_t *boxed = new func_t(std::forward<Func>(func));
+        submit(
+                [](void *arg) {
+                    std::unique_ptr<func_t> f(static_cast<func_t *>(arg));
+                    (*f)();
+                },
+                boxed);
+    }
+
+    /*
+     * Blocks until all the submitted tasks are done, executing tasks in the
+     * calling thread in the meantime.
+     */
+    void wait()
+    {
+        if (external != nullptr) {
+            external->wait(external->ctx);
+            return;
+        }
+        unsigned qid = (current_pool == this) ? current_queue : 0;
+        while (pending.load(std::memory_order_acquire) != 0) {
+            task_t task;
+            if (try_pop(qid, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(sleep_lock);
+            sleep_cv.wait(lk, [this]() {
+                return queued.load(std::memory_order_acquire) != 0
+                        || pending.load(std::memory_order_acquire) == 0;
+            });
+        }
+    }
+
+private:
+    struct task_t {
+        task_func_t func;
+        void *arg;
+    };
+    struct task_queue {
+        std::mutex lock;
+        std::deque<task_t> tasks;
+    };
+
+    void start_workers()
+    {
+        /* The thread owning the pool is the first participant */
+        workers.reserve(num_queues - 1);
+        for (unsigned ii = 1; ii < num_queues; ++ii) {
+            workers.emplace_back([this, ii]() { worker_loop(ii); });
+        }
+    }
+
+    bool try_pop(unsigned qid, task_t &task)
+    {
+        if (queued.load(std::memory_order_acquire) == 0) { return false; }
+        /* Own queue first, newest task */
+        {
+            task_queue &q = *queues[qid];
+            std::lock_guard<std::mutex> lk(q.lock);
+            if (!q.tasks.empty()) {
+                task = q.tasks.back();
+                q.tasks.pop_back();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        /* Steal the oldest (and typically biggest) task of another queue */
+        for (unsigned ii = 1; ii < num_queues; ++ii) {
+            task_queue &q = *queues[(qid + ii) % num_queues];
+            std::lock_guard<std::mutex> lk(q.lock);
+            if (!q.tasks.empty()) {
+                task = q.tasks.front();
+                q.tasks.pop_front();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(const task_t &task)
+    {
+        task.func(task.arg);
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            { std::lock_guard<std::mutex> lk(sleep_lock); }
+            sleep_cv.notify_all();
+        }
+    }
+
+    void worker_loop(unsigned qid)
+    {
+        current_pool = this;
+        current_queue = qid;
+        while (true) {
+            task_t task;
+            if (try_pop(qid, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(sleep_lock);
+            sleep_cv.wait(lk, [this]() {
+                return stop || queued.load(std::memory_order_acquire) != 0;
+            });
+            if (stop) { return; }
+        }
+    }
+
+    unsigned num_queues;
+    std::vector<std::unique_ptr<task_queue>> queues;
+    std::vector<std::thread> workers;
+    /* Tasks submitted but not yet finished */
+    std::atomic<arrsize_t> pending;
+    /* Tasks sitting in one of the queues */
+    std::atomic<arrsize_t> queued;
+    std::mutex sleep_lock;
+    std::condition_variable sleep_cv;
+    bool stop = false;
+    /* Executor that runs the tasks instead of the workers, if any */
+    const xss_executor *external = nullptr;
+
+    static thread_local xss_thread_pool *current_pool;
+    static thread_local unsigned current_queue;
+};
+
+thread_local xss_thread_pool *xss_thread_pool::current_pool = nullptr;
+thread_local unsigned xss_thread_pool::current_queue = 0;
+
+} // namespace
+
+#endif // XSS_THREAD_POOL
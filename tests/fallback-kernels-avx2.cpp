@@ -0,0 +1,39 @@
+#include "avx2-32bit-qsort.hpp"
+#include "avx2-64bit-qsort.hpp"
+#include "avx2-32bit-half.hpp"
+#include "xss-common-argsort.h"
+#include "xss-common-keyvaluesort.hpp"
+#include "fallback-kernels.h"
+
+template <typename T>
+fallback_kernels<T> avx2_fallback_kernels()
+{
+    using vtype = avx2_vector<T>;
+    using vectype = typename avx2_argsort_vtypes<T, size_t>::vectype;
+    using argtype = typename avx2_argsort_vtypes<T, size_t>::argtype;
+    using keytype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              avx2_half_vector<T>,
+                                              avx2_vector<T>>::type;
+    using valtype = avx2_vector<uint64_t>;
+    return {[](T *arr, size_t arrsize, size_t max_iters) {
+                qsort_<vtype>(arr, 0, arrsize - 1, max_iters);
+            },
+            [](T *arr, size_t k, size_t arrsize, size_t max_iters) {
+                qselect_<vtype>(arr, k, 0, arrsize - 1, max_iters);
+            },
+            [](T *arr, size_t *arg, size_t arrsize, size_t max_iters) {
+                argsort_64bit_<vectype, argtype>(
+                        arr, arg, 0, arrsize - 1, max_iters);
+            },
+            [](T *keys, uint64_t *vals, size_t arrsize, size_t max_iters) {
+                qsort_64bit_<keytype, valtype>(
+                        keys, vals, 0, arrsize - 1, max_iters);
+            }};
+}
+
+template fallback_kernels<int32_t> avx2_fallback_kernels();
+template fallback_kernels<uint32_t> avx2_fallback_kernels();
+template fallback_kernels<float> avx2_fallback_kernels();
+template fallback_kernels<int64_t> avx2_fallback_kernels();
+template fallback_kernels<uint64_t> avx2_fallback_kernels();
+template fallback_kernels<double> avx2_fallback_kernels();
@@ -0,0 +1,38 @@
+#include "avx512-32bit-qsort.hpp"
+#include "avx512-64bit-argsort.hpp"
+#include "avx512-64bit-keyvaluesort.hpp"
+#include "avx512-64bit-qsort.hpp"
+#include "fallback-kernels.h"
+
+template <typename T>
+fallback_kernels<T> avx512_fallback_kernels()
+{
+    using vtype = zmm_vector<T>;
+    using vectype = typename avx512_argsort_vtypes<T, size_t>::vectype;
+    using argtype = typename avx512_argsort_vtypes<T, size_t>::argtype;
+    using keytype = typename std::conditional<sizeof(T) == sizeof(int32_t),
+                                              ymm_vector<T>,
+                                              zmm_vector<T>>::type;
+    using valtype = zmm_vector<uint64_t>;
+    return {[](T *arr, size_t arrsize, size_t max_iters) {
+                qsort_<vtype>(arr, 0, arrsize - 1, max_iters);
+            },
+            [](T *arr, size_t k, size_t arrsize, size_t max_iters) {
+                qselect_<vtype>(arr, k, 0, arrsize - 1, max_iters);
+            },
+            [](T *arr, size_t *arg, size_t arrsize, size_t max_iters) {
+                argsort_64bit_<vectype, argtype>(
+                        arr, arg, 0, arrsize - 1, max_iters);
+            },
+            [](T *keys, uint64_t *vals, size_t arrsize, size_t max_iters) {
+                qsort_64bit_<keytype, valtype>(
+                        keys, vals, 0, arrsize - 1, max_iters);
+            }};
+}
+
+template fallback_kernels<int32_t> avx512_fallback_kernels();
+template fallback_kernels<uint32_t> avx512_fallback_kernels();
+template fallback_kernels<float> avx512_fallback_kernels();
+template fallback_kernels<int64_t> avx512_fallback_kernels();
+template fallback_kernels<uint64_t> avx512_fallback_kernels();
+template fallback_kernels<double> avx512_fallback_kernels();
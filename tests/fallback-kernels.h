@@ -0,0 +1,29 @@
+#ifndef XSS_TEST_FALLBACK_KERNELS
+#define XSS_TEST_FALLBACK_KERNELS
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * The quicksort kernels of one ISA called with a recursion budget of
+ * max_iters, so that the tests reach the merge sort they fall back to once
+ * the budget runs out. Compiled for the ISA in fallback-kernels-*.cpp.
+ */
+template <typename T>
+struct fallback_kernels {
+    void (*qsort)(T *arr, size_t arrsize, size_t max_iters);
+    void (*qselect)(T *arr, size_t k, size_t arrsize, size_t max_iters);
+    void (*argsort)(T *arr, size_t *arg, size_t arrsize, size_t max_iters);
+    void (*keyvalue_qsort)(T *keys,
+                           uint64_t *vals,
+                           size_t arrsize,
+                           size_t max_iters);
+};
+
+template <typename T>
+fallback_kernels<T> avx512_fallback_kernels();
+
+template <typename T>
+fallback_kernels<T> avx2_fallback_kernels();
+
+#endif
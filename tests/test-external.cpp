@@ -0,0 +1,140 @@
+#include "test-qsort-common.h"
+#include <cerrno>
+#include <cstdio>
+
+template <typename T>
+class simdexternalsort : public ::testing::Test {
+public:
+    simdexternalsort()
+    {
+        arrtype = {"random",
+                   "constant",
+                   "sorted",
+                   "reverse",
+                   "smallrange",
+                   "rand_max",
+                   "rand_with_nan"};
+        path = testing::TempDir() + "xss-external-"
+                + testing::UnitTest::GetInstance()->current_test_info()->name();
+    }
+    ~simdexternalsort()
+    {
+        std::remove(path.c_str());
+        std::remove((path + ".out").c_str());
+    }
+    void write_file(const std::string &name, const std::vector<T> &arr)
+    {
+        FILE *f = std::fopen(name.c_str(), "wb");
+        ASSERT_NE(f, nullptr);
+        ASSERT_EQ(std::fwrite(arr.data(), sizeof(T), arr.size(), f),
+                  arr.size());
+        std::fclose(f);
+    }
+    std::vector<T> read_file(const std::string &name)
+    {
+        std::vector<T> arr;
+        FILE *f = std::fopen(name.c_str(), "rb");
+        if (f == nullptr) { return arr; }
+        T val;
+        while (std::fread(&val, sizeof(T), 1, f) == 1) {
+            arr.push_back(val);
+        }
+        std::fclose(f);
+        return arr;
+    }
+    std::vector<std::string> arrtype;
+    std::string path;
+};
+
+TYPED_TEST_SUITE_P(simdexternalsort);
+
+TYPED_TEST_P(simdexternalsort, test_external_sort)
+{
+    /* In memory, a few runs merged in several passes, and many runs of a few
+     * elements */
+    std::vector<std::pair<size_t, size_t>> cases = {
+            {0, 4096}, {1000, 1 << 20}, {100000, 1 << 16}, {20000, 4096}};
+    std::string out = this->path + ".out";
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto [size, memory] : cases) {
+            std::vector<TypeParam> arr;
+            if (size > 0) { arr = get_array<TypeParam>(type, size); }
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            this->write_file(this->path, arr);
+            ASSERT_TRUE(x86simdsort::external_sort<TypeParam>(
+                    this->path.c_str(), out.c_str(), memory, NULL, hasnan));
+            IS_SORTED(sortedarr, this->read_file(out), type);
+            /* In place */
+            ASSERT_TRUE(x86simdsort::external_sort<TypeParam>(
+                    this->path.c_str(),
+                    this->path.c_str(),
+                    memory,
+                    testing::TempDir().c_str(),
+                    hasnan));
+            IS_SORTED(sortedarr, this->read_file(this->path), type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdexternalsort, test_external_sort_errors)
+{
+    std::string out = this->path + ".out";
+    EXPECT_FALSE(x86simdsort::external_sort<TypeParam>(
+            (this->path + ".missing").c_str(), out.c_str(), 4096));
+    EXPECT_EQ(errno, ENOENT);
+    /* Not a whole number of elements */
+    FILE *f = std::fopen(this->path.c_str(), "wb");
+    ASSERT_NE(f, nullptr);
+    std::fputc(0, f);
+    std::fclose(f);
+    EXPECT_FALSE(x86simdsort::external_sort<TypeParam>(
+            this->path.c_str(), out.c_str(), 4096));
+    EXPECT_EQ(errno, EINVAL);
+}
+
+TYPED_TEST_P(simdexternalsort, test_mmap_qsort)
+{
+    std::vector<size_t> sizes = {0, 1, 1000, 100000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<TypeParam> arr;
+            if (size > 0) { arr = get_array<TypeParam>(type, size); }
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            this->write_file(this->path, arr);
+            ASSERT_TRUE(x86simdsort::mmap_qsort<TypeParam>(this->path.c_str(),
+                                                           hasnan));
+            IS_SORTED(sortedarr, this->read_file(this->path), type);
+        }
+    }
+    EXPECT_FALSE(x86simdsort::mmap_qsort<TypeParam>(
+            (this->path + ".missing").c_str()));
+    EXPECT_EQ(errno, ENOENT);
+}
+
+REGISTER_TYPED_TEST_SUITE_P(simdexternalsort,
+                            test_external_sort,
+                            test_external_sort_errors,
+                            test_mmap_qsort);
+
+using ExternalSortTestTypes = testing::Types<uint16_t,
+                                             int16_t,
+// support for _Float16 is incomplete in gcc-12
+#if __GNUC__ >= 13
+                                             _Float16,
+#endif
+                                             float,
+                                             double,
+                                             uint32_t,
+                                             int32_t,
+                                             uint64_t,
+                                             int64_t>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdexternalsort, ExternalSortTestTypes);
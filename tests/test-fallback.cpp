@@ -0,0 +1,192 @@
+/*
+ * The merge sort that quicksort falls back to when it runs out of recursion
+ * budget. The "mostly_min" arrays of test-qsort.cpp only get there if the
+ * pivots are bad enough, so the kernels are called here directly with a
+ * budget of 0 (the whole array goes to the merge sort) or of a few levels
+ * (every sub-array left after them does). The merge sort allocates its
+ * scratch buffers with new (std::nothrow); test_no_memory makes those
+ * allocations fail to reach the in-place sorts it falls back to then.
+ */
+
+#include "fallback-kernels.h"
+#include "test-qsort-common.h"
+#include <cstdlib>
+#include <new>
+
+static bool fail_nothrow_new = false;
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    if (fail_nothrow_new) { return nullptr; }
+    return std::malloc(size);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+template <typename T>
+class simdsort_fallback : public ::testing::Test {
+public:
+    simdsort_fallback()
+    {
+        if (!std::getenv("XSS_DISABLE_AVX512")
+            && __builtin_cpu_supports("avx512f")
+            && __builtin_cpu_supports("avx512dq")
+            && __builtin_cpu_supports("avx512vl")) {
+            kernels.push_back(avx512_fallback_kernels<T>());
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            kernels.push_back(avx2_fallback_kernels<T>());
+        }
+    }
+    std::vector<fallback_kernels<T>> kernels;
+    std::vector<std::string> arrtype = {"random",
+                                        "constant",
+                                        "sorted",
+                                        "reverse",
+                                        "smallrange",
+                                        "mostly_min"};
+    std::vector<size_t> arrsize = {1, 10, 100, 1000, 10000, 100000};
+    std::vector<size_t> budgets = {0, 1, 3};
+};
+
+TYPED_TEST_SUITE_P(simdsort_fallback);
+
+TYPED_TEST_P(simdsort_fallback, test_qsort)
+{
+    for (auto &kernel : this->kernels) {
+        for (auto type : this->arrtype) {
+            for (auto size : this->arrsize) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::sort(sortedarr.begin(), sortedarr.end());
+                for (auto budget : this->budgets) {
+                    std::vector<TypeParam> arr_bckp = arr;
+                    kernel.qsort(arr_bckp.data(), size, budget);
+                    IS_SORTED(sortedarr, arr_bckp, type);
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort_fallback, test_qselect)
+{
+    for (auto &kernel : this->kernels) {
+        for (auto type : this->arrtype) {
+            for (auto size : this->arrsize) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::sort(sortedarr.begin(), sortedarr.end());
+                size_t k = size / 3;
+                for (auto budget : this->budgets) {
+                    std::vector<TypeParam> arr_bckp = arr;
+                    kernel.qselect(arr_bckp.data(), k, size, budget);
+                    IS_ARR_PARTITIONED(arr_bckp, k, sortedarr[k], type);
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort_fallback, test_argsort)
+{
+    for (auto &kernel : this->kernels) {
+        for (auto type : this->arrtype) {
+            for (auto size : this->arrsize) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::sort(sortedarr.begin(), sortedarr.end());
+                for (auto budget : this->budgets) {
+                    std::vector<size_t> arg(size);
+                    std::iota(arg.begin(), arg.end(), 0);
+                    kernel.argsort(arr.data(), arg.data(), size, budget);
+                    IS_ARG_SORTED(sortedarr, arr, arg, type);
+                }
+            }
+        }
+    }
+}
+
+/* Sorts keys, checking that the values 0, ..., size - 1 moved with them */
+template <typename T, typename Kernel>
+static void check_keyvalue_qsort(Kernel &kernel,
+                                 std::vector<T> arr,
+                                 std::vector<T> &sortedarr,
+                                 std::string type,
+                                 size_t budget)
+{
+    std::vector<T> keys = arr;
+    std::vector<uint64_t> vals(arr.size());
+    std::iota(vals.begin(), vals.end(), 0);
+    kernel.keyvalue_qsort(keys.data(), vals.data(), keys.size(), budget);
+    IS_SORTED(sortedarr, keys, type);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(keys[i], arr[vals[i]]);
+    }
+}
+
+TYPED_TEST_P(simdsort_fallback, test_keyvalue_qsort)
+{
+    for (auto &kernel : this->kernels) {
+        for (auto type : this->arrtype) {
+            for (auto size : this->arrsize) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::sort(sortedarr.begin(), sortedarr.end());
+                for (auto budget : this->budgets) {
+                    check_keyvalue_qsort(kernel, arr, sortedarr, type, budget);
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort_fallback, test_no_memory)
+{
+    for (auto &kernel : this->kernels) {
+        for (auto type : this->arrtype) {
+            for (auto size : this->arrsize) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::sort(sortedarr.begin(), sortedarr.end());
+                std::vector<TypeParam> sorted = arr, selected = arr;
+                std::vector<TypeParam> keys = arr;
+                std::vector<size_t> arg(size);
+                std::vector<uint64_t> vals(size);
+                std::iota(arg.begin(), arg.end(), 0);
+                std::iota(vals.begin(), vals.end(), 0);
+                size_t k = size / 3;
+
+                fail_nothrow_new = true;
+                kernel.qsort(sorted.data(), size, 0);
+                kernel.qselect(selected.data(), k, size, 0);
+                kernel.argsort(arr.data(), arg.data(), size, 0);
+                kernel.keyvalue_qsort(keys.data(), vals.data(), size, 0);
+                fail_nothrow_new = false;
+
+                IS_SORTED(sortedarr, sorted, type);
+                IS_ARR_PARTITIONED(selected, k, sortedarr[k], type);
+                IS_ARG_SORTED(sortedarr, arr, arg, type);
+                IS_SORTED(sortedarr, keys, type);
+                for (size_t i = 0; i < size; ++i) {
+                    ASSERT_EQ(keys[i], arr[vals[i]]);
+                }
+            }
+        }
+    }
+}
+
+REGISTER_TYPED_TEST_SUITE_P(simdsort_fallback,
+                            test_qsort,
+                            test_qselect,
+                            test_argsort,
+                            test_keyvalue_qsort,
+                            test_no_memory);
+
+using FallbackTestTypes
+        = testing::Types<float, double, uint32_t, int32_t, uint64_t, int64_t>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdsort_fallback, FallbackTestTypes);
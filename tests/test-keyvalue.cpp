@@ -6,6 +6,7 @@
 #include "rand_array.h"
 #include "x86simdsort.h"
 #include "x86simdsort-scalar.h"
+#include <cstdio>
 #include <gtest/gtest.h>
 
 template <typename T>
@@ -21,7 +22,8 @@ public:
                    "smallrange",
                    "max_at_the_end",
                    "random_5d",
-                   "rand_max"};
+                   "rand_max",
+                   "mostly_min"};
     }
     std::vector<std::string> arrtype;
     std::vector<size_t> arrsize = std::vector<size_t>(1024);
@@ -55,7 +57,189 @@ TYPED_TEST_P(simdkvsort, test_kvsort)
     }
 }
 
-REGISTER_TYPED_TEST_SUITE_P(simdkvsort, test_kvsort);
+TYPED_TEST_P(simdkvsort, test_kvsort_descending)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<T1> key = get_array<T1>(type, size);
+            std::vector<T2> val = get_array<T2>(type, size);
+            std::vector<T1> key_bckp = key;
+            std::vector<T2> val_bckp = val;
+            x86simdsort::keyvalue_qsort(
+                    key.data(), val.data(), size, false, true);
+            xss::scalar::keyvalue_qsort(
+                    key_bckp.data(), val_bckp.data(), size, false, true);
+            ASSERT_EQ(key, key_bckp);
+            const bool hasDuplicates
+                    = std::adjacent_find(key.begin(), key.end()) != key.end();
+            if (!hasDuplicates) { ASSERT_EQ(val, val_bckp); }
+        }
+    }
+}
+
+TYPED_TEST_P(simdkvsort, test_kvsort_parallel)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    std::vector<size_t> sizes = {1000, 300000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<T1> key = get_array<T1>(type, size);
+            std::vector<T2> val = get_array<T2>(type, size);
+            std::vector<T1> key_bckp = key;
+            std::vector<T2> val_bckp = val;
+            x86simdsort::keyvalue_qsort_parallel(
+                    key.data(), val.data(), size, hasnan, 4);
+            xss::scalar::keyvalue_qsort(
+                    key_bckp.data(), val_bckp.data(), size, hasnan);
+            ASSERT_EQ(key, key_bckp);
+            const bool hasDuplicates
+                    = std::adjacent_find(key.begin(), key.end()) != key.end();
+            if (!hasDuplicates) { ASSERT_EQ(val, val_bckp); }
+            key.clear();
+            val.clear();
+            key_bckp.clear();
+            val_bckp.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdkvsort, test_stable_kvsort)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            std::vector<T1> key = get_array<T1>(type, size);
+            std::vector<T2> val = get_array<T2>("random", size);
+            std::vector<T1> key_bckp = key;
+            std::vector<T2> val_bckp = val;
+            x86simdsort::stable_keyvalue_qsort(
+                    key.data(), val.data(), size, hasnan);
+            xss::scalar::stable_keyvalue_qsort(
+                    key_bckp.data(), val_bckp.data(), size, hasnan);
+            /* Stable: the values of equal keys are in a unique order */
+            ASSERT_EQ(key, key_bckp);
+            ASSERT_EQ(val, val_bckp);
+            key.clear();
+            val.clear();
+            key_bckp.clear();
+            val_bckp.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdkvsort, test_kvmerge)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            size_t nb = (size * 7) % 1031;
+            std::vector<T1> akey = get_array<T1>(type, size);
+            std::vector<T1> bkey = get_array<T1>(type, nb);
+            std::vector<T2> aval = get_array<T2>("random", size);
+            std::vector<T2> bval = get_array<T2>("random", nb);
+            xss::scalar::keyvalue_qsort(akey.data(), aval.data(), size, false);
+            xss::scalar::keyvalue_qsort(bkey.data(), bval.data(), nb, false);
+            std::vector<T1> key(size + nb), key_bckp(size + nb);
+            std::vector<T2> val(size + nb), val_bckp(size + nb);
+            x86simdsort::keyvalue_merge(akey.data(),
+                                        aval.data(),
+                                        size,
+                                        bkey.data(),
+                                        bval.data(),
+                                        nb,
+                                        key.data(),
+                                        val.data());
+            xss::scalar::keyvalue_merge(akey.data(),
+                                        aval.data(),
+                                        size,
+                                        bkey.data(),
+                                        bval.data(),
+                                        nb,
+                                        key_bckp.data(),
+                                        val_bckp.data());
+            ASSERT_EQ(key, key_bckp);
+            /* Equal keys may come with their values in any order */
+            for (size_t i = 0, j = 0; i < size + nb; i = j) {
+                while (j < size + nb && key[j] == key[i]) {
+                    ++j;
+                }
+                std::sort(val.begin() + i, val.begin() + j);
+                std::sort(val_bckp.begin() + i, val_bckp.begin() + j);
+            }
+            ASSERT_EQ(val, val_bckp);
+        }
+    }
+}
+
+template <typename T>
+static void write_file(const std::string &path, const std::vector<T> &arr)
+{
+    FILE *f = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(f, nullptr);
+    ASSERT_EQ(std::fwrite(arr.data(), sizeof(T), arr.size(), f), arr.size());
+    std::fclose(f);
+}
+
+template <typename T>
+static std::vector<T> read_file(const std::string &path, size_t size)
+{
+    std::vector<T> arr(size);
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (f != nullptr) {
+        arr.resize(std::fread(arr.data(), sizeof(T), size, f));
+        std::fclose(f);
+    }
+    return arr;
+}
+
+TYPED_TEST_P(simdkvsort, test_mmap_kvsort)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    std::string keypath = testing::TempDir() + "xss-mmap-kvsort-keys";
+    std::string valpath = testing::TempDir() + "xss-mmap-kvsort-values";
+    std::vector<size_t> sizes = {1, 1000, 100000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<T1> key = get_array<T1>(type, size);
+            std::vector<T2> val = get_array<T2>(type, size);
+            write_file(keypath, key);
+            write_file(valpath, val);
+            xss::scalar::keyvalue_qsort(key.data(), val.data(), size, hasnan);
+            ASSERT_TRUE((x86simdsort::mmap_keyvalue_qsort<T1, T2>(
+                    keypath.c_str(), valpath.c_str(), hasnan)));
+            ASSERT_EQ(read_file<T1>(keypath, size), key);
+            const bool hasDuplicates
+                    = std::adjacent_find(key.begin(), key.end()) != key.end();
+            if (!hasDuplicates) {
+                ASSERT_EQ(read_file<T2>(valpath, size), val);
+            }
+        }
+    }
+    /* Files of different lengths */
+    write_file(keypath, std::vector<T1>(2));
+    write_file(valpath, std::vector<T2>(3));
+    ASSERT_FALSE((x86simdsort::mmap_keyvalue_qsort<T1, T2>(
+            keypath.c_str(), valpath.c_str())));
+    std::remove(keypath.c_str());
+    std::remove(valpath.c_str());
+}
+
+REGISTER_TYPED_TEST_SUITE_P(simdkvsort,
+                            test_kvsort,
+                            test_kvsort_descending,
+                            test_kvsort_parallel,
+                            test_stable_kvsort,
+                            test_kvmerge,
+                            test_mmap_kvsort);
 
 #define CREATE_TUPLES(type) \
     std::tuple<double, type>, std::tuple<uint64_t, type>, \
@@ -70,3 +254,55 @@ using QKVSortTestTypes = testing::Types<CREATE_TUPLES(double),
                                         CREATE_TUPLES(float)>;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdkvsort, QKVSortTestTypes);
+
+/* 16-bit keys only have the key-value quicksort */
+template <typename T>
+class simdkvsort16bit : public simdkvsort<T> {};
+
+TYPED_TEST_SUITE_P(simdkvsort16bit);
+
+TYPED_TEST_P(simdkvsort16bit, test_kvsort)
+{
+    using T1 = typename std::tuple_element<0, decltype(TypeParam())>::type;
+    using T2 = typename std::tuple_element<1, decltype(TypeParam())>::type;
+    for (bool descending : {false, true}) {
+        for (auto type : this->arrtype) {
+            for (auto size : this->arrsize) {
+                std::vector<T1> key = get_array<T1>(type, size);
+                std::vector<T2> val = get_array<T2>("random", size);
+                std::vector<T1> key_bckp = key;
+                std::vector<T2> val_bckp = val;
+                x86simdsort::keyvalue_qsort(
+                        key.data(), val.data(), size, false, descending);
+                xss::scalar::keyvalue_qsort(key_bckp.data(),
+                                            val_bckp.data(),
+                                            size,
+                                            false,
+                                            descending);
+                ASSERT_EQ(key, key_bckp);
+                /* Equal keys may come with their values in any order */
+                for (size_t i = 0, j = 0; i < size; i = j) {
+                    while (j < size && key[j] == key[i]) {
+                        ++j;
+                    }
+                    std::sort(val.begin() + i, val.begin() + j);
+                    std::sort(val_bckp.begin() + i, val_bckp.begin() + j);
+                }
+                ASSERT_EQ(val, val_bckp);
+            }
+        }
+    }
+}
+
+REGISTER_TYPED_TEST_SUITE_P(simdkvsort16bit, test_kvsort);
+
+#define CREATE_16BIT_TUPLES(type) \
+    std::tuple<type, double>, std::tuple<type, uint64_t>, \
+            std::tuple<type, int64_t>, std::tuple<type, float>, \
+            std::tuple<type, uint32_t>, std::tuple<type, int32_t>, \
+            std::tuple<type, uint16_t>, std::tuple<type, int16_t>
+
+using QKVSort16bitTestTypes = testing::Types<CREATE_16BIT_TUPLES(uint16_t),
+                                             CREATE_16BIT_TUPLES(int16_t)>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdkvsort16bit, QKVSort16bitTestTypes);
@@ -4,6 +4,8 @@
  * *******************************************/
 
 #include "test-qsort-common.h"
+#include <cstring>
+#include <deque>
 
 template <typename T>
 class simdsort : public ::testing::Test {
@@ -19,7 +21,8 @@ public:
                    "max_at_the_end",
                    "random_5d",
                    "rand_max",
-                   "rand_with_nan"};
+                   "rand_with_nan",
+                   "mostly_min"};
     }
     std::vector<std::string> arrtype;
     std::vector<size_t> arrsize = std::vector<size_t>(1024);
@@ -45,6 +48,154 @@ TYPED_TEST_P(simdsort, test_qsort)
     }
 }
 
+TYPED_TEST_P(simdsort, test_qsort_parallel)
+{
+    /* Sizes on both sides of the cutoff for spawning parallel tasks */
+    std::vector<size_t> sizes = {1000, 100000, 1000000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            x86simdsort::qsort_parallel(arr.data(), arr.size(), hasnan, 4);
+            IS_SORTED(sortedarr, arr, type);
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_qsort_numa_parallel)
+{
+    /*
+     * Asking for more domains than there are NUMA nodes exercises the local
+     * sorts and the merge rounds (1 round for 2 domains, 2 for 3) on any
+     * machine
+     */
+    std::vector<size_t> sizes = {1000, 1000000};
+    std::vector<unsigned> ndomains = {0, 2, 3};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            for (auto nd : ndomains) {
+                std::vector<TypeParam> arr_bckp = arr;
+                x86simdsort::qsort_numa_parallel(
+                        arr_bckp.data(), arr_bckp.size(), hasnan, 4, nd);
+                IS_SORTED(sortedarr, arr_bckp, type);
+            }
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_radix_qsort)
+{
+    if constexpr (std::is_integral_v<TypeParam> && sizeof(TypeParam) >= 4) {
+        /* The largest size needs a second radix pass on random data */
+        std::vector<size_t> sizes = {1000, 100000, 5000000};
+        for (auto type : this->arrtype) {
+            for (auto size : sizes) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::sort(sortedarr.begin(), sortedarr.end());
+                x86simdsort::radix_qsort(arr.data(), arr.size());
+                IS_SORTED(sortedarr, arr, type);
+            }
+        }
+    }
+}
+
+/*
+ * Executor of the caller that defers all the tasks to wait(), which runs them
+ * on the calling thread: the library must not spawn any thread of its own.
+ */
+struct deferred_executor {
+    std::deque<std::pair<void (*)(void *), void *>> tasks;
+
+    x86simdsort::executor get(unsigned nthreads)
+    {
+        auto submit = [](void *ctx, void (*func)(void *), void *arg) {
+            auto self = static_cast<deferred_executor *>(ctx);
+            self->tasks.emplace_back(func, arg);
+        };
+        auto wait = [](void *ctx) {
+            auto self = static_cast<deferred_executor *>(ctx);
+            while (!self->tasks.empty()) {
+                auto task = self->tasks.front();
+                self->tasks.pop_front();
+                task.first(task.second);
+            }
+        };
+        return {submit, wait, this, nthreads};
+    }
+};
+
+TYPED_TEST_P(simdsort, test_qsort_executor)
+{
+    std::vector<size_t> sizes = {1000, 300000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            deferred_executor exec;
+            auto arg = x86simdsort::argsort_parallel(
+                    arr.data(), arr.size(), hasnan, exec.get(4));
+            IS_ARG_SORTED(sortedarr, arr, arg, type);
+            x86simdsort::qsort_parallel(
+                    arr.data(), arr.size(), hasnan, exec.get(4));
+            IS_SORTED(sortedarr, arr, type);
+            ASSERT_TRUE(exec.tasks.empty());
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_qsort_numa_executor)
+{
+    /* One deferred executor per domain: 2 domains, then 3 */
+    std::vector<size_t> sizes = {1000, 1000000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            for (size_t nd : {2, 3}) {
+                std::vector<deferred_executor> domains(nd);
+                std::vector<x86simdsort::executor> execs;
+                for (auto &d : domains) {
+                    execs.push_back(d.get(2));
+                }
+                std::vector<TypeParam> arr_bckp = arr;
+                x86simdsort::qsort_numa_parallel(
+                        arr_bckp.data(), arr_bckp.size(), hasnan, execs);
+                IS_SORTED(sortedarr, arr_bckp, type);
+                for (auto &d : domains) {
+                    ASSERT_TRUE(d.tasks.empty());
+                }
+            }
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_argsort)
 {
     for (auto type : this->arrtype) {
@@ -63,6 +214,248 @@ TYPED_TEST_P(simdsort, test_argsort)
     }
 }
 
+TYPED_TEST_P(simdsort, test_qsort_descending)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            /* NaNs come first in descending order */
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::greater<TypeParam>>());
+            x86simdsort::qsort(arr.data(), arr.size(), hasnan, true);
+            IS_SORTED(sortedarr, arr, type);
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argsort_descending)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::greater<TypeParam>>());
+            auto arg = x86simdsort::argsort(
+                    arr.data(), arr.size(), hasnan, true);
+            IS_ARG_SORTED(sortedarr, arr, arg, type);
+            arr.clear();
+            arg.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argsort_into)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::vector<size_t> arg(size);
+            x86simdsort::argsort(arr.data(), arg.data(), size, hasnan);
+            IS_ARG_SORTED(sortedarr, arr, arg, type);
+            /* Only the elements at the odd indices */
+            std::vector<size_t> subarg, subsorted;
+            std::vector<TypeParam> subarr;
+            for (size_t i = 1; i < size; i += 2) {
+                subarg.push_back(i);
+                subarr.push_back(arr[i]);
+            }
+            std::sort(subarr.begin(),
+                      subarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            x86simdsort::argsort(arr.data(),
+                                 subarg.data(),
+                                 subarg.size(),
+                                 hasnan,
+                                 false,
+                                 false);
+            std::vector<TypeParam> subresult;
+            for (auto ii : subarg) {
+                ASSERT_EQ(ii % 2, 1);
+                subresult.push_back(arr[ii]);
+            }
+            IS_SORTED(subarr, subresult, type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argsort_uint32)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::vector<uint32_t> arg(size);
+            x86simdsort::argsort(arr.data(), arg.data(), size, hasnan);
+            IS_ARG_SORTED(sortedarr,
+                          arr,
+                          std::vector<size_t>(arg.begin(), arg.end()),
+                          type);
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::greater<TypeParam>>());
+            x86simdsort::argsort(arr.data(), arg.data(), size, hasnan, true);
+            IS_ARG_SORTED(sortedarr,
+                          arr,
+                          std::vector<size_t>(arg.begin(), arg.end()),
+                          type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argsort_parallel)
+{
+    std::vector<size_t> sizes = {1000, 300000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            auto arg = x86simdsort::argsort_parallel(
+                    arr.data(), arr.size(), hasnan, 4);
+            IS_ARG_SORTED(sortedarr, arr, arg, type);
+            arr.clear();
+            arg.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_stable_qsort)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::stable_sort(sortedarr.begin(),
+                             sortedarr.end(),
+                             compare<TypeParam, std::less<TypeParam>>());
+            x86simdsort::stable_qsort(arr.data(), arr.size(), hasnan);
+            IS_SORTED(sortedarr, arr, type);
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+    /* -0.0 and +0.0 compare equal and must keep their order */
+    if constexpr (xss::fp::is_floating_point_v<TypeParam>) {
+        for (auto size : {10, 100, 1000, 10000}) {
+            std::vector<TypeParam> arr;
+            for (int i = 0; i < size; ++i) {
+                int r = rand() % 4;
+                arr.push_back(r == 0 ? (TypeParam)-0.0
+                                     : (r == 1 ? (TypeParam)0.0
+                                               : (TypeParam)(rand() % 8 - 4)));
+            }
+            std::vector<TypeParam> sortedarr = arr;
+            std::stable_sort(sortedarr.begin(), sortedarr.end());
+            x86simdsort::stable_qsort(arr.data(), arr.size());
+            IS_SORTED(sortedarr, arr, "signed_zeros");
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_stable_argsort)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<size_t> expected(size);
+            std::iota(expected.begin(), expected.end(), 0);
+            std::stable_sort(
+                    expected.begin(),
+                    expected.end(),
+                    compare_arg<TypeParam, std::less<TypeParam>>(arr.data()));
+            auto arg = x86simdsort::stable_argsort(
+                    arr.data(), arr.size(), hasnan);
+            if (arg != expected) {
+                REPORT_FAIL("Argsort not stable", size, type, -1);
+            }
+            arr.clear();
+            arg.clear();
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_merge)
+{
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            /* Two sorted inputs of different sizes, NaNs at their ends */
+            size_t nb = (size * 7) % 1031;
+            std::vector<TypeParam> a = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> b = get_array<TypeParam>(type, nb);
+            std::sort(a.begin(),
+                      a.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::sort(b.begin(),
+                      b.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::vector<TypeParam> sortedarr = a;
+            sortedarr.insert(sortedarr.end(), b.begin(), b.end());
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::vector<TypeParam> out(size + nb);
+            x86simdsort::merge(a.data(), size, b.data(), nb, out.data());
+            IS_SORTED(sortedarr, out, type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_kway_merge)
+{
+    /* Also large enough for the merge tree to refill its buffers */
+    this->arrsize.push_back(100000);
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            /* k sorted runs of random sizes, some of them empty */
+            size_t k = 1 + size % 257;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<size_t> cuts = {0, size};
+            for (size_t i = 1; i < k; ++i) {
+                cuts.push_back(rand() % (size + 1));
+            }
+            std::sort(cuts.begin(), cuts.end());
+            std::vector<const TypeParam *> runs;
+            std::vector<size_t> sizes;
+            for (size_t i = 0; i < k; ++i) {
+                std::sort(arr.begin() + cuts[i],
+                          arr.begin() + cuts[i + 1],
+                          compare<TypeParam, std::less<TypeParam>>());
+                runs.push_back(arr.data() + cuts[i]);
+                sizes.push_back(cuts[i + 1] - cuts[i]);
+            }
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::vector<TypeParam> out(size);
+            x86simdsort::kway_merge(runs.data(), sizes.data(), k, out.data());
+            IS_SORTED(sortedarr, out, type);
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_qselect)
 {
     for (auto type : this->arrtype) {
@@ -83,6 +476,50 @@ TYPED_TEST_P(simdsort, test_qselect)
     }
 }
 
+TYPED_TEST_P(simdsort, test_qselect_parallel)
+{
+    /* Sizes on both sides of the cutoff for the parallel partition */
+    std::vector<size_t> sizes = {1000, 100000, 1000000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            for (size_t k : {(size_t)0, (size_t)rand() % size, size - 1}) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::nth_element(sortedarr.begin(),
+                                 sortedarr.begin() + k,
+                                 sortedarr.end(),
+                                 compare<TypeParam, std::less<TypeParam>>());
+                x86simdsort::qselect_parallel(
+                        arr.data(), k, arr.size(), hasnan, 4);
+                IS_ARR_PARTITIONED(arr, k, sortedarr[k], type);
+                arr.clear();
+                sortedarr.clear();
+            }
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_qselect_descending)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            size_t k = rand() % size;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::nth_element(sortedarr.begin(),
+                             sortedarr.begin() + k,
+                             sortedarr.end(),
+                             compare<TypeParam, std::greater<TypeParam>>());
+            x86simdsort::qselect(arr.data(), k, arr.size(), hasnan, true);
+            IS_ARR_PARTITIONED(arr, k, sortedarr[k], type, true);
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_argselect)
 {
     for (auto type : this->arrtype) {
@@ -103,6 +540,68 @@ TYPED_TEST_P(simdsort, test_argselect)
     }
 }
 
+TYPED_TEST_P(simdsort, test_argselect_into)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            size_t k = rand() % size;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::vector<size_t> arg(size);
+            x86simdsort::argselect(arr.data(), arg.data(), k, size, hasnan);
+            IS_ARG_PARTITIONED(arr, arg, sortedarr[k], k, type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argselect_uint32)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            size_t k = rand() % size;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::less<TypeParam>>());
+            std::vector<uint32_t> arg(size);
+            x86simdsort::argselect(arr.data(), arg.data(), k, size, hasnan);
+            IS_ARG_PARTITIONED(arr,
+                               std::vector<size_t>(arg.begin(), arg.end()),
+                               sortedarr[k],
+                               k,
+                               type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort, test_argselect_parallel)
+{
+    std::vector<size_t> sizes = {1000, 300000};
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : sizes) {
+            for (size_t k : {(size_t)0, (size_t)rand() % size, size - 1}) {
+                std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+                std::vector<TypeParam> sortedarr = arr;
+                std::sort(sortedarr.begin(),
+                          sortedarr.end(),
+                          compare<TypeParam, std::less<TypeParam>>());
+                auto arg = x86simdsort::argselect_parallel(
+                        arr.data(), k, arr.size(), hasnan, 4);
+                IS_ARG_PARTITIONED(arr, arg, sortedarr[k], k, type);
+                arr.clear();
+                sortedarr.clear();
+            }
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_partial_qsort)
 {
     for (auto type : this->arrtype) {
@@ -123,6 +622,26 @@ TYPED_TEST_P(simdsort, test_partial_qsort)
     }
 }
 
+TYPED_TEST_P(simdsort, test_partial_qsort_descending)
+{
+    for (auto type : this->arrtype) {
+        bool hasnan = (type == "rand_with_nan") ? true : false;
+        for (auto size : this->arrsize) {
+            size_t k = std::max((size_t)1, rand() % size);
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      compare<TypeParam, std::greater<TypeParam>>());
+            x86simdsort::partial_qsort(
+                    arr.data(), k, arr.size(), hasnan, true);
+            IS_ARR_PARTIALSORTED(arr, k, sortedarr, type);
+            arr.clear();
+            sortedarr.clear();
+        }
+    }
+}
+
 TYPED_TEST_P(simdsort, test_comparator)
 {
     if constexpr (xss::fp::is_floating_point_v<TypeParam>) {
@@ -158,10 +677,30 @@ TYPED_TEST_P(simdsort, test_comparator)
 
 REGISTER_TYPED_TEST_SUITE_P(simdsort,
                             test_qsort,
+                            test_qsort_descending,
+                            test_qsort_parallel,
+                            test_qsort_executor,
+                            test_qsort_numa_parallel,
+                            test_qsort_numa_executor,
+                            test_radix_qsort,
                             test_argsort,
+                            test_argsort_descending,
+                            test_argsort_into,
+                            test_argsort_uint32,
+                            test_argsort_parallel,
+                            test_stable_qsort,
+                            test_stable_argsort,
+                            test_merge,
+                            test_kway_merge,
                             test_argselect,
+                            test_argselect_into,
+                            test_argselect_uint32,
+                            test_argselect_parallel,
                             test_qselect,
+                            test_qselect_descending,
+                            test_qselect_parallel,
                             test_partial_qsort,
+                            test_partial_qsort_descending,
                             test_comparator);
 
 using QSortTestTypes = testing::Types<uint16_t,
@@ -178,3 +717,387 @@ using QSortTestTypes = testing::Types<uint16_t,
                                       int64_t>;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdsort, QSortTestTypes);
+
+/*
+ * 8-bit types only have qsort, qselect and partial_qsort
+ */
+template <typename T>
+class simdsort8bit : public simdsort<T> {
+};
+
+TYPED_TEST_SUITE_P(simdsort8bit);
+
+TYPED_TEST_P(simdsort8bit, test_qsort)
+{
+    /* Also large enough for every value to be present */
+    this->arrsize.push_back(100000);
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(), sortedarr.end());
+            x86simdsort::qsort(arr.data(), arr.size());
+            IS_SORTED(sortedarr, arr, type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort8bit, test_qselect)
+{
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            size_t k = rand() % size;
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::nth_element(
+                    sortedarr.begin(), sortedarr.begin() + k, sortedarr.end());
+            x86simdsort::qselect(arr.data(), k, arr.size());
+            IS_ARR_PARTITIONED(arr, k, sortedarr[k], type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort8bit, test_partial_qsort)
+{
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            size_t k = std::max((size_t)1, rand() % size);
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(), sortedarr.end());
+            x86simdsort::partial_qsort(arr.data(), k, arr.size());
+            IS_ARR_PARTIALSORTED(arr, k, sortedarr, type);
+        }
+    }
+}
+
+TYPED_TEST_P(simdsort8bit, test_qsort_descending)
+{
+    this->arrsize.push_back(100000);
+    for (auto type : this->arrtype) {
+        for (auto size : this->arrsize) {
+            std::vector<TypeParam> arr = get_array<TypeParam>(type, size);
+            std::vector<TypeParam> sortedarr = arr;
+            std::sort(sortedarr.begin(),
+                      sortedarr.end(),
+                      std::greater<TypeParam>());
+            x86simdsort::qsort(arr.data(), arr.size(), false, true);
+            IS_SORTED(sortedarr, arr, type);
+        }
+    }
+}
+
+REGISTER_TYPED_TEST_SUITE_P(simdsort8bit,
+                            test_qsort,
+                            test_qsort_descending,
+                            test_qselect,
+                            test_partial_qsort);
+
+using QSort8bitTestTypes = testing::Types<uint8_t, int8_t>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(xss, simdsort8bit, QSort8bitTestTypes);
+
+/*
+ * bfloat16 is checked through the int16_t of the same order, in which every
+ * NaN is INT16_MAX: sorting may change the bits of a NaN
+ */
+class simdsortbf16 : public ::testing::Test {
+public:
+    simdsortbf16()
+    {
+        std::iota(arrsize.begin(), arrsize.end(), 1);
+        arrsize.push_back(10000);
+    }
+    static int16_t key(x86simdsort::bfloat16 x)
+    {
+        if ((x.bits & 0x7fff) > 0x7f80) {
+            return std::numeric_limits<int16_t>::max();
+        }
+        return (int16_t)((x.bits & 0x8000) ? (x.bits ^ 0x7fff) : x.bits);
+    }
+    static std::vector<int16_t>
+    keys(const std::vector<x86simdsort::bfloat16> &arr)
+    {
+        std::vector<int16_t> out;
+        for (auto x : arr) {
+            out.push_back(key(x));
+        }
+        return out;
+    }
+    /* Random floats with zeros, infinities and NaNs of both signs */
+    static std::vector<x86simdsort::bfloat16> get_bf16_array(size_t size)
+    {
+        const float special[] = {0.0f,
+                                 -0.0f,
+                                 std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity(),
+                                 std::numeric_limits<float>::quiet_NaN(),
+                                 -std::numeric_limits<float>::quiet_NaN()};
+        std::vector<float> values
+                = get_uniform_rand_array<float>(size, 1000.0f, -1000.0f);
+        std::vector<x86simdsort::bfloat16> arr;
+        for (auto value : values) {
+            if (rand() % 8 == 0) { value = special[rand() % 6]; }
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            arr.push_back({(uint16_t)(bits >> 16)});
+        }
+        return arr;
+    }
+    static std::vector<int16_t> sorted_keys(
+            const std::vector<x86simdsort::bfloat16> &arr, bool descending)
+    {
+        std::vector<int16_t> sorted = keys(arr);
+        if (descending) {
+            std::sort(sorted.begin(), sorted.end(), std::greater<int16_t>());
+        }
+        else {
+            std::sort(sorted.begin(), sorted.end());
+        }
+        return sorted;
+    }
+    std::vector<size_t> arrsize = std::vector<size_t>(1024);
+};
+
+TEST_F(simdsortbf16, test_qsort)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            auto arr = get_bf16_array(size);
+            std::vector<int16_t> sorted = sorted_keys(arr, descending);
+            x86simdsort::qsort(arr.data(), size, true, descending);
+            ASSERT_EQ(keys(arr), sorted) << "size = " << size;
+        }
+    }
+}
+
+TEST_F(simdsortbf16, test_qselect)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            size_t k = rand() % size;
+            auto arr = get_bf16_array(size);
+            std::vector<int16_t> sorted = sorted_keys(arr, descending);
+            x86simdsort::qselect(arr.data(), k, size, true, descending);
+            std::vector<int16_t> result = keys(arr);
+            ASSERT_EQ(result[k], sorted[k]) << "size = " << size;
+            /* The parts on both sides of k only hold the right keys */
+            if (descending) {
+                std::sort(result.begin(),
+                          result.begin() + k,
+                          std::greater<int16_t>());
+                std::sort(result.begin() + k + 1,
+                          result.end(),
+                          std::greater<int16_t>());
+            }
+            else {
+                std::sort(result.begin(), result.begin() + k);
+                std::sort(result.begin() + k + 1, result.end());
+            }
+            ASSERT_EQ(result, sorted) << "size = " << size << ", k = " << k;
+        }
+    }
+}
+
+TEST_F(simdsortbf16, test_partial_qsort)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            size_t k = std::max((size_t)1, rand() % size);
+            auto arr = get_bf16_array(size);
+            std::vector<int16_t> sorted = sorted_keys(arr, descending);
+            x86simdsort::partial_qsort(
+                    arr.data(), k, size, true, descending);
+            std::vector<int16_t> result = keys(arr);
+            ASSERT_TRUE(std::equal(sorted.begin(),
+                                   sorted.begin() + k,
+                                   result.begin()))
+                    << "size = " << size << ", k = " << k;
+        }
+    }
+}
+
+TEST_F(simdsortbf16, test_argsort)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            auto arr = get_bf16_array(size);
+            auto arr_bkp = arr;
+            std::vector<int16_t> sorted = sorted_keys(arr, descending);
+            std::vector<size_t> arg
+                    = x86simdsort::argsort(arr.data(), size, true, descending);
+            std::vector<uint32_t> arg32(size);
+            x86simdsort::argsort(
+                    arr.data(), arg32.data(), size, true, descending);
+            ASSERT_EQ(std::memcmp(arr.data(), arr_bkp.data(), size * 2), 0)
+                    << "argsort modified the array";
+            EXPECT_UNIQUE(arg)
+            std::vector<int16_t> result, result32;
+            for (size_t ii = 0; ii < size; ++ii) {
+                result.push_back(key(arr[arg[ii]]));
+                result32.push_back(key(arr[arg32[ii]]));
+            }
+            ASSERT_EQ(result, sorted) << "size = " << size;
+            ASSERT_EQ(result32, sorted) << "size = " << size;
+        }
+    }
+}
+
+TEST_F(simdsortbf16, test_argselect)
+{
+    for (auto size : this->arrsize) {
+        size_t k = rand() % size;
+        auto arr = get_bf16_array(size);
+        std::vector<int16_t> sorted = sorted_keys(arr, false);
+        std::vector<size_t> arg
+                = x86simdsort::argselect(arr.data(), k, size, true);
+        EXPECT_UNIQUE(arg)
+        std::vector<int16_t> result;
+        for (auto ii : arg) {
+            result.push_back(key(arr[ii]));
+        }
+        ASSERT_EQ(result[k], sorted[k]) << "size = " << size;
+        std::sort(result.begin(), result.begin() + k);
+        std::sort(result.begin() + k + 1, result.end());
+        ASSERT_EQ(result, sorted) << "size = " << size << ", k = " << k;
+    }
+}
+
+/*
+ * uint128 keys with few distinct hi words, so that most compares are decided
+ * by the lo words, and duplicates, zeros and all ones
+ */
+class simdsortuint128 : public ::testing::Test {
+public:
+    simdsortuint128()
+    {
+        std::iota(arrsize.begin(), arrsize.end(), 1);
+        arrsize.push_back(10000);
+    }
+    static std::vector<x86simdsort::uint128> get_uint128_array(size_t size)
+    {
+        const x86simdsort::uint128 special[] = {{0, 0},
+                                                {UINT64_MAX, 0},
+                                                {0, UINT64_MAX},
+                                                {UINT64_MAX, UINT64_MAX}};
+        std::vector<x86simdsort::uint128> arr;
+        for (size_t ii = 0; ii < size; ++ii) {
+            uint64_t lo = ((uint64_t)rand() << 32) | (uint64_t)rand();
+            uint64_t hi = (uint64_t)(rand() % 4) << 62;
+            if (rand() % 8 == 0) { lo %= 4; }
+            arr.push_back({lo, hi});
+            if (rand() % 16 == 0) { arr.back() = special[rand() % 4]; }
+        }
+        return arr;
+    }
+    static std::vector<x86simdsort::uint128>
+    sorted(std::vector<x86simdsort::uint128> arr, bool descending)
+    {
+        if (descending) {
+            std::sort(arr.begin(),
+                      arr.end(),
+                      std::greater<x86simdsort::uint128>());
+        }
+        else {
+            std::sort(arr.begin(), arr.end());
+        }
+        return arr;
+    }
+    std::vector<size_t> arrsize = std::vector<size_t>(1024);
+};
+
+TEST_F(simdsortuint128, test_qsort)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            auto arr = get_uint128_array(size);
+            auto sortedarr = sorted(arr, descending);
+            x86simdsort::qsort(arr.data(), size, false, descending);
+            ASSERT_TRUE(arr == sortedarr) << "size = " << size;
+        }
+    }
+}
+
+TEST_F(simdsortuint128, test_qselect)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            size_t k = rand() % size;
+            auto arr = get_uint128_array(size);
+            auto sortedarr = sorted(arr, descending);
+            x86simdsort::qselect(arr.data(), k, size, false, descending);
+            ASSERT_TRUE(arr[k] == sortedarr[k]) << "size = " << size;
+            /* The parts on both sides of k only hold the right keys */
+            std::sort(arr.begin(), arr.begin() + k);
+            std::sort(arr.begin() + k + 1, arr.end());
+            if (descending) {
+                std::reverse(arr.begin(), arr.begin() + k);
+                std::reverse(arr.begin() + k + 1, arr.end());
+            }
+            ASSERT_TRUE(arr == sortedarr)
+                    << "size = " << size << ", k = " << k;
+        }
+    }
+}
+
+TEST_F(simdsortuint128, test_partial_qsort)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            size_t k = std::max((size_t)1, rand() % size);
+            auto arr = get_uint128_array(size);
+            auto sortedarr = sorted(arr, descending);
+            x86simdsort::partial_qsort(
+                    arr.data(), k, size, false, descending);
+            ASSERT_TRUE(std::equal(
+                    sortedarr.begin(), sortedarr.begin() + k, arr.begin()))
+                    << "size = " << size << ", k = " << k;
+        }
+    }
+}
+
+TEST_F(simdsortuint128, test_argsort)
+{
+    for (bool descending : {false, true}) {
+        for (auto size : this->arrsize) {
+            auto arr = get_uint128_array(size);
+            auto arr_bkp = arr;
+            auto sortedarr = sorted(arr, descending);
+            std::vector<size_t> arg = x86simdsort::argsort(
+                    arr.data(), size, false, descending);
+            std::vector<uint32_t> arg32(size);
+            x86simdsort::argsort(
+                    arr.data(), arg32.data(), size, false, descending);
+            ASSERT_TRUE(arr == arr_bkp) << "argsort modified the array";
+            EXPECT_UNIQUE(arg)
+            std::vector<x86simdsort::uint128> result, result32;
+            for (size_t ii = 0; ii < size; ++ii) {
+                result.push_back(arr[arg[ii]]);
+                result32.push_back(arr[arg32[ii]]);
+            }
+            ASSERT_TRUE(result == sortedarr) << "size = " << size;
+            ASSERT_TRUE(result32 == sortedarr) << "size = " << size;
+        }
+    }
+}
+
+TEST_F(simdsortuint128, test_argselect)
+{
+    for (auto size : this->arrsize) {
+        size_t k = rand() % size;
+        auto arr = get_uint128_array(size);
+        auto sortedarr = sorted(arr, false);
+        std::vector<size_t> arg
+                = x86simdsort::argselect(arr.data(), k, size, false);
+        EXPECT_UNIQUE(arg)
+        std::vector<x86simdsort::uint128> result;
+        for (auto ii : arg) {
+            result.push_back(arr[ii]);
+        }
+        ASSERT_TRUE(result[k] == sortedarr[k]) << "size = " << size;
+        std::sort(result.begin(), result.begin() + k);
+        std::sort(result.begin() + k + 1, result.end());
+        ASSERT_TRUE(result == sortedarr)
+                << "size = " << size << ", k = " << k;
+    }
+}
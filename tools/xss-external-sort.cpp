@@ -0,0 +1,81 @@
+/*
+ * Sorts a binary file of fixed width keys which may not fit in memory:
+ *
+ *   xss-external-sort <type> <input> <output> [memory MiB] [tmpdir]
+ *
+ * type is one of uint16, int16, uint32, int32, float, uint64, int64 or
+ * double; the keys are in native byte order. The memory budget defaults to
+ * 1024 MiB, and the temporary files go to tmpdir or else $TMPDIR or /tmp.
+ */
+
+#include "x86simdsort.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+template <typename T>
+static bool sort_file(const char *input,
+                      const char *output,
+                      size_t memory_bytes,
+                      const char *tmpdir)
+{
+    /* Keys are not assumed to be free of NaNs */
+    bool hasnan = std::is_floating_point_v<T>;
+    return x86simdsort::external_sort<T>(
+            input, output, memory_bytes, tmpdir, hasnan);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4 || argc > 6) {
+        std::fprintf(stderr,
+                     "usage: %s <type> <input> <output> [memory MiB] "
+                     "[tmpdir]\n",
+                     argv[0]);
+        return 2;
+    }
+    std::string type = argv[1];
+    const char *input = argv[2];
+    const char *output = argv[3];
+    size_t memory_bytes = (size_t)1024 << 20;
+    if (argc > 4) { memory_bytes = std::strtoull(argv[4], NULL, 10) << 20; }
+    const char *tmpdir = (argc > 5) ? argv[5] : NULL;
+
+    bool ok;
+    if (type == "uint16") {
+        ok = sort_file<uint16_t>(input, output, memory_bytes, tmpdir);
+    }
+    else if (type == "int16") {
+        ok = sort_file<int16_t>(input, output, memory_bytes, tmpdir);
+    }
+    else if (type == "uint32") {
+        ok = sort_file<uint32_t>(input, output, memory_bytes, tmpdir);
+    }
+    else if (type == "int32") {
+        ok = sort_file<int32_t>(input, output, memory_bytes, tmpdir);
+    }
+    else if (type == "float") {
+        ok = sort_file<float>(input, output, memory_bytes, tmpdir);
+    }
+    else if (type == "uint64") {
+        ok = sort_file<uint64_t>(input, output, memory_bytes, tmpdir);
+    }
+    else if (type == "int64") {
+        ok = sort_file<int64_t>(input, output, memory_bytes, tmpdir);
+    }
+    else if (type == "double") {
+        ok = sort_file<double>(input, output, memory_bytes, tmpdir);
+    }
+    else {
+        std::fprintf(stderr, "unknown type %s\n", type.c_str());
+        return 2;
+    }
+    if (!ok) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], std::strerror(errno));
+        return 1;
+    }
+    return 0;
+}
@@ -44,9 +44,11 @@ static std::vector<T> get_uniform_rand_array(int64_t arrsize,
 #ifndef XSS_DO_NOT_SET_SEED
         e1.seed(42);
 #endif
-        std::uniform_int_distribution<T> uniform_dist(min, max);
+        /* uniform_int_distribution does not take 8-bit types */
+        using dist_t = std::conditional_t<sizeof(T) == 1, int, T>;
+        std::uniform_int_distribution<dist_t> uniform_dist(min, max);
         for (int64_t ii = 0; ii < arrsize; ++ii) {
-            arr.emplace_back(uniform_dist(e1));
+            arr.emplace_back((T)uniform_dist(e1));
         }
     }
     return arr;
@@ -111,6 +113,17 @@ static std::vector<T> get_array(std::string arrtype,
             arr[arrsize - 1] = std::numeric_limits<T>::max();
         }
     }
+    else if (arrtype == "mostly_min") {
+        /*
+         * Quicksort killer: the pivot sampled from the array is its minimum,
+         * so partitioning does not split the array
+         */
+        arr = get_uniform_rand_array<T>(arrsize, max, min);
+        T minval = *std::min_element(arr.begin(), arr.end());
+        for (size_t ii = 0; ii < arrsize; ++ii) {
+            if (ii % 8 != 0) { arr[ii] = minval; }
+        }
+    }
     else if (arrtype == "rand_with_nan") {
         arr = get_uniform_rand_array<T>(arrsize, max, min);
         int64_t num_nans = 10 % arrsize;